@@ -0,0 +1,288 @@
+#pragma once
+#ifndef AF_PACKET_CAPTURE_SOURCE_H
+#define AF_PACKET_CAPTURE_SOURCE_H
+
+#ifdef __linux__
+
+#include "CaptureSource.h"
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <unistd.h>
+
+namespace WareHound {
+
+// AF_PACKET CAPTURE SOURCE - Linux TPACKET_V3 memory-mapped receive ring
+//
+// The kernel fills whole blocks of frames and hands each block over by
+// setting TP_STATUS_USER; frames are passed to the handler as pointers into
+// the mapping, so the parser and FlowTracker read them without a copy. A
+// block goes back to the kernel once its last frame has been handled.
+// Reads never block: the capturer polls the socket fd, which turns readable
+// when a block is retired (full, or after blockTimeoutMs).
+class AfPacketCaptureSource : public ICaptureSource {
+public:
+    struct Options {
+        std::string interfaceName;            // empty captures on all interfaces
+        uint32_t blockSize = 1u << 22;        // 4 MB, multiple of the page size
+        uint32_t blockCount = 64;
+        uint32_t frameSize = 2048;            // TPACKET_ALIGNMENT multiple
+        uint32_t blockTimeoutMs = 10;         // retire partially filled blocks
+        uint32_t snaplen = 0;                 // bytes kept per frame, 0 keeps all
+        bool promiscuous = true;
+    };
+
+    explicit AfPacketCaptureSource(const Options& options)
+        : options_(options), fd_(-1), map_(nullptr), mapSize_(0), ifindex_(0),
+          current_(0), frame_(nullptr), framesLeft_(0), releasePending_(false)
+    {
+        error_[0] = '\0';
+        fd_ = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+        if (fd_ < 0) {
+            Fail("socket(AF_PACKET)");
+        }
+
+        int version = TPACKET_V3;
+        if (setsockopt(fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+            Fail("PACKET_VERSION");
+        }
+
+        struct tpacket_req3 req;
+        memset(&req, 0, sizeof(req));
+        req.tp_block_size = options_.blockSize;
+        req.tp_block_nr = options_.blockCount;
+        req.tp_frame_size = options_.frameSize;
+        req.tp_frame_nr = (options_.blockSize / options_.frameSize) * options_.blockCount;
+        req.tp_retire_blk_tov = options_.blockTimeoutMs;
+        if (setsockopt(fd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+            Fail("PACKET_RX_RING");
+        }
+
+        mapSize_ = static_cast<size_t>(options_.blockSize) * options_.blockCount;
+        void* map = mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (map == MAP_FAILED) {
+            Fail("mmap");
+        }
+        map_ = static_cast<uint8_t*>(map);
+
+        blocks_.resize(options_.blockCount);
+        for (uint32_t i = 0; i < options_.blockCount; i++) {
+            blocks_[i] = reinterpret_cast<tpacket_block_desc*>(map_ + static_cast<size_t>(i) * options_.blockSize);
+        }
+
+        if (!options_.interfaceName.empty()) {
+            ifindex_ = static_cast<int>(if_nametoindex(options_.interfaceName.c_str()));
+            if (ifindex_ == 0) {
+                Fail(("if_nametoindex(" + options_.interfaceName + ")").c_str());
+            }
+        }
+
+        struct sockaddr_ll addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sll_family = AF_PACKET;
+        addr.sll_protocol = htons(ETH_P_ALL);
+        addr.sll_ifindex = ifindex_;
+        if (bind(fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+            Fail("bind");
+        }
+
+        if (options_.promiscuous && ifindex_ != 0) {
+            struct packet_mreq mreq;
+            memset(&mreq, 0, sizeof(mreq));
+            mreq.mr_ifindex = ifindex_;
+            mreq.mr_type = PACKET_MR_PROMISC;
+            setsockopt(fd_, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
+        }
+
+        // Truncation is the accept-all program's return value
+        if (options_.snaplen > 0 && !SetFilter("")) {
+            Fail("snaplen filter");
+        }
+    }
+
+    ~AfPacketCaptureSource() override {
+        Close();
+    }
+
+    AfPacketCaptureSource(const AfPacketCaptureSource&) = delete;
+    AfPacketCaptureSource& operator=(const AfPacketCaptureSource&) = delete;
+
+    int Dispatch(int maxPackets, pcap_handler handler, u_char* user) override {
+        int count = 0;
+        struct pcap_pkthdr header;
+        const u_char* data = nullptr;
+        while (maxPackets <= 0 || count < maxPackets) {
+            if (!NextFrame(&header, &data)) {
+                break;
+            }
+            handler(user, &header, data);
+            ++count;
+        }
+        // The handler is done with every frame, so a finished block can go back now
+        ReleasePending();
+        return count;
+    }
+
+    int Next(struct pcap_pkthdr** header, const u_char** data) override {
+        if (!NextFrame(&nextHeader_, data)) {
+            return 0;
+        }
+        *header = &nextHeader_;
+        return 1;
+    }
+
+    bool IsOffline() const override { return false; }
+    bool NanosecondTimestamps() const override { return true; }
+    bool SetNonBlocking(bool) override { return true; }
+    int GetSelectableFd() override { return fd_; }
+
+    bool GetStats(CaptureSourceStats& stats) override {
+        // The kernel resets these counters on every read
+        struct tpacket_stats_v3 ks;
+        socklen_t len = sizeof(ks);
+        if (getsockopt(fd_, SOL_PACKET, PACKET_STATISTICS, &ks, &len) < 0) {
+            return false;
+        }
+        received_ += ks.tp_packets;
+        dropped_ += ks.tp_drops;
+        stats.received = received_;
+        stats.dropped = dropped_;
+        return true;
+    }
+
+    // SO_ATTACH_FILTER swaps the program atomically in the kernel; frames
+    // already sitting in retired blocks were matched by the old one. The
+    // program's accept value doubles as the snaplen.
+    bool SetFilter(const std::string& expression) override {
+        if (expression.empty() && options_.snaplen == 0) {
+            int unused = 0;
+            setsockopt(fd_, SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused));
+            return true;
+        }
+
+        uint32_t snaplen = options_.snaplen > 0 ? options_.snaplen : options_.frameSize;
+        pcap_t* dead = pcap_open_dead(DLT_EN10MB, static_cast<int>(snaplen));
+        if (!dead) {
+            snprintf(error_, sizeof(error_), "pcap_open_dead failed");
+            return false;
+        }
+        struct bpf_program program;
+        if (pcap_compile(dead, &program, expression.c_str(), 1, PCAP_NETMASK_UNKNOWN) == -1) {
+            snprintf(error_, sizeof(error_), "%s", pcap_geterr(dead));
+            pcap_close(dead);
+            return false;
+        }
+
+        // bpf_insn and sock_filter share one layout
+        struct sock_fprog fprog;
+        fprog.len = static_cast<unsigned short>(program.bf_len);
+        fprog.filter = reinterpret_cast<struct sock_filter*>(program.bf_insns);
+        bool installed = setsockopt(fd_, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) == 0;
+        if (!installed) {
+            snprintf(error_, sizeof(error_), "SO_ATTACH_FILTER: %s", strerror(errno));
+        }
+        pcap_freecode(&program);
+        pcap_close(dead);
+        return installed;
+    }
+
+    const char* GetError() override { return error_; }
+
+private:
+    // Advance to the next frame, handing a finished block back first
+    bool NextFrame(struct pcap_pkthdr* header, const u_char** data) {
+        ReleasePending();
+
+        if (frame_ == nullptr) {
+            tpacket_block_desc* block = blocks_[current_];
+            if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+                return false;
+            }
+            framesLeft_ = block->hdr.bh1.num_pkts;
+            if (framesLeft_ == 0) {
+                ReleaseBlock();
+                return false;
+            }
+            frame_ = reinterpret_cast<tpacket3_hdr*>(reinterpret_cast<uint8_t*>(block) +
+                                                     block->hdr.bh1.offset_to_first_pkt);
+        }
+
+        header->ts.tv_sec = frame_->tp_sec;
+        header->ts.tv_usec = frame_->tp_nsec;
+        header->caplen = frame_->tp_snaplen;
+        header->len = frame_->tp_len;
+        *data = reinterpret_cast<const u_char*>(frame_) + frame_->tp_mac;
+
+        if (--framesLeft_ == 0) {
+            // Last frame of the block: release once the caller is done with it
+            releasePending_ = true;
+        } else {
+            frame_ = reinterpret_cast<tpacket3_hdr*>(reinterpret_cast<uint8_t*>(frame_) + frame_->tp_next_offset);
+        }
+        return true;
+    }
+
+    void ReleasePending() {
+        if (releasePending_) {
+            releasePending_ = false;
+            ReleaseBlock();
+        }
+    }
+
+    void ReleaseBlock() {
+        __atomic_store_n(&blocks_[current_]->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        current_ = (current_ + 1) % options_.blockCount;
+        frame_ = nullptr;
+    }
+
+    [[noreturn]] void Fail(const char* what) {
+        snprintf(error_, sizeof(error_), "%s: %s", what, strerror(errno));
+        std::string message = error_;
+        Close();
+        throw std::runtime_error("AF_PACKET " + message);
+    }
+
+    void Close() {
+        if (map_) {
+            munmap(map_, mapSize_);
+            map_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    Options options_;
+    int fd_;
+    uint8_t* map_;
+    size_t mapSize_;
+    int ifindex_;
+    std::vector<tpacket_block_desc*> blocks_;
+
+    // Reader position (capture thread only)
+    uint32_t current_;
+    tpacket3_hdr* frame_;
+    uint32_t framesLeft_;
+    bool releasePending_;
+    struct pcap_pkthdr nextHeader_;
+
+    uint64_t received_ = 0;
+    uint64_t dropped_ = 0;
+    char error_[256];
+};
+
+} // namespace WareHound
+
+#endif // __linux__
+
+#endif // AF_PACKET_CAPTURE_SOURCE_H
@@ -0,0 +1,116 @@
+#pragma once
+#ifndef CAPTURE_SOURCE_H
+#define CAPTURE_SOURCE_H
+
+#include <pcap.h>
+#include <cstdint>
+#include <string>
+
+namespace WareHound {
+
+// Receive counters reported by the backend (kernel side where available)
+struct CaptureSourceStats {
+    uint64_t received = 0;
+    uint64_t dropped = 0;
+    // received counts frames before the BPF filter ran (Npcap), rather than
+    // only those it accepted (Linux), so filtered traffic can be derived
+    bool receivedBeforeFilter = false;
+};
+
+// CAPTURE SOURCE - Where PacketCapturer reads frames from
+// Return values follow libpcap: Dispatch returns the number of packets
+// handled, 0 if none were ready (or EOF for offline sources), or a negative
+// PCAP_ERROR* code. Next returns 1, 0 on timeout, PCAP_ERROR_BREAK at EOF,
+// or PCAP_ERROR. Packet pointers are only valid inside the callback (or
+// until the next call to Next).
+class ICaptureSource {
+public:
+    virtual ~ICaptureSource() = default;
+
+    virtual int Dispatch(int maxPackets, pcap_handler handler, u_char* user) = 0;
+    virtual int Next(struct pcap_pkthdr** header, const u_char** data) = 0;
+
+    // Reads from a savefile rather than a live interface
+    virtual bool IsOffline() const = 0;
+    // ts.tv_usec of delivered headers holds nanoseconds, as with
+    // PCAP_TSTAMP_PRECISION_NANO
+    virtual bool NanosecondTimestamps() const = 0;
+    // Non-blocking reads let the capturer park on the selectable fd/event
+    virtual bool SetNonBlocking(bool enable) = 0;
+#ifdef _WIN32
+    virtual HANDLE GetEvent() = 0;
+#else
+    virtual int GetSelectableFd() = 0;
+#endif
+    virtual bool GetStats(CaptureSourceStats& stats) = 0;
+    // Compiles and installs a kernel BPF filter; an empty expression accepts
+    // everything. Not safe against a concurrent Dispatch/Next.
+    virtual bool SetFilter(const std::string& expression) = 0;
+    virtual const char* GetError() = 0;
+};
+
+// PCAP CAPTURE SOURCE - libpcap/Npcap handle (not owned)
+class PcapCaptureSource : public ICaptureSource {
+public:
+    PcapCaptureSource(pcap_t* handle, bool offline)
+        : handle_(handle), offline_(offline),
+          nano_(pcap_get_tstamp_precision(handle) == PCAP_TSTAMP_PRECISION_NANO) {}
+
+    int Dispatch(int maxPackets, pcap_handler handler, u_char* user) override {
+        return pcap_dispatch(handle_, maxPackets, handler, user);
+    }
+
+    int Next(struct pcap_pkthdr** header, const u_char** data) override {
+        return pcap_next_ex(handle_, header, data);
+    }
+
+    bool IsOffline() const override { return offline_; }
+    bool NanosecondTimestamps() const override { return nano_; }
+
+    bool SetNonBlocking(bool enable) override {
+        char nbErrbuf[PCAP_ERRBUF_SIZE];
+        return pcap_setnonblock(handle_, enable ? 1 : 0, nbErrbuf) == 0;
+    }
+
+#ifdef _WIN32
+    HANDLE GetEvent() override { return pcap_getevent(handle_); }
+#else
+    int GetSelectableFd() override { return pcap_get_selectable_fd(handle_); }
+#endif
+
+    bool GetStats(CaptureSourceStats& stats) override {
+        struct pcap_stat ps;
+        if (offline_ || pcap_stats(handle_, &ps) != 0) {
+            return false;
+        }
+        stats.received = ps.ps_recv;
+        stats.dropped = static_cast<uint64_t>(ps.ps_drop) + ps.ps_ifdrop;
+#ifdef _WIN32
+        stats.receivedBeforeFilter = true;
+#endif
+        return true;
+    }
+
+    bool SetFilter(const std::string& expression) override {
+        struct bpf_program program;
+        if (pcap_compile(handle_, &program, expression.c_str(), 1, PCAP_NETMASK_UNKNOWN) == -1) {
+            return false;
+        }
+        bool installed = pcap_setfilter(handle_, &program) == 0;
+        pcap_freecode(&program);
+        return installed;
+    }
+
+    const char* GetError() override { return pcap_geterr(handle_); }
+
+    pcap_t* GetHandle() const { return handle_; }
+
+private:
+    pcap_t* handle_;
+    bool offline_;
+    bool nano_;
+};
+
+} // namespace WareHound
+
+#endif // CAPTURE_SOURCE_H
@@ -3,6 +3,7 @@
 #define FLOW_TABLE_H
 
 #include "PacketParser.h"
+#include "TcpReassembler.h"
 #include <unordered_map>
 #include <mutex>
 #include <shared_mutex>
@@ -11,12 +12,15 @@
 #include <iostream>
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <cstddef>
 
 namespace WareHound {
 
-struct FlowStats {
-    uint64_t first_seen_us = 0;
-    uint64_t last_seen_us = 0;
+// Fields written on every packet come first and share one cache line
+struct alignas(64) FlowStats {
+    // Nanoseconds since the epoch
+    uint64_t last_seen_ns = 0;
     
     // Packet counts
     uint64_t packets_to_server = 0;
@@ -27,13 +31,11 @@ struct FlowStats {
     uint64_t bytes_to_client = 0;
     
     // TCP state
-    TcpState tcp_state = TcpState::CLOSED;
-    uint32_t tcp_seq_client = 0;
-    uint32_t tcp_seq_server = 0;
     uint32_t tcp_ack_client = 0;
     uint32_t tcp_ack_server = 0;
     uint16_t tcp_window_client = 0;
     uint16_t tcp_window_server = 0;
+    TcpState tcp_state = TcpState::CLOSED;
     
     // TCP flags seen
     bool has_syn = false;
@@ -45,11 +47,67 @@ struct FlowStats {
     AppProtocol app_protocol = AppProtocol::UNKNOWN;
     uint8_t app_confidence = 0;
     
+    // Set once per flow
+    uint64_t first_seen_ns = 0;
+    uint32_t tcp_seq_client = 0;
+    uint32_t tcp_seq_server = 0;
+    
     // Total packets and bytes
     uint64_t TotalPackets() const { return packets_to_server + packets_to_client; }
     uint64_t TotalBytes() const { return bytes_to_server + bytes_to_client; }
 };
 
+static_assert(offsetof(FlowStats, app_confidence) < 64, "per-packet FlowStats fields must fit one cache line");
+
+
+// FLOW TIMEOUTS - Idle time before a flow expires, by what it is doing
+enum class FlowTimeoutClass : uint8_t {
+    TCP_HANDSHAKE,     // SYN seen, not yet established
+    TCP_ESTABLISHED,   // Also TCP picked up mid-connection
+    TCP_CLOSING,       // One side sent FIN
+    TCP_CLOSED,        // Reset, or both sides finished
+    UDP,
+    OTHER,
+    COUNT
+};
+
+struct FlowTimeouts {
+    uint64_t tcp_handshake_ns = 60 * 1000000000ULL;
+    uint64_t tcp_established_ns = 300 * 1000000000ULL;  // 5 minutes
+    uint64_t tcp_closing_ns = 60 * 1000000000ULL;
+    uint64_t tcp_closed_ns = 10 * 1000000000ULL;
+    uint64_t udp_ns = 120 * 1000000000ULL;
+    uint64_t other_ns = 60 * 1000000000ULL;
+    
+    uint64_t For(FlowTimeoutClass timeout_class) const {
+        switch (timeout_class) {
+            case FlowTimeoutClass::TCP_HANDSHAKE: return tcp_handshake_ns;
+            case FlowTimeoutClass::TCP_ESTABLISHED: return tcp_established_ns;
+            case FlowTimeoutClass::TCP_CLOSING: return tcp_closing_ns;
+            case FlowTimeoutClass::TCP_CLOSED: return tcp_closed_ns;
+            case FlowTimeoutClass::UDP: return udp_ns;
+            default: return other_ns;
+        }
+    }
+};
+
+// FLOW EVICTION - What gives way when a new flow finds the table full.
+// The victim is the first by the policy among a small sample of the flows
+// in the new flow's stripe.
+enum class FlowEvictionPolicy : uint8_t {
+    NONE,              // Refuse the new flow until cleanup makes room
+    LEAST_RECENT,      // Longest idle
+    CLOSED_FIRST,      // Closed, then closing, then half-open; longest idle among equals
+    SMALLEST_FIRST     // Fewest bytes; longest idle among equals
+};
+
+// Why a flow left the table, for the remove callback
+enum class FlowRemoveReason : uint8_t {
+    EXPIRED,
+    EVICTED,
+    CLEARED
+};
+
 
 // FLOW ENTRY - Single flow in the table
 struct FlowEntry {
@@ -57,11 +115,15 @@ struct FlowEntry {
     FlowStats stats;
     bool active = true;
     
-    // Payload collection (optional)
-    bool payload_collection_enabled = false;
-    size_t payload_max_size = 65536;
-    std::vector<uint8_t> payload_to_server;
-    std::vector<uint8_t> payload_to_client;
+    // Stream reassembly (optional); buffers belong to the tracker's TcpReassembler
+    TcpStream stream_to_server;
+    TcpStream stream_to_client;
+    
+    // Expiry wheel position, owned by FlowTable
+    uint64_t expiry_tick = 0;
+    uint32_t expiry_prev = 0;
+    uint32_t expiry_next = 0;
+    FlowTimeoutClass expiry_class = FlowTimeoutClass::OTHER;
     
     FlowEntry() = default;
     explicit FlowEntry(const FlowKey& k) : key(k) {}
@@ -71,146 +133,314 @@ struct FlowEntry {
         return pkt_key.src_ip == key.src_ip && pkt_key.src_port == key.src_port;
     }
     
-    // Append payload data
-    void AppendPayload(const uint8_t* data, uint16_t len, bool to_server) {
-        if (!payload_collection_enabled || data == nullptr || len == 0) return;
-        
-        auto& buffer = to_server ? payload_to_server : payload_to_client;
-        size_t remaining = payload_max_size - buffer.size();
-        size_t to_copy = (std::min)(static_cast<size_t>(len), remaining);
-        
-        if (to_copy > 0) {
-            buffer.insert(buffer.end(), data, data + to_copy);
+    FlowTimeoutClass TimeoutClass() const {
+        if (key.protocol == IPPROTO_UDP) return FlowTimeoutClass::UDP;
+        if (key.protocol != IPPROTO_TCP) return FlowTimeoutClass::OTHER;
+        switch (stats.tcp_state) {
+            case TcpState::SYN_SENT:
+            case TcpState::SYN_RCVD:
+                return FlowTimeoutClass::TCP_HANDSHAKE;
+            case TcpState::FIN_WAIT_1:
+            case TcpState::FIN_WAIT_2:
+            case TcpState::CLOSE_WAIT:
+            case TcpState::CLOSING:
+            case TcpState::LAST_ACK:
+                return FlowTimeoutClass::TCP_CLOSING;
+            case TcpState::TIME_WAIT:
+                return FlowTimeoutClass::TCP_CLOSED;
+            case TcpState::CLOSED:
+                // Without a FIN or RST, a flow picked up mid-connection
+                return stats.has_fin || stats.has_rst ? FlowTimeoutClass::TCP_CLOSED : FlowTimeoutClass::TCP_ESTABLISHED;
+            default:
+                return FlowTimeoutClass::TCP_ESTABLISHED;
         }
     }
 };
 
 // FLOW TABLE - Hash table for storing flows
+// Split into lock stripes by key hash, each an independent table with its
+// own shared_mutex, so a scan holds one stripe at a time and stalls only
+// writers that land in it. Within a stripe: open addressing with Robin Hood
+// probing over 8-byte slots, each holding a 32-bit hash and the index of its
+// entry. A probe reads only slots until a hash matches, so misses never
+// touch entries. Entries live in fixed blocks that never move: a FlowEntry*
+// stays valid until that flow is removed. Erasing shifts the following
+// slots back rather than leaving tombstones.
+// Expiry: each stripe has a hashed timing wheel of one-second buckets. A
+// flow is filed under the tick after its deadline (last seen + its class's
+// timeout). Packets do not move it; when its tick comes round it is removed
+// if still idle, or filed again under its new deadline, so a pass costs the
+// flows due rather than the table size. A change of timeout class refiles at
+// once, so a reset flow leaves on the short timeout.
+// When full, a new flow evicts one chosen by the eviction policy from a
+// sample of its stripe, so a flood of new flows cannot lock out the rest.
 class FlowTable {
 public:
     static constexpr size_t DEFAULT_TABLE_SIZE = 65536;
     static constexpr size_t DEFAULT_MAX_FLOWS = 100000;
+    static constexpr size_t DEFAULT_STRIPES = 16;
+    static constexpr size_t ENTRIES_PER_BLOCK = 1024;
+    static constexpr size_t EVICTION_SAMPLE = 8;
     
-    FlowTable(size_t table_size = DEFAULT_TABLE_SIZE, size_t max_flows = DEFAULT_MAX_FLOWS)
-        : max_flows_(max_flows)
+    // table_size: flows to hold before the slot arrays first grow
+    // stripes: rounded up to a power of two
+    FlowTable(size_t table_size = DEFAULT_TABLE_SIZE, size_t max_flows = DEFAULT_MAX_FLOWS,
+              size_t stripes = DEFAULT_STRIPES)
+        : max_flows_((std::min)(max_flows, static_cast<size_t>(UINT32_MAX - 1)))
+        , stripe_count_(1)
         , flow_count_(0)
         , total_lookups_(0)
         , total_insertions_(0)
+        , total_expired_(0)
+        , total_evicted_(0)
+        , total_rejected_(0)
+        , eviction_policy_(FlowEvictionPolicy::LEAST_RECENT)
     {
-        flows_.reserve(table_size);
+        while (stripe_count_ < stripes && stripe_count_ < 256) {
+            stripe_count_ *= 2;
+        }
+        stripes_.reset(new Stripe[stripe_count_]);
+        size_t per_stripe = (std::min)(table_size, max_flows_) / stripe_count_;
+        for (size_t i = 0; i < stripe_count_; i++) {
+            stripes_[i].Reserve(per_stripe);
+        }
     }
     
-    // LOOKUP OR CREATE - Find existing flow or create new one
-    FlowEntry* LookupOrCreate(const FlowKey& key, uint64_t timestamp_us, bool* created = nullptr) {
-        std::unique_lock<std::shared_mutex> lock(mutex_);  // Exclusive lock for write
-        total_lookups_++;
+    FlowTable(const FlowTable&) = delete;
+    FlowTable& operator=(const FlowTable&) = delete;
+    
+    // UPDATE - Find or create the flow and run update(FlowEntry&, bool created)
+    // under its stripe's lock, so readers never see a half-applied packet.
+    // update must not call back into the table. nullptr when full and
+    // nothing could be evicted.
+    template<typename Fn>
+    FlowEntry* Update(const FlowKey& key, uint64_t timestamp_ns, Fn&& update) {
+        uint32_t hash = static_cast<uint32_t>(FlowKeyHash()(key));
+        Stripe& stripe = StripeFor(hash);
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex);  // Exclusive lock for write
+        total_lookups_.fetch_add(1, std::memory_order_relaxed);
         
-        auto it = flows_.find(key);
-        if (it != flows_.end()) {
-            if (created) *created = false;
-            return &it->second;
+        size_t pos = stripe.Find(key, hash);
+        if (pos != Stripe::NOT_FOUND) {
+            uint32_t id = stripe.slots[pos].entry;
+            FlowEntry& entry = stripe.Entry(id);
+            update(entry, false);
+            FlowTimeoutClass timeout_class = entry.TimeoutClass();
+            if (timeout_class != entry.expiry_class) {
+                stripe.Unschedule(id);
+                stripe.Schedule(id, timeout_class, Deadline(entry, timeout_class));
+            }
+            return &entry;
         }
         
-        // Check capacity
-        if (flows_.size() >= max_flows_) {
-            if (created) *created = false;
+        // Check capacity; the count is shared by all stripes
+        if (flow_count_.fetch_add(1, std::memory_order_relaxed) >= max_flows_ && !Evict(stripe)) {
+            flow_count_.fetch_sub(1, std::memory_order_relaxed);
+            total_rejected_.fetch_add(1, std::memory_order_relaxed);
             return nullptr;
         }
         
         // Create new flow
-        FlowEntry entry(key);
-        entry.stats.first_seen_us = timestamp_us;
-        entry.stats.last_seen_us = timestamp_us;
-        
-        auto result = flows_.emplace(key, std::move(entry));
-        total_insertions_++;
-        flow_count_++;
+        uint32_t id = stripe.Create(key, hash);
+        FlowEntry& entry = stripe.Entry(id);
+        entry.stats.first_seen_ns = timestamp_ns;
+        entry.stats.last_seen_ns = timestamp_ns;
+        total_insertions_.fetch_add(1, std::memory_order_relaxed);
         
-        if (created) *created = true;
-        return &result.first->second;
+        update(entry, true);
+        FlowTimeoutClass timeout_class = entry.TimeoutClass();
+        stripe.Schedule(id, timeout_class, Deadline(entry, timeout_class));
+        return &entry;
+    }
+    
+    // UPDATE OTHER - From inside the update of held, run update(other) under
+    // other's stripe lock. Only tries the lock, so a writer never waits on
+    // one stripe while holding another; false if it is busy.
+    template<typename Fn>
+    bool UpdateOther(const FlowEntry& held, FlowEntry& other, Fn&& update) {
+        Stripe& stripe = StripeFor(static_cast<uint32_t>(FlowKeyHash()(other.key)));
+        if (&stripe == &StripeFor(static_cast<uint32_t>(FlowKeyHash()(held.key)))) {
+            update(other);
+            return true;
+        }
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex, std::try_to_lock);  // Exclusive lock for write
+        if (!lock.owns_lock()) {
+            return false;
+        }
+        update(other);
+        return true;
+    }
+
+    // LOOKUP OR CREATE - Find existing flow or create new one
+    // The entry is not locked once this returns; see Update
+    FlowEntry* LookupOrCreate(const FlowKey& key, uint64_t timestamp_ns, bool* created = nullptr) {
+        bool was_created = false;
+        FlowEntry* flow = Update(key, timestamp_ns, [&was_created](FlowEntry&, bool c) { was_created = c; });
+        if (created) *created = was_created;
+        return flow;
     }
     
     // LOOKUP - Find existing flow (no creation)
     FlowEntry* Lookup(const FlowKey& key) {
-        std::shared_lock<std::shared_mutex> lock(mutex_);  // Shared lock for read
-        total_lookups_++;
+        uint32_t hash = static_cast<uint32_t>(FlowKeyHash()(key));
+        Stripe& stripe = StripeFor(hash);
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex);  // Shared lock for read
+        total_lookups_.fetch_add(1, std::memory_order_relaxed);
         
-        auto it = flows_.find(key);
-        return (it != flows_.end()) ? &it->second : nullptr;
+        size_t pos = stripe.Find(key, hash);
+        return (pos != Stripe::NOT_FOUND) ? &stripe.Entry(stripe.slots[pos].entry) : nullptr;
     }
     
-    // CLEANUP EXPIRED - Remove flows older than timeout
-    size_t CleanupExpired(uint64_t current_time_us, uint64_t timeout_us) {
-        std::unique_lock<std::shared_mutex> lock(mutex_);  // Exclusive lock for write
+    // REMOVE CALLBACK - Called with each flow about to be erased, under its stripe's lock
+    typedef std::function<void(FlowEntry&, FlowRemoveReason)> RemoveCallback;
+    void SetRemoveCallback(RemoveCallback callback) { on_remove_ = std::move(callback); }
+    
+    // Not synchronized with CleanupExpired; set before flows arrive
+    void SetTimeouts(const FlowTimeouts& timeouts) { timeouts_ = timeouts; }
+    const FlowTimeouts& GetTimeouts() const { return timeouts_; }
+    
+    // Not synchronized with Update; set before flows arrive or under the caller's lock
+    void SetEvictionPolicy(FlowEvictionPolicy policy) { eviction_policy_ = policy; }
+    FlowEvictionPolicy GetEvictionPolicy() const { return eviction_policy_; }
+    
+    // CLEANUP EXPIRED - Remove flows idle past their class's timeout.
+    // Work is the flows whose ticks have come round, not the table size;
+    // flows are removed up to a tick late.
+    size_t CleanupExpired(uint64_t current_time_ns) {
         size_t removed = 0;
+        uint64_t target = current_time_ns / WHEEL_TICK_NS;
         
-        for (auto it = flows_.begin(); it != flows_.end(); ) {
-            if (current_time_us - it->second.stats.last_seen_us > timeout_us) {
-                it = flows_.erase(it);
-                removed++;
-                flow_count_--;
-            } else {
-                ++it;
+        for (size_t i = 0; i < stripe_count_; i++) {
+            Stripe& stripe = stripes_[i];
+            std::unique_lock<std::shared_mutex> lock(stripe.mutex);  // Exclusive lock for write
+            if (target <= stripe.wheel_tick) {
+                continue;
+            }
+            
+            // After a long gap every bucket is visited once
+            uint64_t steps = (std::min)(target - stripe.wheel_tick, static_cast<uint64_t>(WHEEL_SLOTS));
+            for (uint64_t step = 1; step <= steps; step++) {
+                uint32_t& bucket = stripe.wheel[(stripe.wheel_tick + step) & (WHEEL_SLOTS - 1)];
+                uint32_t id = bucket;
+                bucket = EMPTY;
+                while (id != EMPTY) {
+                    FlowEntry& entry = stripe.Entry(id);
+                    uint32_t next = entry.expiry_next;
+                    if (current_time_ns < Deadline(entry, entry.expiry_class)) {
+                        stripe.Schedule(id, entry.expiry_class, Deadline(entry, entry.expiry_class));
+                    } else {
+                        if (on_remove_) on_remove_(entry, FlowRemoveReason::EXPIRED);
+                        stripe.Erase(stripe.Locate(id, static_cast<uint32_t>(FlowKeyHash()(entry.key))));
+                        removed++;
+                        flow_count_.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                    id = next;
+                }
             }
+            stripe.wheel_tick = target;
         }
         
+        total_expired_.fetch_add(removed, std::memory_order_relaxed);
         return removed;
     }
     
     // CLEAR - Remove all flows
     void Clear() {
-        std::unique_lock<std::shared_mutex> lock(mutex_);  // Exclusive lock for write
-        flows_.clear();
-        flow_count_ = 0;
+        for (size_t i = 0; i < stripe_count_; i++) {
+            Stripe& stripe = stripes_[i];
+            std::unique_lock<std::shared_mutex> lock(stripe.mutex);  // Exclusive lock for write
+            for (size_t pos = 0; pos < stripe.slots.size(); pos++) {
+                Slot& slot = stripe.slots[pos];
+                if (slot.entry != EMPTY) {
+                    if (on_remove_) on_remove_(stripe.Entry(slot.entry), FlowRemoveReason::CLEARED);
+                    stripe.free_entries.push_back(slot.entry);
+                    slot = Slot();
+                    flow_count_.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+            stripe.count = 0;
+            std::fill(std::begin(stripe.wheel), std::end(stripe.wheel), EMPTY);
+        }
     }
     
 
-    size_t GetFlowCount() const { return flow_count_; }
+    size_t GetFlowCount() const { return flow_count_.load(std::memory_order_relaxed); }
     size_t GetMaxFlows() const { return max_flows_; }
+    size_t GetStripeCount() const { return stripe_count_; }
     uint64_t GetTotalLookups() const { return total_lookups_; }
     uint64_t GetTotalInsertions() const { return total_insertions_; }
+    uint64_t GetTotalExpired() const { return total_expired_; }
+    uint64_t GetTotalEvicted() const { return total_evicted_; }
+    uint64_t GetTotalRejected() const { return total_rejected_; }   // New flows refused: full, nothing evicted
+    
+    size_t GetSlotCount() const {
+        size_t slots = 0;
+        for (size_t i = 0; i < stripe_count_; i++) {
+            std::shared_lock<std::shared_mutex> lock(stripes_[i].mutex);  // Shared lock for read
+            slots += stripes_[i].slots.size();
+        }
+        return slots;
+    }
     
+    // Not a snapshot: each stripe is copied under its own lock
     std::vector<FlowEntry> GetAllFlows() const {
-        std::shared_lock<std::shared_mutex> lock(mutex_);  // Shared lock for read
         std::vector<FlowEntry> result;
-        result.reserve(flows_.size());
+        result.reserve(GetFlowCount());
         
-        for (const auto& pair : flows_) {
-            result.push_back(pair.second);
-        }
+        ForEachEntry([&result](const FlowEntry& flow) {
+            result.push_back(flow);
+        });
         
         return result;
     }
     
+    // Each stripe's top N is copied under its lock, then merged
     template<typename Comparator>
     std::vector<FlowEntry> GetTopFlows(size_t topN, Comparator comp) const {
-        std::shared_lock<std::shared_mutex> lock(mutex_);  // Shared lock for read
-        
-        if (flows_.empty()) {
-            return {};
+        std::vector<FlowEntry> candidates;
+        if (topN == 0) {
+            return candidates;
         }
         
-        // Collect pointers to avoid copying all flows
         std::vector<const FlowEntry*> flowPtrs;
-        flowPtrs.reserve(flows_.size());
-        for (const auto& pair : flows_) {
-            flowPtrs.push_back(&pair.second);
+        for (size_t i = 0; i < stripe_count_; i++) {
+            const Stripe& stripe = stripes_[i];
+            std::shared_lock<std::shared_mutex> lock(stripe.mutex);  // Shared lock for read
+            
+            // Collect pointers to avoid copying all flows
+            flowPtrs.clear();
+            stripe.ForEachEntry([&flowPtrs](const FlowEntry& flow) {
+                flowPtrs.push_back(&flow);
+            });
+            
+            // Partial sort to get this stripe's top N
+            size_t n = (std::min)(topN, flowPtrs.size());
+            std::partial_sort(flowPtrs.begin(), flowPtrs.begin() + n, flowPtrs.end(),
+                [&comp](const FlowEntry* a, const FlowEntry* b) {
+                    return comp(*a, *b);
+                });
+            
+            // Copy only top N flows
+            for (size_t j = 0; j < n; j++) {
+                candidates.push_back(*flowPtrs[j]);
+            }
         }
         
-        // Partial sort to get top N
+        flowPtrs.clear();
+        for (const FlowEntry& flow : candidates) {
+            flowPtrs.push_back(&flow);
+        }
         size_t n = (std::min)(topN, flowPtrs.size());
         std::partial_sort(flowPtrs.begin(), flowPtrs.begin() + n, flowPtrs.end(),
             [&comp](const FlowEntry* a, const FlowEntry* b) {
                 return comp(*a, *b);
             });
         
-        // Copy only top N flows
         std::vector<FlowEntry> result;
         result.reserve(n);
         for (size_t i = 0; i < n; i++) {
             result.push_back(*flowPtrs[i]);
         }
-        
         return result;
     }
     
@@ -231,7 +461,7 @@ public:
     // Convenience method: Get top flows by last activity
     std::vector<FlowEntry> GetTopFlowsByActivity(size_t topN) const {
         return GetTopFlows(topN, [](const FlowEntry& a, const FlowEntry& b) {
-            return a.stats.last_seen_us > b.stats.last_seen_us;
+            return a.stats.last_seen_ns > b.stats.last_seen_ns;
         });
     }
     
@@ -244,11 +474,8 @@ public:
     };
     
     AggregatedFlowStats GetAggregatedStats() const {
-        std::shared_lock<std::shared_mutex> lock(mutex_);  // Shared lock for read
-        
         AggregatedFlowStats stats;
-        for (const auto& pair : flows_) {
-            const FlowEntry& flow = pair.second;
+        ForEachEntry([&stats](const FlowEntry& flow) {
             uint64_t packets = flow.stats.TotalPackets();
             uint64_t bytes = flow.stats.TotalBytes();
             
@@ -258,26 +485,292 @@ public:
             int proto = static_cast<int>(flow.stats.app_protocol);
             stats.protocol_counts[proto] += packets;
             stats.protocol_bytes[proto] += bytes;
-        }
+        });
         
         return stats;
     }
     
     // PRINT STATS - Debug output
     void PrintStats() const {
-        std::cout << "  Active flows: " << flow_count_ << std::endl;
+        std::cout << "  Active flows: " << GetFlowCount() << std::endl;
         std::cout << "  Max flows: " << max_flows_ << std::endl;
+        std::cout << "  Table slots: " << GetSlotCount() << " in " << stripe_count_ << " stripes" << std::endl;
         std::cout << "  Total lookups: " << total_lookups_ << std::endl;
         std::cout << "  Total insertions: " << total_insertions_ << std::endl;
+        std::cout << "  Expired: " << total_expired_ << ", evicted: " << total_evicted_
+                  << ", rejected: " << total_rejected_ << std::endl;
     }
 
 private:
-    std::unordered_map<FlowKey, FlowEntry, FlowKeyHash> flows_;
-    mutable std::shared_mutex mutex_;  // Shared mutex for concurrent reads
+    static constexpr uint32_t EMPTY = 0;
+    
+    static constexpr uint64_t WHEEL_TICK_NS = 1000000000ULL;
+    static constexpr size_t WHEEL_SLOTS = 512;   // Power of two; longer timeouts go round again
+    
+    // entry is the block index + 1, so a zeroed slot is empty
+    struct Slot {
+        uint32_t hash = 0;
+        uint32_t entry = EMPTY;
+    };
+    
+    // STRIPE - One independent open-addressing table; callers hold mutex
+    // alignas keeps neighbouring stripes' locks off each other's cache lines
+    struct alignas(64) Stripe {
+        static constexpr size_t NOT_FOUND = SIZE_MAX;
+        
+        mutable std::shared_mutex mutex;
+        std::vector<Slot> slots;                          // Power of two, at most 7/8 full
+        std::vector<std::unique_ptr<FlowEntry[]>> blocks;
+        std::vector<uint32_t> free_entries;
+        uint32_t wheel[WHEEL_SLOTS] = {};               // Bucket heads, linked through FlowEntry::expiry_prev/next
+        uint64_t wheel_tick = 0;                        // Last tick expired; 0 until the first flow
+        size_t evict_cursor = 0;                        // Next slot to sample for eviction
+        size_t created_entries = 0;
+        size_t count = 0;
+        
+        void Reserve(size_t flows) {
+            size_t size = 16;
+            while (size * 7 / 8 < flows) {
+                size *= 2;
+            }
+            slots.assign(size, Slot());
+        }
+        
+        FlowEntry& Entry(uint32_t entry) const {
+            uint32_t index = entry - 1;
+            return blocks[index / ENTRIES_PER_BLOCK][index % ENTRIES_PER_BLOCK];
+        }
+        
+        // How far a slot sits from where its hash would put it
+        size_t Distance(const Slot& slot, size_t pos) const {
+            return (pos - slot.hash) & (slots.size() - 1);
+        }
+        
+        // FIND - A slot's distance only grows along a run, so meeting one
+        // closer to home than the probe means the key is absent
+        size_t Find(const FlowKey& key, uint32_t hash) const {
+            size_t mask = slots.size() - 1;
+            size_t pos = hash & mask;
+            for (size_t distance = 0; ; distance++, pos = (pos + 1) & mask) {
+                const Slot& slot = slots[pos];
+                if (slot.entry == EMPTY || Distance(slot, pos) < distance) {
+                    return NOT_FOUND;
+                }
+                if (slot.hash == hash && Entry(slot.entry).key == key) {
+                    return pos;
+                }
+            }
+        }
+        
+        // Slot of a known entry
+        size_t Locate(uint32_t entry, uint32_t hash) const {
+            size_t mask = slots.size() - 1;
+            size_t pos = hash & mask;
+            while (slots[pos].entry != entry) {
+                pos = (pos + 1) & mask;
+            }
+            return pos;
+        }
+        
+        uint32_t Create(const FlowKey& key, uint32_t hash) {
+            if (count + 1 > slots.size() * 7 / 8) {
+                Grow();
+            }
+            uint32_t index = AllocateEntry();
+            Entry(index) = FlowEntry(key);
+            Insert(Slot{hash, index});
+            count++;
+            return index;
+        }
+        
+        // SCHEDULE - File under the first tick after deadline_ns
+        void Schedule(uint32_t id, FlowTimeoutClass timeout_class, uint64_t deadline_ns) {
+            FlowEntry& entry = Entry(id);
+            if (wheel_tick == 0) {
+                wheel_tick = entry.stats.last_seen_ns / WHEEL_TICK_NS;
+            }
+            uint64_t tick = (std::max)(deadline_ns / WHEEL_TICK_NS + 1, wheel_tick + 1);
+            
+            uint32_t& bucket = wheel[tick & (WHEEL_SLOTS - 1)];
+            entry.expiry_class = timeout_class;
+            entry.expiry_tick = tick;
+            entry.expiry_prev = EMPTY;
+            entry.expiry_next = bucket;
+            if (bucket != EMPTY) {
+                Entry(bucket).expiry_prev = id;
+            }
+            bucket = id;
+        }
+        
+        void Unschedule(uint32_t id) {
+            FlowEntry& entry = Entry(id);
+            if (entry.expiry_prev != EMPTY) {
+                Entry(entry.expiry_prev).expiry_next = entry.expiry_next;
+            } else {
+                wheel[entry.expiry_tick & (WHEEL_SLOTS - 1)] = entry.expiry_next;
+            }
+            if (entry.expiry_next != EMPTY) {
+                Entry(entry.expiry_next).expiry_prev = entry.expiry_prev;
+            }
+        }
+        
+        // VICTIM - Slot of the first by the policy among the next
+        // EVICTION_SAMPLE flows from the cursor, which moves on so repeated
+        // evictions spread out. The stripe must not be empty.
+        size_t Victim(FlowEvictionPolicy policy) {
+            size_t mask = slots.size() - 1;
+            size_t pos = evict_cursor & mask;
+            size_t victim = NOT_FOUND;
+            size_t sampled = 0;
+            for (size_t visited = 0; visited < slots.size() && sampled < EVICTION_SAMPLE; visited++, pos = (pos + 1) & mask) {
+                uint32_t id = slots[pos].entry;
+                if (id == EMPTY) {
+                    continue;
+                }
+                sampled++;
+                if (victim == NOT_FOUND || EvictsBefore(Entry(id), Entry(slots[victim].entry), policy)) {
+                    victim = pos;
+                }
+            }
+            evict_cursor = pos;
+            return victim;
+        }
+        
+        // INSERT - Robin Hood: take the place of any slot nearer its home
+        void Insert(Slot slot) {
+            size_t mask = slots.size() - 1;
+            size_t pos = slot.hash & mask;
+            for (size_t distance = 0; ; distance++, pos = (pos + 1) & mask) {
+                Slot& current = slots[pos];
+                if (current.entry == EMPTY) {
+                    current = slot;
+                    return;
+                }
+                size_t current_distance = Distance(current, pos);
+                if (current_distance < distance) {
+                    std::swap(current, slot);
+                    distance = current_distance;
+                }
+            }
+        }
+        
+        // ERASE - Frees the entry, already off the wheel; backward shift
+        // pulls the rest of the run one slot closer
+        void Erase(size_t pos) {
+            free_entries.push_back(slots[pos].entry);
+            count--;
+            size_t mask = slots.size() - 1;
+            size_t next = (pos + 1) & mask;
+            while (slots[next].entry != EMPTY && Distance(slots[next], next) != 0) {
+                slots[pos] = slots[next];
+                pos = next;
+                next = (next + 1) & mask;
+            }
+            slots[pos] = Slot();
+        }
+        
+        // Doubles the slots; hashes are kept in them, so entries are not read
+        void Grow() {
+            std::vector<Slot> old(slots.size() * 2);
+            old.swap(slots);
+            for (const Slot& slot : old) {
+                if (slot.entry != EMPTY) {
+                    Insert(slot);
+                }
+            }
+        }
+        
+        uint32_t AllocateEntry() {
+            if (!free_entries.empty()) {
+                uint32_t entry = free_entries.back();
+                free_entries.pop_back();
+                return entry;
+            }
+            if (created_entries % ENTRIES_PER_BLOCK == 0) {
+                blocks.emplace_back(new FlowEntry[ENTRIES_PER_BLOCK]);
+            }
+            return static_cast<uint32_t>(++created_entries);
+        }
+        
+        template<typename Fn>
+        void ForEachEntry(Fn&& fn) const {
+            for (const Slot& slot : slots) {
+                if (slot.entry != EMPTY) {
+                    fn(Entry(slot.entry));
+                }
+            }
+        }
+    };
+    
+    // EVICT - Make room in stripe for one new flow; false if the policy is
+    // NONE or the stripe has no flows (the table is full with the others')
+    bool Evict(Stripe& stripe) {
+        if (eviction_policy_ == FlowEvictionPolicy::NONE || stripe.count == 0) {
+            return false;
+        }
+        size_t pos = stripe.Victim(eviction_policy_);
+        uint32_t id = stripe.slots[pos].entry;
+        if (on_remove_) on_remove_(stripe.Entry(id), FlowRemoveReason::EVICTED);
+        stripe.Unschedule(id);
+        stripe.Erase(pos);
+        flow_count_.fetch_sub(1, std::memory_order_relaxed);
+        total_evicted_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    // Lower goes first under CLOSED_FIRST
+    static int CloseRank(const FlowEntry& entry) {
+        switch (entry.expiry_class) {
+            case FlowTimeoutClass::TCP_CLOSED: return 0;
+            case FlowTimeoutClass::TCP_CLOSING: return 1;
+            case FlowTimeoutClass::TCP_HANDSHAKE: return 2;
+            default: return 3;
+        }
+    }
+    
+    static bool EvictsBefore(const FlowEntry& a, const FlowEntry& b, FlowEvictionPolicy policy) {
+        if (policy == FlowEvictionPolicy::CLOSED_FIRST && CloseRank(a) != CloseRank(b)) {
+            return CloseRank(a) < CloseRank(b);
+        }
+        if (policy == FlowEvictionPolicy::SMALLEST_FIRST && a.stats.TotalBytes() != b.stats.TotalBytes()) {
+            return a.stats.TotalBytes() < b.stats.TotalBytes();
+        }
+        return a.stats.last_seen_ns < b.stats.last_seen_ns;
+    }
+    
+    // First time at which the flow is due: idle for more than its timeout
+    uint64_t Deadline(const FlowEntry& entry, FlowTimeoutClass timeout_class) const {
+        uint64_t timeout_ns = timeouts_.For(timeout_class);
+        uint64_t last_seen_ns = entry.stats.last_seen_ns;
+        return timeout_ns >= UINT64_MAX - last_seen_ns ? UINT64_MAX : last_seen_ns + timeout_ns + 1;
+    }
+    
+    // Top hash bits pick the stripe; the low bits index within it
+    Stripe& StripeFor(uint32_t hash) const {
+        return stripes_[(hash >> 24) & (stripe_count_ - 1)];
+    }
+    
+    // Visits every flow, one stripe at a time under its shared lock
+    template<typename Fn>
+    void ForEachEntry(Fn&& fn) const {
+        for (size_t i = 0; i < stripe_count_; i++) {
+            std::shared_lock<std::shared_mutex> lock(stripes_[i].mutex);  // Shared lock for read
+            stripes_[i].ForEachEntry(fn);
+        }
+    }
+    
+    std::unique_ptr<Stripe[]> stripes_;
     size_t max_flows_;
+    size_t stripe_count_;
     std::atomic<size_t> flow_count_;
     std::atomic<uint64_t> total_lookups_;
     std::atomic<uint64_t> total_insertions_;
+    std::atomic<uint64_t> total_expired_;
+    std::atomic<uint64_t> total_evicted_;
+    std::atomic<uint64_t> total_rejected_;
+    FlowTimeouts timeouts_;
+    FlowEvictionPolicy eviction_policy_;
+    RemoveCallback on_remove_;
 };
 
 } // namespace WareHound
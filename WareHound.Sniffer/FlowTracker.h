@@ -4,8 +4,11 @@
 
 #include "FlowTable.h"
 #include "PacketParser.h"
+#include "FragmentReassembler.h"
+#include "TcpReassembler.h"
 #include "ProtocolDetector.h"
 #include <memory>
+#include <unordered_set>
 #include <iostream>
 #include <chrono>
 #include <pcap.h>
@@ -15,7 +18,9 @@ namespace WareHound {
 // FLOW TRACKER  
 // Coordinates:
 // - PacketParser (packet parsing)
+// - FragmentReassembler (IP fragments, joined before they reach a flow)
 // - FlowTable (flow storage)
+// - TcpReassembler (in-order stream bytes, when collecting payload)
 // - TCP State Machine (connection tracking)
 // - ProtocolDetector (application protocol detection)
 
@@ -25,12 +30,25 @@ public:
     struct Config {
         size_t table_size = FlowTable::DEFAULT_TABLE_SIZE;
         size_t max_flows = FlowTable::DEFAULT_MAX_FLOWS;
-        uint64_t flow_timeout_us = 300 * 1000000ULL;  // 5 minutes
-        uint64_t cleanup_interval_us = 60 * 1000000ULL;  // 1 minute
-        bool collect_payload = false;
-        size_t max_payload_size = 65536;
+        FlowEvictionPolicy eviction = FlowEvictionPolicy::LEAST_RECENT;  // When max_flows is reached
+        FlowTimeouts timeouts;
+        uint64_t cleanup_interval_ns = 1000000000ULL;  // 1 second; each pass only touches flows due
+        bool collect_payload = false;    // Deliver payload to the stream callback
+        DecapConfig decap;
+        FragmentReassembler::Config fragments;
+        TcpReassembler::Config streams;
     };
     
+    // STREAM CALLBACK - Payload in order: TCP reassembled, UDP per datagram.
+    // data is only valid for the call. Runs under the flow's stripe lock, so
+    // it must not call into the flow table.
+    typedef std::function<void(const FlowEntry& flow, bool to_server,
+                               const uint8_t* data, uint32_t len)> StreamCallback;
+    
+    // EXPORT CALLBACK - A flow's final state as it leaves the table: expired,
+    // evicted to make room, or cleared. Same locking rules as StreamCallback.
+    typedef std::function<void(const FlowEntry& flow, FlowRemoveReason reason)> ExportCallback;
+    
     // Pre-computed aggregate statistics (updated atomically during packet processing)
     struct AggregateStats {
         std::atomic<uint64_t> total_tcp_packets{0};
@@ -42,127 +60,107 @@ public:
         std::atomic<uint64_t> closed_flows{0};
     };
     
-    explicit FlowTracker(const Config& config = Config())
+    FlowTracker() : FlowTracker(Config()) {}
+    explicit FlowTracker(const Config& config)
         : config_(config)
         , flow_table_(config.table_size, config.max_flows)
-        , last_cleanup_us_(0)
+        , fragments_(config.fragments)
+        , streams_(config.streams)
+        , last_cleanup_ns_(0)
         , packets_processed_(0)
         , bytes_processed_(0)
-        , start_time_us_(0)
+        , start_time_ns_(0)
         , aggregate_stats_()
     {
+        flow_table_.SetTimeouts(config.timeouts);
+        flow_table_.SetEvictionPolicy(config.eviction);
+        flow_table_.SetRemoveCallback([this](FlowEntry& flow, FlowRemoveReason reason) {
+            streams_.Release(flow.stream_to_server);
+            streams_.Release(flow.stream_to_client);
+            if (export_callback_) {
+                export_callback_(flow, reason);
+            }
+        });
+        // Out of segments: flush another flow's stream under its own stripe lock
+        streams_.SetEvictCallback([this](TcpStream& stream) {
+            FlowEntry& victim = *static_cast<FlowEntry*>(stream.owner);
+            return flow_table_.UpdateOther(*delivering_, victim, [&](FlowEntry& flow) {
+                bool to_server = &stream == &flow.stream_to_server;
+                streams_.Flush(stream, [&](const uint8_t* data, uint32_t len) {
+                    if (stream_callback_) stream_callback_(flow, to_server, data, len);
+                });
+            });
+        });
     }
     
     // PROCESS PACKET 
+    // len is what was captured; byte counters use wire_len, the size on the
+    // wire, so truncated captures still count full packets
     FlowEntry* ProcessPacket(const uint8_t* raw_data, uint32_t len,
-                              uint64_t timestamp_us) 
+                              uint64_t timestamp_ns, uint32_t wire_len = 0) 
     {
-        if (start_time_us_ == 0) {
-            start_time_us_ = timestamp_us;
+        // 1. Parse packet (offsets only; fields are read as needed)
+        PacketView parsed;
+        if (!PacketParser::Parse(raw_data, len, timestamp_ns, parsed, config_.decap)) {
+            parsed.timestamp_ns = timestamp_ns;
         }
-        
-        packets_processed_++;
-        bytes_processed_ += len;
-        
-        // 1. Parse packet
-        ParsedPacket parsed;
-        if (!PacketParser::Parse(raw_data, len, timestamp_us, parsed)) {
-            return nullptr;
-        }
-        
-        // 2. Check for valid IP and transport layer
-        if (!parsed.valid_ip || !parsed.valid_transport) {
-            return nullptr;
-        }
-        
-        // 3. Only TCP and UDP support flows
-        if (parsed.ip_protocol != IPPROTO_TCP && parsed.ip_protocol != IPPROTO_UDP) {
-            return nullptr;
-        }
-        
-        // 4. Create flow key
-        FlowKey key = parsed.ToFlowKey();
-        
-        // 5. Lookup or create flow
-        bool created = false;
-        FlowEntry* flow = flow_table_.LookupOrCreate(key, timestamp_us, &created);
-        
-        if (flow == nullptr) {
-            return nullptr;
-        }
-        
-        // 6. Determine packet direction
-        bool to_server = flow->IsToServer(key);
-        
-        // 7. Update statistics
-        UpdateFlowStats(flow, parsed, to_server);
-        
-        // 7a. Update aggregate stats atomically (no lock needed)
-        if (parsed.ip_protocol == IPPROTO_TCP) {
-            aggregate_stats_.total_tcp_packets.fetch_add(1, std::memory_order_relaxed);
-            aggregate_stats_.total_tcp_bytes.fetch_add(len, std::memory_order_relaxed);
-        } else if (parsed.ip_protocol == IPPROTO_UDP) {
-            aggregate_stats_.total_udp_packets.fetch_add(1, std::memory_order_relaxed);
-            aggregate_stats_.total_udp_bytes.fetch_add(len, std::memory_order_relaxed);
+        parsed.original_len = (std::max)(wire_len, len);
+        return ProcessPacket(parsed);
+    }
+    
+    // PROCESS PACKET (parsed) - For callers that already parsed the frame
+    // with this tracker's decap config; original_len is the wire length
+    FlowEntry* ProcessPacket(const PacketView& parsed) {
+        uint64_t timestamp_ns = parsed.timestamp_ns;
+        if (start_time_ns_.load(std::memory_order_relaxed) == 0) {
+            start_time_ns_.store(timestamp_ns, std::memory_order_relaxed);
         }
+        uint32_t wire_len = parsed.original_len;
         
-        // 8. Update TCP state machine (if TCP)
-        if (parsed.ip_protocol == IPPROTO_TCP) {
-            TcpState prev_state = flow->stats.tcp_state;
-            UpdateTcpState(flow, parsed, to_server);
-            TcpState new_state = flow->stats.tcp_state;
-            
-            // Track state transitions for aggregate stats
-            if (prev_state != TcpState::ESTABLISHED && new_state == TcpState::ESTABLISHED) {
-                aggregate_stats_.established_flows.fetch_add(1, std::memory_order_relaxed);
-            } else if (prev_state != TcpState::CLOSED && new_state == TcpState::CLOSED) {
-                aggregate_stats_.closed_flows.fetch_add(1, std::memory_order_relaxed);
-            }
-        }
+        packets_processed_++;
+        bytes_processed_ += wire_len;
         
-        // 9. Detect application protocol (if not yet detected)
-        if (flow->stats.app_protocol == AppProtocol::UNKNOWN) {
-            uint8_t confidence = 0;
-            AppProtocol proto = ProtocolDetector::Detect(parsed, &confidence);
-            if (proto != AppProtocol::UNKNOWN) {
-                flow->stats.app_protocol = proto;
-                flow->stats.app_confidence = confidence;
-                
-                // Update protocol statistics atomically
-                {
-                    std::lock_guard<std::mutex> lock(stats_mutex_);
-                    if (protocol_counts_.find(static_cast<int>(proto)) == protocol_counts_.end()) {
-                        aggregate_stats_.unique_protocols.fetch_add(1, std::memory_order_relaxed);
-                    }
-                    protocol_counts_[static_cast<int>(proto)]++;
-                }
+        // 2. Fragments wait for the rest of their datagram, which then goes
+        // through as one packet of the sum of their wire lengths
+        if (parsed.valid_ip && parsed.ip_fragment) {
+            FragmentReassembler::Datagram datagram;
+            PacketView whole;
+            if (!fragments_.Add(parsed, datagram) ||
+                !PacketParser::Parse(datagram.data, datagram.len, timestamp_ns, whole, config_.decap) ||
+                whole.ip_fragment) {
+                MaybeCleanup(timestamp_ns);
+                return nullptr;
             }
+            whole.original_len = static_cast<uint32_t>((std::min)(datagram.wire_len, static_cast<uint64_t>(UINT32_MAX)));
+            return TrackFlow(whole);
         }
-        
-        // 10. Collect payload (if enabled)
-        if (config_.collect_payload && parsed.payload && parsed.payload_len > 0) {
-            flow->payload_collection_enabled = true;
-            flow->payload_max_size = config_.max_payload_size;
-            flow->AppendPayload(parsed.payload, parsed.payload_len, to_server);
-        }
-        
-        // 11. Periodic cleanup of expired flows
-        MaybeCleanup(timestamp_us);
-        
-        return flow;
+        return TrackFlow(parsed);
     }
     
 
     // PROCESS PACKET (with pcap header) - Convenience wrapper
-    FlowEntry* ProcessPacket(const struct pcap_pkthdr* pkthdr, const u_char* packet) {
+    // nano_precision: the handle was opened with PCAP_TSTAMP_PRECISION_NANO,
+    // so ts.tv_usec holds nanoseconds
+    FlowEntry* ProcessPacket(const struct pcap_pkthdr* pkthdr, const u_char* packet,
+                             bool nano_precision = false) {
         if (pkthdr == nullptr || packet == nullptr) {
             return nullptr;
         }
         
-        uint64_t timestamp_us = static_cast<uint64_t>(pkthdr->ts.tv_sec) * 1000000 + 
-                                pkthdr->ts.tv_usec;
+        uint64_t timestamp_ns = static_cast<uint64_t>(pkthdr->ts.tv_sec) * 1000000000ULL + 
+                                static_cast<uint64_t>(pkthdr->ts.tv_usec) * (nano_precision ? 1 : 1000);
         
-        return ProcessPacket(packet, pkthdr->caplen, timestamp_us);
+        return ProcessPacket(packet, pkthdr->caplen, timestamp_ns, pkthdr->len);
+    }
+    
+
+    // Not synchronized with ProcessPacket; callers hold the same lock
+    void SetDecapConfig(const DecapConfig& decap) { config_.decap = decap; }
+    void SetStreamCallback(StreamCallback callback) { stream_callback_ = std::move(callback); }
+    void SetExportCallback(ExportCallback callback) { export_callback_ = std::move(callback); }
+    void SetEvictionPolicy(FlowEvictionPolicy policy) {
+        config_.eviction = policy;
+        flow_table_.SetEvictionPolicy(policy);
     }
     
 
@@ -184,6 +182,11 @@ public:
     uint64_t GetEstablishedFlows() const { return aggregate_stats_.established_flows.load(std::memory_order_relaxed); }
     uint64_t GetClosedFlows() const { return aggregate_stats_.closed_flows.load(std::memory_order_relaxed); }
     
+    // Fragment counters are atomic and safe to read during ProcessPacket;
+    // stream stats are not synchronized with it
+    const FragmentReassembler::Stats& GetFragmentStats() const { return fragments_.GetStats(); }
+    const TcpReassembler::Stats& GetStreamStats() const { return streams_.GetStats(); }
+    
     // GET PROTOCOL COUNTS - For statistics
     void GetProtocolCounts(int* counts, int max_count) const {
         std::lock_guard<std::mutex> lock(stats_mutex_);
@@ -194,27 +197,42 @@ public:
         }
     }
     
+    // COLLECT PROTOCOLS - Add detected protocols to a set (for merging shards)
+    void CollectProtocols(std::unordered_set<int>& out) const {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        for (const auto& p : protocol_counts_) {
+            out.insert(p.first);
+        }
+    }
+    
     // GET CAPTURE DURATION - In seconds
+    // Packet timestamps are wall-clock nanoseconds since the epoch
     double GetCaptureDurationSeconds() const {
-        if (start_time_us_ == 0) return 0.0;
-        auto now = std::chrono::steady_clock::now();
-        auto start = std::chrono::steady_clock::time_point(
-            std::chrono::microseconds(start_time_us_));
+        uint64_t start_time_ns = start_time_ns_.load(std::memory_order_relaxed);
+        if (start_time_ns == 0) return 0.0;
+        auto now = std::chrono::system_clock::now();
+        auto start = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(start_time_ns)));
         return std::chrono::duration<double>(now - start).count();
     }
     
 
     // FORCE CLEANUP - Manual cleanup trigger
-    size_t ForceCleanup(uint64_t current_time_us) {
-        return flow_table_.CleanupExpired(current_time_us, config_.flow_timeout_us);
+    size_t ForceCleanup(uint64_t current_time_ns) {
+        fragments_.Expire(current_time_ns);
+        return flow_table_.CleanupExpired(current_time_ns);
     }
     
     // CLEAR - Clear all flows and reset statistics
+    // Not synchronized with ProcessPacket; call it from the packet thread
     void Clear() {
         flow_table_.Clear();
+        fragments_.Clear();
+        streams_.Clear();
         packets_processed_ = 0;
         bytes_processed_ = 0;
-        start_time_us_ = 0;
+        start_time_ns_ = 0;
         
         // Reset aggregate stats
         aggregate_stats_.total_tcp_packets.store(0, std::memory_order_relaxed);
@@ -240,10 +258,15 @@ public:
 private:
     Config config_;
     FlowTable flow_table_;
-    uint64_t last_cleanup_us_;
+    FragmentReassembler fragments_;
+    TcpReassembler streams_;
+    FlowEntry* delivering_ = nullptr;   // Flow whose stripe is held while its stream is added to
+    StreamCallback stream_callback_;
+    ExportCallback export_callback_;
+    uint64_t last_cleanup_ns_;
     std::atomic<uint64_t> packets_processed_;
     std::atomic<uint64_t> bytes_processed_;
-    uint64_t start_time_us_;
+    std::atomic<uint64_t> start_time_ns_;
     
     mutable std::mutex stats_mutex_;
     std::unordered_map<int, uint64_t> protocol_counts_;
@@ -252,37 +275,144 @@ private:
     AggregateStats aggregate_stats_;
     
 
+    // TRACK FLOW - Steps 3-11 for a whole (non-fragment) packet
+    FlowEntry* TrackFlow(const PacketView& parsed) {
+        uint64_t timestamp_ns = parsed.timestamp_ns;
+        
+        // Check for valid IP and transport layer
+        if (!parsed.valid_ip || !parsed.valid_transport) {
+            return nullptr;
+        }
+        
+        // 3. Only TCP and UDP support flows
+        if (parsed.ip_protocol != IPPROTO_TCP && parsed.ip_protocol != IPPROTO_UDP) {
+            return nullptr;
+        }
+        
+        // 4. Create flow key
+        FlowKey key = parsed.ToFlowKey();
+        
+        // 5. Lookup or create flow; steps 6-10 run under its stripe's lock
+        FlowEntry* flow = flow_table_.Update(key, timestamp_ns, [&](FlowEntry& entry, bool) {
+            UpdateFlow(&entry, parsed, key);
+        });
+        
+        if (flow == nullptr) {
+            return nullptr;
+        }
+        
+        // 11. Periodic cleanup of expired flows
+        MaybeCleanup(timestamp_ns);
+        
+        return flow;
+    }
+    
+
+    // UPDATE FLOW - Steps 6-10 for one packet of a flow
+    void UpdateFlow(FlowEntry* flow, const PacketView& parsed, const FlowKey& key) {
+        uint32_t wire_len = parsed.original_len;
+        
+        // 6. Determine packet direction
+        bool to_server = flow->IsToServer(key);
+        
+        // 7. Update statistics
+        UpdateFlowStats(flow, parsed, to_server);
+        
+        // 7a. Update aggregate stats atomically (no lock needed)
+        if (parsed.ip_protocol == IPPROTO_TCP) {
+            aggregate_stats_.total_tcp_packets.fetch_add(1, std::memory_order_relaxed);
+            aggregate_stats_.total_tcp_bytes.fetch_add(wire_len, std::memory_order_relaxed);
+        } else if (parsed.ip_protocol == IPPROTO_UDP) {
+            aggregate_stats_.total_udp_packets.fetch_add(1, std::memory_order_relaxed);
+            aggregate_stats_.total_udp_bytes.fetch_add(wire_len, std::memory_order_relaxed);
+        }
+        
+        // 8. Update TCP state machine (if TCP)
+        if (parsed.ip_protocol == IPPROTO_TCP) {
+            TcpState prev_state = flow->stats.tcp_state;
+            UpdateTcpState(flow, parsed, to_server);
+            TcpState new_state = flow->stats.tcp_state;
+            
+            // Track state transitions for aggregate stats
+            if (prev_state != TcpState::ESTABLISHED && new_state == TcpState::ESTABLISHED) {
+                aggregate_stats_.established_flows.fetch_add(1, std::memory_order_relaxed);
+            } else if (prev_state != TcpState::CLOSED && new_state == TcpState::CLOSED) {
+                aggregate_stats_.closed_flows.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        
+        // 9. Detect application protocol (if not yet detected)
+        if (flow->stats.app_protocol == AppProtocol::UNKNOWN) {
+            uint8_t confidence = 0;
+            AppProtocol proto = ProtocolDetector::Detect(parsed, &confidence);
+            if (proto != AppProtocol::UNKNOWN) {
+                flow->stats.app_protocol = proto;
+                flow->stats.app_confidence = confidence;
+                
+                // Update protocol statistics atomically
+                {
+                    std::lock_guard<std::mutex> lock(stats_mutex_);
+                    if (protocol_counts_.find(static_cast<int>(proto)) == protocol_counts_.end()) {
+                        aggregate_stats_.unique_protocols.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    protocol_counts_[static_cast<int>(proto)]++;
+                }
+            }
+        }
+        
+        // 10. Deliver payload (if enabled); TCP goes through reassembly,
+        // which also needs the payload-less SYN to learn where data starts.
+        // A reset gives up on holes; after a FIN they may still be filled.
+        if (config_.collect_payload && stream_callback_) {
+            auto deliver = [&](const uint8_t* data, uint32_t len) {
+                stream_callback_(*flow, to_server, data, len);
+            };
+            if (parsed.ip_protocol == IPPROTO_TCP) {
+                TcpStream& stream = to_server ? flow->stream_to_server : flow->stream_to_client;
+                stream.owner = flow;
+                delivering_ = flow;
+                streams_.Add(stream, parsed.TcpSeq(), parsed.TcpFlags(), parsed.Payload(), parsed.PayloadLen(), deliver);
+                if (parsed.TcpFlags() & TcpFlags::RST) {
+                    streams_.Flush(stream, deliver);
+                }
+            } else if (parsed.Payload() != nullptr) {
+                deliver(parsed.Payload(), parsed.PayloadLen());
+            }
+        }
+    }
+    
+
     // UPDATE FLOW STATS - Update counters
-    void UpdateFlowStats(FlowEntry* flow, const ParsedPacket& parsed, bool to_server) {
+    void UpdateFlowStats(FlowEntry* flow, const PacketView& parsed, bool to_server) {
         FlowStats& stats = flow->stats;
         
         // Timestamps
-        stats.last_seen_us = parsed.timestamp_us;
+        stats.last_seen_ns = parsed.timestamp_ns;
         
         // Directional counters
         if (to_server) {
             stats.packets_to_server++;
-            stats.bytes_to_server += parsed.capture_len;
+            stats.bytes_to_server += parsed.original_len;
         } else {
             stats.packets_to_client++;
-            stats.bytes_to_client += parsed.capture_len;
+            stats.bytes_to_client += parsed.original_len;
         }
         
         // TCP window size
         if (parsed.ip_protocol == IPPROTO_TCP) {
             if (to_server) {
-                stats.tcp_window_client = parsed.tcp_window;
+                stats.tcp_window_client = parsed.TcpWindow();
             } else {
-                stats.tcp_window_server = parsed.tcp_window;
+                stats.tcp_window_server = parsed.TcpWindow();
             }
         }
     }
     
 
     // UPDATE TCP STATE - TCP state machine
-    void UpdateTcpState(FlowEntry* flow, const ParsedPacket& parsed, bool to_server) {
+    void UpdateTcpState(FlowEntry* flow, const PacketView& parsed, bool to_server) {
         FlowStats& stats = flow->stats;
-        uint8_t flags = parsed.tcp_flags;
+        uint8_t flags = parsed.TcpFlags();
         
         bool syn = (flags & TcpFlags::SYN) != 0;
         bool ack = (flags & TcpFlags::ACK) != 0;
@@ -303,14 +433,14 @@ private:
         
         // Save seq/ack numbers
         if (to_server) {
-            stats.tcp_ack_client = parsed.tcp_ack;
+            stats.tcp_ack_client = parsed.TcpAck();
             if (syn && !ack) {
-                stats.tcp_seq_client = parsed.tcp_seq;
+                stats.tcp_seq_client = parsed.TcpSeq();
             }
         } else {
-            stats.tcp_ack_server = parsed.tcp_ack;
+            stats.tcp_ack_server = parsed.TcpAck();
             if (syn && ack) {
-                stats.tcp_seq_server = parsed.tcp_seq;
+                stats.tcp_seq_server = parsed.TcpSeq();
             }
         }
         
@@ -379,6 +509,10 @@ private:
                 break;
                 
             case TcpState::TIME_WAIT:
+                // The 4-tuple reused for a new connection
+                if (syn && !ack) {
+                    stats.tcp_state = TcpState::SYN_SENT;
+                }
                 break;
                 
             default:
@@ -387,10 +521,11 @@ private:
     }
     
 
-    void MaybeCleanup(uint64_t current_time_us) {
-        if (current_time_us - last_cleanup_us_ > config_.cleanup_interval_us) {
-            flow_table_.CleanupExpired(current_time_us, config_.flow_timeout_us);
-            last_cleanup_us_ = current_time_us;
+    void MaybeCleanup(uint64_t current_time_ns) {
+        if (current_time_ns - last_cleanup_ns_ > config_.cleanup_interval_ns) {
+            flow_table_.CleanupExpired(current_time_ns);
+            fragments_.Expire(current_time_ns);
+            last_cleanup_ns_ = current_time_ns;
         }
     }
 };
@@ -0,0 +1,311 @@
+#pragma once
+#ifndef FRAGMENT_REASSEMBLER_H
+#define FRAGMENT_REASSEMBLER_H
+
+#include "PacketParser.h"
+#include <unordered_map>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+
+namespace WareHound {
+
+// FRAGMENT KEY - Identifies one datagram in reassembly
+struct FragmentKey {
+    IpAddress src;
+    IpAddress dst;
+    uint32_t id = 0;
+    uint8_t protocol = 0;
+    uint8_t version = 0;
+
+    bool operator==(const FragmentKey& other) const {
+        return src == other.src && dst == other.dst && id == other.id &&
+               protocol == other.protocol && version == other.version;
+    }
+};
+
+struct FragmentKeyHash {
+    size_t operator()(const FragmentKey& key) const {
+        size_t h = IpAddressHash()(key.src) ^ (IpAddressHash()(key.dst) * 0x9E3779B97F4A7C15ULL);
+        return h ^ ((static_cast<size_t>(key.id) << 16) | (key.protocol << 8) | key.version);
+    }
+};
+
+// FRAGMENT REASSEMBLER - Rebuilds IPv4/IPv6 datagrams from their fragments
+// Fragments are held until every byte of the datagram has arrived, then the
+// first fragment's headers (fragment fields cleared, lengths fixed) are
+// joined with the data into one frame. Memory is bounded three ways: a
+// byte budget over all datagrams (oldest evicted first), a datagram count
+// per source address, and a timeout. Overlapping fragments drop the whole
+// datagram, as IPv6 requires and as a defence against overlap evasion.
+// Fragments cut short by the snaplen still count as arrived; the bytes
+// that were not captured read as zero.
+// Not thread-safe; one per FlowTracker, like the flow table it feeds.
+class FragmentReassembler {
+public:
+    static constexpr uint32_t MAX_DATAGRAM_LEN = 65535;
+
+    struct Config {
+        size_t max_bytes = 4 * 1024 * 1024;                // Buffered headers + data, all datagrams
+        size_t max_per_source = 64;                        // Datagrams in progress per source address
+        uint64_t timeout_ns = 30 * 1000000000ULL;          // From the first fragment
+    };
+
+    // Fragment counts, except reassembled; atomic so stats readers need no lock
+    struct Stats {
+        std::atomic<uint64_t> reassembled{0};  // Datagrams completed
+        std::atomic<uint64_t> timed_out{0};    // Held when their datagram timed out
+        std::atomic<uint64_t> evicted{0};      // Dropped for the byte budget or the per-source limit
+        std::atomic<uint64_t> dropped{0};      // Malformed or overlapping
+    };
+
+    // A completed datagram; data stays valid until the next Add or Clear
+    struct Datagram {
+        const uint8_t* data = nullptr;
+        uint32_t len = 0;
+        uint64_t wire_len = 0;       // Sum of the fragments' wire lengths
+        uint32_t fragments = 0;
+    };
+
+    FragmentReassembler() : buffered_bytes_(0) {}
+    explicit FragmentReassembler(const Config& config)
+        : config_(config), buffered_bytes_(0) {}
+
+    // ADD - Take one fragment (view.ip_fragment set). True when it
+    // completes a datagram, which is then described by out.
+    bool Add(const PacketView& view, Datagram& out) {
+        Expire(view.timestamp_ns);
+
+        FragmentInfo info;
+        if (!PacketParser::GetFragmentInfo(view, info) ||
+            info.offset + info.data_len > MAX_DATAGRAM_LEN ||
+            (info.more && (info.data_len % 8) != 0)) {
+            stats_.dropped++;
+            return false;
+        }
+
+        FragmentKey key{info.src, info.dst, info.id, info.protocol, info.version};
+        auto it = pending_.find(key);
+        if (it == pending_.end()) {
+            size_t& in_progress = per_source_[info.src];
+            if (in_progress >= config_.max_per_source) {
+                stats_.evicted++;
+                return false;
+            }
+            in_progress++;
+            it = pending_.emplace(key, Pending()).first;
+            it->second.first_seen_ns = view.timestamp_ns;
+            it->second.age = age_.insert(age_.end(), key);
+        }
+        Pending& pending = it->second;
+
+        uint32_t begin = info.offset;
+        uint32_t end = info.offset + info.data_len;
+        if (!info.more) {
+            if ((pending.total_len != 0 && pending.total_len != end) || end < pending.Received()) {
+                Drop(it, 1);
+                return false;
+            }
+            pending.total_len = end;
+        } else if (pending.total_len != 0 && end > pending.total_len) {
+            Drop(it, 1);
+            return false;
+        }
+
+        bool duplicate = false;
+        if (!AddRange(pending, begin, end, &duplicate)) {
+            Drop(it, 1);
+            return false;
+        }
+        if (duplicate) {
+            return false;
+        }
+
+        // Grow within the budget, evicting the oldest other datagrams
+        size_t header_len = begin == 0 ? HeaderLength(info) : 0;
+        size_t growth = (end > pending.data.size() ? end - pending.data.size() : 0) + header_len;
+        while (buffered_bytes_ + growth > config_.max_bytes && age_.front() != key) {
+            auto oldest = pending_.find(age_.front());
+            Evict(oldest);
+        }
+        if (buffered_bytes_ + growth > config_.max_bytes) {
+            stats_.evicted += pending.fragments + 1;
+            Remove(it);
+            return false;
+        }
+        buffered_bytes_ += growth;
+
+        if (end > pending.data.size()) {
+            pending.data.resize(end);
+        }
+        uint32_t captured = view.capture_len > info.data_offset ? view.capture_len - info.data_offset : 0;
+        memcpy(pending.data.data() + begin, view.data + info.data_offset, (std::min)(captured, info.data_len));
+        if (begin == 0) {
+            SaveHeader(pending, view, info);
+        }
+        pending.fragments++;
+        pending.wire_bytes += view.original_len;
+
+        if (pending.total_len == 0 || pending.ranges.size() != 1 || pending.ranges[0].second != pending.total_len ||
+            pending.header.empty()) {
+            return false;
+        }
+
+        Build(pending);
+        out.data = output_.data();
+        out.len = static_cast<uint32_t>(output_.size());
+        out.wire_len = pending.wire_bytes;
+        out.fragments = pending.fragments;
+        stats_.reassembled++;
+        Remove(it);
+        return true;
+    }
+
+    // EXPIRE - Drop datagrams whose first fragment is older than the timeout
+    size_t Expire(uint64_t now_ns) {
+        size_t expired = 0;
+        while (!age_.empty()) {
+            auto it = pending_.find(age_.front());
+            if (now_ns < it->second.first_seen_ns + config_.timeout_ns) {
+                break;
+            }
+            stats_.timed_out += it->second.fragments;
+            Remove(it);
+            expired++;
+        }
+        return expired;
+    }
+
+    void Clear() {
+        pending_.clear();
+        age_.clear();
+        per_source_.clear();
+        buffered_bytes_ = 0;
+        stats_.reassembled = 0;
+        stats_.timed_out = 0;
+        stats_.evicted = 0;
+        stats_.dropped = 0;
+    }
+
+    const Stats& GetStats() const { return stats_; }
+    size_t GetPendingCount() const { return pending_.size(); }
+    size_t GetBufferedBytes() const { return buffered_bytes_; }
+
+private:
+    struct Pending {
+        std::vector<uint8_t> header;   // First fragment's frame up to its data
+        std::vector<uint8_t> data;
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;  // Received [begin, end), sorted, merged
+        uint32_t total_len = 0;        // Known once the last fragment arrives
+        uint8_t version = 0;
+        uint32_t l3_offset = 0;
+        uint8_t next_header = 0;       // IPv6: replaces the fragment header's
+        uint32_t fragment_next = 0;    // IPv6: where that next-header byte lives
+        uint32_t fragments = 0;
+        uint64_t wire_bytes = 0;
+        uint64_t first_seen_ns = 0;
+        std::list<FragmentKey>::iterator age;
+
+        uint32_t Received() const { return ranges.empty() ? 0 : ranges.back().second; }
+    };
+
+    typedef std::unordered_map<FragmentKey, Pending, FragmentKeyHash> PendingMap;
+
+    // Headers kept from the first fragment; IPv6 leaves out the fragment header
+    static size_t HeaderLength(const FragmentInfo& info) {
+        return info.version == 6 ? info.fragment_header : info.data_offset;
+    }
+
+    // Insert [begin, end); false on a partial overlap. A fragment wholly
+    // inside received data is a retransmission: it is ignored rather than
+    // copied, so it cannot rewrite what arrived first.
+    static bool AddRange(Pending& pending, uint32_t begin, uint32_t end, bool* duplicate) {
+        auto& ranges = pending.ranges;
+        auto pos = std::lower_bound(ranges.begin(), ranges.end(), std::make_pair(begin, end));
+        if (pos != ranges.end() && pos->first == begin) {
+            *duplicate = pos->second >= end;
+            return *duplicate;
+        }
+        if (pos != ranges.begin() && (pos - 1)->second > begin) {
+            *duplicate = (pos - 1)->second >= end;
+            return *duplicate;
+        }
+        if (pos != ranges.end() && pos->first < end) {
+            return false;
+        }
+        pos = ranges.insert(pos, std::make_pair(begin, end));
+        if (pos + 1 != ranges.end() && (pos + 1)->first == end) {
+            pos->second = (pos + 1)->second;
+            ranges.erase(pos + 1);
+        }
+        if (pos != ranges.begin() && (pos - 1)->second == begin) {
+            (pos - 1)->second = pos->second;
+            ranges.erase(pos);
+        }
+        return true;
+    }
+
+    static void SaveHeader(Pending& pending, const PacketView& view, const FragmentInfo& info) {
+        size_t header_len = HeaderLength(info);
+        pending.header.assign(view.data, view.data + (std::min)(static_cast<size_t>(view.capture_len), header_len));
+        pending.header.resize(header_len);
+        pending.version = info.version;
+        pending.l3_offset = view.encap.l3_offset;
+        pending.next_header = info.protocol;
+        pending.fragment_next = info.fragment_next;
+    }
+
+    // Headers + data, with the IP header patched to describe the whole datagram
+    void Build(const Pending& pending) {
+        output_.assign(pending.header.begin(), pending.header.end());
+        output_.insert(output_.end(), pending.data.begin(), pending.data.begin() + pending.total_len);
+        uint8_t* ip_data = output_.data() + pending.l3_offset;
+        uint32_t ip_len = static_cast<uint32_t>(pending.header.size() - pending.l3_offset) + pending.total_len;
+        if (pending.version == 4) {
+            ip_len = (std::min)(ip_len, MAX_DATAGRAM_LEN);
+            ip_data[2] = static_cast<uint8_t>(ip_len >> 8);
+            ip_data[3] = static_cast<uint8_t>(ip_len);
+            ip_data[6] &= 0x40;  // Keep DF, clear MF and the offset
+            ip_data[7] = 0;
+        } else {
+            uint32_t payload_len = (std::min)(ip_len - 40, MAX_DATAGRAM_LEN);
+            ip_data[4] = static_cast<uint8_t>(payload_len >> 8);
+            ip_data[5] = static_cast<uint8_t>(payload_len);
+            output_[pending.fragment_next] = pending.next_header;
+        }
+    }
+
+    void Evict(PendingMap::iterator it) {
+        stats_.evicted += it->second.fragments;
+        Remove(it);
+    }
+
+    void Drop(PendingMap::iterator it, uint32_t extra) {
+        stats_.dropped += it->second.fragments + extra;
+        Remove(it);
+    }
+
+    void Remove(PendingMap::iterator it) {
+        Pending& pending = it->second;
+        buffered_bytes_ -= pending.data.size() + pending.header.size();
+        auto source = per_source_.find(it->first.src);
+        if (source != per_source_.end() && --source->second == 0) {
+            per_source_.erase(source);
+        }
+        age_.erase(pending.age);
+        pending_.erase(it);
+    }
+
+    Config config_;
+    PendingMap pending_;
+    std::list<FragmentKey> age_;   // Oldest first
+    std::unordered_map<IpAddress, size_t, IpAddressHash> per_source_;
+    size_t buffered_bytes_;
+    std::vector<uint8_t> output_;
+    Stats stats_;
+};
+
+}
+
+#endif // FRAGMENT_REASSEMBLER_H
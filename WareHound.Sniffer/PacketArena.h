@@ -0,0 +1,104 @@
+#pragma once
+#ifndef PACKET_ARENA_H
+#define PACKET_ARENA_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include "ThreadPlacement.h"
+
+namespace WareHound {
+
+// PACKET ARENA - Byte ring holding variable-length frame data
+//
+// Companion to SpscRing: each ring slot references caplen bytes here by
+// offset, so memory tracks actual frame sizes instead of a fixed 64 KB per
+// slot. Records are released in FIFO order together with their slot, which
+// means the live region always starts at the offset held by the oldest
+// in-flight slot. Only the producer allocates; it is told that offset by
+// the caller and never needs a consumer-written cursor of its own.
+class PacketArena {
+public:
+    static constexpr size_t ALIGNMENT = 8;
+    static constexpr uint32_t MAX_RECORD = 65536;
+    static constexpr size_t DEFAULT_CAPACITY = 4 * 1024 * 1024;  // 4 MB
+
+    explicit PacketArena(size_t capacity = DEFAULT_CAPACITY, int numaNode = ANY_NODE)
+        : capacity_(capacity < 4 * MAX_RECORD ? 4 * MAX_RECORD : capacity)
+        , data_(capacity_, numaNode)
+        , next_(0)
+    {
+    }
+
+    PacketArena(const PacketArena&) = delete;
+    PacketArena& operator=(const PacketArena&) = delete;
+
+    // ALLOCATE - Reserve len bytes (len <= MAX_RECORD)
+    // oldest_live is the offset of the oldest unreleased record, or nullptr
+    // if nothing is in flight. Returns false if the arena is full.
+    bool Allocate(uint32_t len, const uint32_t* oldest_live, uint32_t* offset) {
+        size_t need = AlignUp(len);
+
+        if (oldest_live == nullptr) {
+            // Nothing in flight: restart at the front to keep records contiguous
+            next_ = 0;
+        }
+
+        size_t oldest = oldest_live ? *oldest_live : capacity_;
+        size_t start = next_;
+
+        if (oldest_live == nullptr || start >= oldest) {
+            // Live region is [oldest, next_); free space is the tail, then the head
+            if (start + need <= capacity_) {
+                *offset = static_cast<uint32_t>(start);
+                next_ = start + need;
+                return true;
+            }
+            // Wrap, keeping one alignment unit between head and oldest so
+            // that next_ == oldest only ever means "empty"
+            if (oldest_live == nullptr || need < oldest) {
+                *offset = 0;
+                next_ = need;
+                return true;
+            }
+            return false;
+        }
+
+        // Already wrapped: free space is [next_, oldest)
+        if (start + need < oldest) {
+            *offset = static_cast<uint32_t>(start);
+            next_ = start + need;
+            return true;
+        }
+        return false;
+    }
+
+    uint8_t* At(uint32_t offset) { return data_.get() + offset; }
+    const uint8_t* At(uint32_t offset) const { return data_.get() + offset; }
+
+    size_t Capacity() const { return capacity_; }
+
+    // Bytes between the oldest live record and the cursor (producer side)
+    size_t Used(const uint32_t* oldest_live) const {
+        if (oldest_live == nullptr) {
+            return 0;
+        }
+        return next_ >= *oldest_live ? next_ - *oldest_live : capacity_ - *oldest_live + next_;
+    }
+
+    // Producer-side reset; only valid while nothing is in flight
+    void Reset() { next_ = 0; }
+
+private:
+    static size_t AlignUp(size_t v) {
+        return (v + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    const size_t capacity_;
+    NodeArray<uint8_t> data_;
+    size_t next_;  // producer-only allocation cursor
+};
+
+} // namespace WareHound
+
+#endif // PACKET_ARENA_H
@@ -5,8 +5,14 @@
 #include <cstdint>
 #include <cstring>
 #include <functional>
+#include <utility>
+#ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
 
 namespace WareHound {
 
@@ -63,10 +69,125 @@ enum class AppProtocol : uint8_t {
     QUIC
 };
 
+// TUNNEL TYPE - Innermost tunnel stripped by the parser
+enum class TunnelType : uint8_t {
+    NONE = 0,
+    GRE,
+    VXLAN,
+    GENEVE
+};
+
+// TUNNEL KEYING - Which IP header a tunnelled packet is keyed on
+enum class TunnelKeying : uint8_t {
+    Inner = 0,  // Decapsulate GRE/VXLAN/Geneve and key on the innermost flow
+    Outer       // Key on the tunnel endpoints
+};
+
+// DECAP CONFIG - How far the parser digs through encapsulation
+// VLAN tags and MPLS labels are always stripped; keying picks whether
+// tunnels are too. Each tag, label or tunnel counts one layer.
+struct DecapConfig {
+    TunnelKeying keying = TunnelKeying::Inner;
+    uint32_t maxDepth = 8;
+};
+
+// ENCAP INFO - Layers stripped to reach the keyed L3 header
+struct EncapInfo {
+    uint16_t l3_type = 0;          // Ethertype where the walk stopped (0x0800/0x86DD for IP)
+    uint32_t l3_offset = 0;        // From the start of the frame
+    uint8_t vlan_tags = 0;
+    uint8_t mpls_labels = 0;
+    TunnelType tunnel = TunnelType::NONE;
+    uint32_t tunnel_id = 0;        // VXLAN/Geneve VNI or GRE key
+    bool depth_exceeded = false;   // Stopped at maxDepth
+};
+
+// IP ADDRESS - 128-bit address in network byte order
+// IPv4 is held IPv4-mapped (::ffff:a.b.c.d), so one key type covers both
+struct IpAddress {
+    // Bytes 0-7 and 8-15 in memory order; two words rather than a byte
+    // array so keys built in registers stay there
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    static IpAddress FromV4(uint32_t ip) {
+        IpAddress addr;
+        uint8_t tail[8] = {0, 0, 0xFF, 0xFF};
+        memcpy(tail + 4, &ip, 4);
+        memcpy(&addr.low, tail, 8);
+        return addr;
+    }
+
+    static IpAddress FromV6(const uint8_t* ip) {
+        IpAddress addr;
+        memcpy(&addr.high, ip, 8);
+        memcpy(&addr.low, ip + 8, 8);
+        return addr;
+    }
+
+    const uint8_t* Bytes() const { return reinterpret_cast<const uint8_t*>(&high); }
+
+    bool IsV4() const {
+        static const uint8_t prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+        return memcmp(Bytes(), prefix, 12) == 0;
+    }
+
+    // Network byte order; only meaningful if IsV4()
+    uint32_t V4() const {
+        uint32_t ip;
+        memcpy(&ip, Bytes() + 12, 4);
+        return ip;
+    }
+
+    void ToString(char* buffer, size_t bufferSize) const {
+        const uint8_t* bytes = Bytes();
+        if (IsV4() && bufferSize >= 16) {
+            // Dotted quad by hand; inet_ntop costs more than the parse
+            char* p = buffer;
+            for (int i = 12; i < 16; i++) {
+                uint8_t octet = bytes[i];
+                if (octet >= 100) *p++ = static_cast<char>('0' + octet / 100);
+                if (octet >= 10) *p++ = static_cast<char>('0' + octet / 10 % 10);
+                *p++ = static_cast<char>('0' + octet % 10);
+                *p++ = i < 15 ? '.' : '\0';
+            }
+        } else if (IsV4()) {
+            inet_ntop(AF_INET, bytes + 12, buffer, static_cast<socklen_t>(bufferSize));
+        } else {
+            inet_ntop(AF_INET6, bytes, buffer, static_cast<socklen_t>(bufferSize));
+        }
+    }
+
+    bool operator==(const IpAddress& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const IpAddress& other) const { return !(*this == other); }
+    // memcmp order
+    bool operator<(const IpAddress& other) const {
+        uint64_t a = Be64(Bytes()), b = Be64(other.Bytes());
+        return a != b ? a < b : Be64(Bytes() + 8) < Be64(other.Bytes() + 8);
+    }
+
+private:
+    static uint64_t Be64(const uint8_t* p) {
+        return (static_cast<uint64_t>(p[0]) << 56) | (static_cast<uint64_t>(p[1]) << 48) |
+               (static_cast<uint64_t>(p[2]) << 40) | (static_cast<uint64_t>(p[3]) << 32) |
+               (static_cast<uint64_t>(p[4]) << 24) | (static_cast<uint64_t>(p[5]) << 16) |
+               (static_cast<uint64_t>(p[6]) << 8) | p[7];
+    }
+};
+
+// IP ADDRESS HASH
+struct IpAddressHash {
+    size_t operator()(const IpAddress& addr) const {
+        uint64_t h = addr.low ^ (addr.high * 0x9E3779B97F4A7C15ULL);
+        h ^= h >> 33; h *= 0xFF51AFD7ED558CCDULL; h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+};
+
 // FLOW KEY - Unique identifier for a network flow
 struct FlowKey {
-    uint32_t src_ip;
-    uint32_t dst_ip;
+    IpAddress src_ip;
+    IpAddress dst_ip;
     uint16_t src_port;
     uint16_t dst_port;
     uint8_t protocol;
@@ -79,8 +200,15 @@ struct FlowKey {
     
     // Create normalized key (smaller IP first for bidirectional matching)
     FlowKey Normalize() const {
+        return Normalized(src_ip, dst_ip, src_port, dst_port, protocol);
+    }
+    
+    // Orders the fields before the key is written, so it is stored once
+    // rather than written, reloaded and rewritten
+    static FlowKey Normalized(const IpAddress& src_ip, const IpAddress& dst_ip,
+                              uint16_t src_port, uint16_t dst_port, uint8_t protocol) {
         if (src_ip < dst_ip || (src_ip == dst_ip && src_port < dst_port)) {
-            return *this;
+            return FlowKey{src_ip, dst_ip, src_port, dst_port, protocol};
         }
         return FlowKey{dst_ip, src_ip, dst_port, src_port, protocol};
     }
@@ -88,21 +216,28 @@ struct FlowKey {
 
 
 // FLOW KEY HASH
+// Every key byte reaches every hash bit, low bits included, since open
+// addressing indexes on them (std::hash of an integer is the identity)
 struct FlowKeyHash {
     size_t operator()(const FlowKey& key) const {
-        size_t h1 = std::hash<uint32_t>()(key.src_ip);
-        size_t h2 = std::hash<uint32_t>()(key.dst_ip);
-        size_t h3 = std::hash<uint16_t>()(key.src_port);
-        size_t h4 = std::hash<uint16_t>()(key.dst_port);
-        size_t h5 = std::hash<uint8_t>()(key.protocol);
-        return h1 ^ (h2 << 1) ^ (h3 << 2) ^ (h4 << 3) ^ (h5 << 4);
+        uint64_t words[4] = {key.src_ip.high, key.src_ip.low, key.dst_ip.high, key.dst_ip.low};
+        uint64_t h = ((static_cast<uint64_t>(key.src_port) << 24) |
+                      (static_cast<uint64_t>(key.dst_port) << 8) | key.protocol) * 0x9E3779B97F4A7C15ULL;
+        for (uint64_t word : words) {
+            h ^= word * 0xC2B2AE3D27D4EB4FULL;
+            h = ((h << 31) | (h >> 33)) * 0x9E3779B97F4A7C15ULL;
+        }
+        h ^= h >> 33; h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
     }
 };
 
 // PARSED PACKET - Result of packet parsing
 struct ParsedPacket {
-    // Timestamps
-    uint64_t timestamp_us = 0;
+    // Timestamp, nanoseconds since the epoch
+    uint64_t timestamp_ns = 0;
     
     // Capture info
     uint32_t capture_len = 0;
@@ -111,7 +246,8 @@ struct ParsedPacket {
     // Ethernet
     uint8_t eth_src[6] = {0};
     uint8_t eth_dst[6] = {0};
-    uint16_t eth_type = 0;
+    uint16_t eth_type = 0;       // Of the keyed L3 header, after decapsulation
+    EncapInfo encap;
     
     // IP
     bool valid_ip = false;
@@ -121,10 +257,16 @@ struct ParsedPacket {
     uint16_t ip_total_len = 0;
     uint16_t ip_id = 0;
     uint8_t ip_ttl = 0;
-    uint8_t ip_protocol = 0;
+    uint8_t ip_protocol = 0;     // IPv6: the header after the extension chain
     uint32_t ip_src = 0;
     uint32_t ip_dst = 0;
     
+    // IPv6 addresses point into the packet, like payload
+    const uint8_t* ip6_src = nullptr;
+    const uint8_t* ip6_dst = nullptr;
+    uint16_t ip6_ext_len = 0;    // Extension header bytes after the fixed 40
+    bool ip_fragment = false;    // Part of a fragmented datagram
+    
     // Transport
     bool valid_transport = false;
     
@@ -148,58 +290,150 @@ struct ParsedPacket {
     
     // Convert to flow key
     FlowKey ToFlowKey() const {
-        FlowKey key;
-        key.src_ip = ip_src;
-        key.dst_ip = ip_dst;
-        key.protocol = ip_protocol;
-        
+        uint16_t src_port = 0;
+        uint16_t dst_port = 0;
         if (ip_protocol == IPPROTO_TCP) {
-            key.src_port = tcp_src_port;
-            key.dst_port = tcp_dst_port;
+            src_port = tcp_src_port;
+            dst_port = tcp_dst_port;
         } else if (ip_protocol == IPPROTO_UDP) {
-            key.src_port = udp_src_port;
-            key.dst_port = udp_dst_port;
-        } else {
-            key.src_port = 0;
-            key.dst_port = 0;
+            src_port = udp_src_port;
+            dst_port = udp_dst_port;
         }
         
-        return key.Normalize();
+        if (ip_version == 6) {
+            return FlowKey::Normalized(IpAddress::FromV6(ip6_src), IpAddress::FromV6(ip6_dst),
+                                       src_port, dst_port, ip_protocol);
+        }
+        return FlowKey::Normalized(IpAddress::FromV4(ip_src), IpAddress::FromV4(ip_dst),
+                                   src_port, dst_port, ip_protocol);
     }
 };
 
 
+// PACKET VIEW - Zero-copy alternative to ParsedPacket
+// Parse records where each layer starts; fields are decoded from the
+// original buffer when read, so callers pay only for what they use. The
+// view borrows the buffer and is valid only as long as it is.
+struct PacketView {
+    const uint8_t* data = nullptr;
+    uint64_t timestamp_ns = 0;
+    uint32_t capture_len = 0;
+    uint32_t original_len = 0;
+    EncapInfo encap;
+
+    uint32_t l4_offset = 0;       // From the start of the frame
+    uint32_t payload_offset = 0;  // == payload_end when there is no payload
+    uint32_t payload_end = 0;     // Capture, clipped to the IP and UDP lengths so link padding is left out
+    uint8_t ip_version = 0;
+    uint8_t ip_protocol = 0;      // IPv6: the header after the extension chain
+    bool valid_ip = false;
+    bool valid_transport = false;
+    bool ip_fragment = false;
+
+    // Ethernet
+    const uint8_t* EthDst() const { return data; }
+    const uint8_t* EthSrc() const { return data + 6; }
+    uint16_t EthType() const { return encap.l3_type; }
+
+    // IP (valid_ip)
+    const uint8_t* Ip() const { return data + encap.l3_offset; }
+    uint8_t IpTtl() const { return ip_version == 6 ? Ip()[7] : Ip()[8]; }
+    uint16_t IpId() const { return ip_version == 4 ? Be16(Ip() + 4) : 0; }
+    IpAddress IpSrc() const {
+        return ip_version == 6 ? IpAddress::FromV6(Ip() + 8) : IpAddress::FromV4(Read32(Ip() + 12));
+    }
+    IpAddress IpDst() const {
+        return ip_version == 6 ? IpAddress::FromV6(Ip() + 24) : IpAddress::FromV4(Read32(Ip() + 16));
+    }
+
+    // TCP and UDP (valid_transport)
+    const uint8_t* L4() const { return data + l4_offset; }
+    uint16_t SrcPort() const { return Be16(L4()); }
+    uint16_t DstPort() const { return Be16(L4() + 2); }
+
+    // TCP only
+    uint32_t TcpSeq() const { return Be32(L4() + 4); }
+    uint32_t TcpAck() const { return Be32(L4() + 8); }
+    uint8_t TcpHeaderLen() const { return ((L4()[12] >> 4) & 0x0F) * 4; }
+    uint8_t TcpFlags() const { return L4()[13]; }
+    uint16_t TcpWindow() const { return Be16(L4() + 14); }
+
+    // UDP only
+    uint16_t UdpLen() const { return Be16(L4() + 4); }
+
+    const uint8_t* Payload() const { return payload_offset < payload_end ? data + payload_offset : nullptr; }
+    uint32_t PayloadLen() const { return payload_end - payload_offset; }
+
+    // Same key ParsedPacket::ToFlowKey builds
+    FlowKey ToFlowKey() const {
+        if (valid_transport) {
+            return FlowKey::Normalized(IpSrc(), IpDst(), SrcPort(), DstPort(), ip_protocol);
+        }
+        return FlowKey::Normalized(IpSrc(), IpDst(), 0, 0, ip_protocol);
+    }
+
+private:
+    static uint16_t Be16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+    static uint32_t Be32(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+    static uint32_t Read32(const uint8_t* p) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+};
+
+
+// FRAGMENT INFO - Where one IP fragment's data sits in its frame
+// Offsets are from the start of the frame. A datagram is identified by
+// (src, dst, id, protocol, version).
+struct FragmentInfo {
+    IpAddress src;
+    IpAddress dst;
+    uint32_t id = 0;              // IPv4 identification or IPv6 fragment id
+    uint8_t version = 0;
+    uint8_t protocol = 0;         // IPv6: next header after the fragment header
+    bool more = false;            // More fragments follow this one
+    uint32_t offset = 0;          // Of this fragment's data within the datagram
+    uint32_t data_offset = 0;     // Where this fragment's data starts
+    uint32_t data_len = 0;        // As declared by the IP header; may exceed the capture
+    uint32_t fragment_header = 0; // IPv6: the fragment header, dropped on reassembly
+    uint32_t fragment_next = 0;   // IPv6: the next-header byte that names it
+};
+
 // PACKET PARSER - Parse raw packet data
 class PacketParser {
 public:
-    static bool Parse(const uint8_t* data, uint32_t len, uint64_t timestamp_us, 
-                      ParsedPacket& result) 
+    static bool Parse(const uint8_t* data, uint32_t len, uint64_t timestamp_ns, 
+                      ParsedPacket& result, const DecapConfig& decap = DecapConfig()) 
     {
         if (data == nullptr || len < 14) {
             return false;
         }
         
-        result.timestamp_us = timestamp_us;
+        result.timestamp_ns = timestamp_ns;
         result.capture_len = len;
         result.original_len = len;
         
         // Parse Ethernet header (14 bytes)
         memcpy(result.eth_dst, data, 6);
         memcpy(result.eth_src, data + 6, 6);
-        result.eth_type = (data[12] << 8) | data[13];
-        
-        const uint8_t* ip_data = data + 14;
-        uint32_t remaining = len - 14;
         
-        // Handle VLAN tagging (802.1Q)
-        if (result.eth_type == 0x8100 && remaining >= 4) {
-            result.eth_type = (ip_data[2] << 8) | ip_data[3];
-            ip_data += 4;
-            remaining -= 4;
-        }
+        // VLAN tags, MPLS labels and tunnels down to the keyed L3 header
+        LocateL3(data, len, decap, result.encap);
+        result.eth_type = result.encap.l3_type;
+        const uint8_t* ip_data = data + result.encap.l3_offset;
+        uint32_t remaining = len - result.encap.l3_offset;
         
-        // Only handle IPv4 for now
-        if (result.eth_type != 0x0800 || remaining < 20) {
+        if (result.eth_type == 0x0800) {
+            if (remaining < 20) {
+                return true;  // Valid Ethernet but not IP
+            }
+        } else if (result.eth_type == 0x86DD) {
+            ParseIPv6(ip_data, remaining, result);
+            return true;
+        } else {
             return true;  // Valid Ethernet but not IP
         }
         
@@ -216,16 +450,542 @@ public:
         result.ip_tos = ip_data[1];
         result.ip_total_len = (ip_data[2] << 8) | ip_data[3];
         result.ip_id = (ip_data[4] << 8) | ip_data[5];
+        result.ip_fragment = (((ip_data[6] << 8) | ip_data[7]) & 0x3FFF) != 0;
         result.ip_ttl = ip_data[8];
         result.ip_protocol = ip_data[9];
         memcpy(&result.ip_src, ip_data + 12, 4);
         memcpy(&result.ip_dst, ip_data + 16, 4);
         
-        const uint8_t* transport_data = ip_data + result.ip_header_len;
-        remaining -= result.ip_header_len;
+        // Link padding past the datagram is not payload
+        if (result.ip_total_len >= result.ip_header_len) {
+            remaining = (std::min)(remaining, static_cast<uint32_t>(result.ip_total_len));
+        }
+        
+        // Only the first fragment carries the L4 header
+        if ((((ip_data[6] << 8) | ip_data[7]) & 0x1FFF) == 0) {
+            ParseTransport(ip_data + result.ip_header_len, remaining - result.ip_header_len, result);
+        }
+        return true;
+    }
+
+    // PARSE (view) - Same validation as Parse, but only records offsets
+    static bool Parse(const uint8_t* data, uint32_t len, uint64_t timestamp_ns,
+                      PacketView& view, const DecapConfig& decap = DecapConfig())
+    {
+        if (data == nullptr || len < 14) {
+            return false;
+        }
+
+        view.data = data;
+        view.timestamp_ns = timestamp_ns;
+        view.capture_len = len;
+        view.original_len = len;
+        view.payload_offset = len;
+        view.payload_end = len;
+        LocateL3(data, len, decap, view.encap);
+
+        uint32_t offset = view.encap.l3_offset;
+        const uint8_t* ip_data = data + offset;
+        uint32_t remaining = len - offset;
+        uint32_t l4;
+        uint32_t end = len;   // Of the IP datagram, within the capture
+
+        if (view.encap.l3_type == 0x0800) {
+            if (remaining < 20) {
+                return true;
+            }
+            uint32_t ip_header_len = (ip_data[0] & 0x0F) * 4;
+            if ((ip_data[0] >> 4) != 4 || ip_header_len < 20 || remaining < ip_header_len) {
+                return true;
+            }
+            uint16_t fragment = (ip_data[6] << 8) | ip_data[7];
+            view.ip_version = 4;
+            view.ip_protocol = ip_data[9];
+            view.ip_fragment = (fragment & 0x3FFF) != 0;
+            if ((fragment & 0x1FFF) != 0) {
+                view.valid_ip = true;
+                return true;
+            }
+            l4 = offset + ip_header_len;
+            // A zero total length (segmentation offload) leaves the capture as is
+            uint32_t total_len = (ip_data[2] << 8) | ip_data[3];
+            if (total_len >= ip_header_len) {
+                end = (std::min)(len, offset + total_len);
+            }
+        } else if (view.encap.l3_type == 0x86DD) {
+            IPv6Chain chain;
+            if (!WalkIPv6(ip_data, remaining, chain)) {
+                return true;
+            }
+            view.ip_version = 6;
+            view.ip_protocol = chain.protocol;
+            view.ip_fragment = chain.fragment;
+            if (chain.later_fragment) {
+                view.valid_ip = true;
+                return true;
+            }
+            l4 = offset + chain.l4_offset;
+            // Zero for a jumbogram, whose length is in an option
+            uint32_t payload_len = (ip_data[4] << 8) | ip_data[5];
+            if (payload_len != 0) {
+                end = (std::min)(len, offset + 40 + payload_len);
+            }
+        } else {
+            return true;
+        }
+        view.valid_ip = true;
+
+        uint32_t l4_remaining = end > l4 ? end - l4 : 0;
+        if (view.ip_protocol == IPPROTO_TCP && l4_remaining >= 20) {
+            uint32_t tcp_header_len = ((data[l4 + 12] >> 4) & 0x0F) * 4;
+            if (tcp_header_len < 20) {
+                return true;
+            }
+            view.valid_transport = true;
+            view.l4_offset = l4;
+            view.payload_offset = l4_remaining > tcp_header_len ? l4 + tcp_header_len : end;
+            view.payload_end = end;
+        } else if (view.ip_protocol == IPPROTO_UDP && l4_remaining >= 8) {
+            uint32_t udp_len = (data[l4 + 4] << 8) | data[l4 + 5];
+            if (udp_len >= 8) {
+                end = (std::min)(end, l4 + udp_len);
+            }
+            view.valid_transport = true;
+            view.l4_offset = l4;
+            view.payload_offset = l4 + 8;
+            view.payload_end = end;
+        }
+        return true;
+    }
+
+    // FRAGMENT INFO - For a view with ip_fragment set; false if the declared
+    // lengths are inconsistent
+    static bool GetFragmentInfo(const PacketView& view, FragmentInfo& info) {
+        if (!view.valid_ip || !view.ip_fragment) {
+            return false;
+        }
+        const uint8_t* ip_data = view.Ip();
+        uint32_t l3 = view.encap.l3_offset;
+        info.src = view.IpSrc();
+        info.dst = view.IpDst();
+        info.version = view.ip_version;
+
+        if (view.ip_version == 4) {
+            uint32_t ip_header_len = (ip_data[0] & 0x0F) * 4;
+            uint32_t total_len = (ip_data[2] << 8) | ip_data[3];
+            uint16_t fragment = (ip_data[6] << 8) | ip_data[7];
+            if (total_len <= ip_header_len) {
+                return false;
+            }
+            info.id = (ip_data[4] << 8) | ip_data[5];
+            info.protocol = ip_data[9];
+            info.more = (fragment & 0x2000) != 0;
+            info.offset = (fragment & 0x1FFF) * 8;
+            info.data_offset = l3 + ip_header_len;
+            info.data_len = total_len - ip_header_len;
+            return true;
+        }
+
+        IPv6Chain chain;
+        if (!WalkIPv6(ip_data, view.capture_len - l3, chain) || !chain.fragment) {
+            return false;
+        }
+        const uint8_t* fragment = ip_data + chain.fragment_header;
+        uint32_t payload_end = 40 + ((ip_data[4] << 8) | ip_data[5]);
+        uint32_t data_start = chain.fragment_header + 8;
+        if (payload_end <= data_start) {
+            return false;
+        }
+        info.id = (static_cast<uint32_t>(fragment[4]) << 24) | (fragment[5] << 16) |
+                  (fragment[6] << 8) | fragment[7];
+        info.protocol = fragment[0];
+        info.more = (fragment[3] & 0x01) != 0;
+        info.offset = ((fragment[2] << 8) | fragment[3]) & 0xFFF8;
+        info.data_offset = l3 + data_start;
+        info.data_len = payload_end - data_start;
+        info.fragment_header = l3 + chain.fragment_header;
+        info.fragment_next = l3 + chain.fragment_next;
+        return true;
+    }
+
+    // SYMMETRIC FLOW HASH - Cheap shard selector for the capture thread
+    // Reads only the addresses and ports that FlowKey uses, ordered so both
+    // directions of a flow hash alike. Fragments after the first carry no
+    // ports, and a reassembled datagram is tracked in the fragments' shard,
+    // so UDP, which fragments routinely (EDNS, NFS, tunnels), hashes on
+    // addresses alone for every packet. TCP keeps its ports: it sets DF for
+    // path MTU discovery, and a segment that was fragmented anyway is
+    // tracked apart from the rest of its flow. Non-IP frames return 0.
+    // decap must match the one the flows are parsed with.
+    static uint32_t SymmetricFlowHash(const uint8_t* data, uint32_t len,
+                                      const DecapConfig& decap = DecapConfig()) {
+        if (data == nullptr || len < 14) {
+            return 0;
+        }
+
+        EncapInfo encap;
+        LocateL3(data, len, decap, encap);
+        uint16_t eth_type = encap.l3_type;
+        uint32_t offset = encap.l3_offset;
+        if (eth_type == 0x86DD) {
+            return SymmetricFlowHashIPv6(data + offset, len - offset);
+        }
+        if (eth_type != 0x0800 || len < offset + 20) {
+            return 0;
+        }
+
+        const uint8_t* ip_data = data + offset;
+        uint32_t ip_header_len = (ip_data[0] & 0x0F) * 4;
+        if (((ip_data[0] >> 4) & 0x0F) != 4 || ip_header_len < 20) {
+            return 0;
+        }
+
+        uint32_t src_ip, dst_ip;
+        memcpy(&src_ip, ip_data + 12, 4);
+        memcpy(&dst_ip, ip_data + 16, 4);
+        uint8_t protocol = ip_data[9];
+        bool fragmented = (((ip_data[6] << 8) | ip_data[7]) & 0x3FFF) != 0;
+
+        uint32_t ports = 0;
+        if (!fragmented && len >= offset + ip_header_len + 4) {
+            ports = SymmetricPorts(ip_data + ip_header_len, protocol);
+        }
+
+        uint64_t lo_ip = src_ip < dst_ip ? src_ip : dst_ip;
+        uint64_t hi_ip = src_ip < dst_ip ? dst_ip : src_ip;
+        return FinishFlowHash((lo_ip << 32) | hi_ip, ports, protocol);
+    }
+
+    // Bytes that may be captured for a non-IP frame (ARP, LLDP, ...)
+    static constexpr uint32_t MAX_OTHER_HEADER_LEN = 64;
+    // IPv6 extension headers kept by header-only capture
+    static constexpr uint32_t MAX_IPV6_EXT_LEN = 64;
+    // Outer headers of a tunnelled frame: QinQ, outer IPv6, UDP, Geneve
+    // with a few options and the inner Ethernet header
+    static constexpr uint32_t MAX_ENCAP_LEN = 128;
+    // Worst case Ethernet + 802.1Q + IPv6 with extension headers + TCP with
+    // options (IPv4 with options is shorter), inside MAX_ENCAP_LEN of tunnel
+    static constexpr uint32_t MAX_HEADER_LEN = MAX_ENCAP_LEN + 14 + 4 + 40 + MAX_IPV6_EXT_LEN + 60;
+
+    // HEADER LENGTH - End of the L2-L4 headers, for header-only capture
+    // Follows the same layers as Parse: TCP uses its data offset, UDP and
+    // ICMP their fixed headers. Later fragments and unknown transports stop
+    // after the IP header (IPv6: after its extension headers). Tunnels are
+    // followed as decap says. Never exceeds len.
+    static uint32_t HeaderLength(const uint8_t* data, uint32_t len,
+                                 const DecapConfig& decap = DecapConfig()) {
+        if (data == nullptr || len < 14) {
+            return len;
+        }
+
+        EncapInfo encap;
+        LocateL3(data, len, decap, encap);
+        uint16_t eth_type = encap.l3_type;
+        uint32_t offset = encap.l3_offset;
+
+        uint8_t protocol;
+        bool later_fragment;
+        if (eth_type == 0x0800) {
+            if (len < offset + 20) {
+                return len;
+            }
+            const uint8_t* ip_data = data + offset;
+            uint32_t ip_header_len = (ip_data[0] & 0x0F) * 4;
+            if (ip_header_len < 20) {
+                return offset;
+            }
+            offset += ip_header_len;
+            protocol = ip_data[9];
+            later_fragment = (((ip_data[6] << 8) | ip_data[7]) & 0x1FFF) != 0;
+        } else if (eth_type == 0x86DD) {
+            IPv6Chain chain;
+            if (!WalkIPv6(data + offset, len - offset, chain)) {
+                return len;
+            }
+            offset += chain.l4_offset;
+            protocol = chain.protocol;
+            later_fragment = chain.later_fragment;
+        } else {
+            // Anything inside a tunnel keeps the tunnel headers
+            uint32_t keep = offset > MAX_OTHER_HEADER_LEN ? offset : MAX_OTHER_HEADER_LEN;
+            return len < keep ? len : keep;
+        }
+
+        if (!later_fragment && len > offset) {
+            if (protocol == IPPROTO_TCP) {
+                uint32_t tcp_header_len = len >= offset + 13 ? ((data[offset + 12] >> 4) & 0x0F) * 4 : 20;
+                offset += tcp_header_len < 20 ? 20 : tcp_header_len;
+            } else if (protocol == IPPROTO_UDP || protocol == IPPROTO_ICMP || protocol == IPPROTO_ICMPV6) {
+                offset += 8;
+            }
+        }
+        return offset < len ? offset : len;
+    }
+
+    // DECAPSULATE - Walk from the Ethernet header to the keyed L3 header
+    // Strips 802.1Q/802.1ad tags, MPLS label stacks and, with inner keying,
+    // GRE, VXLAN and Geneve (including the Ethernet header they carry). At
+    // most decap.maxDepth layers are stripped, so a hostile stack costs a
+    // bounded amount of work. Requires len >= 14.
+    static void Decapsulate(const uint8_t* data, uint32_t len, const DecapConfig& decap, EncapInfo& info) {
+        uint16_t type = (data[12] << 8) | data[13];
+        uint32_t offset = 14;
+        for (uint32_t depth = 0; ; depth++) {
+            bool vlan = type == 0x8100 || type == 0x88A8 || type == 0x9100;
+            bool mpls = type == 0x8847 || type == 0x8848;
+            bool ip = type == 0x0800 || type == 0x86DD;
+            if (!vlan && !mpls && !(ip && decap.keying == TunnelKeying::Inner) && type != TEB_ETHERTYPE) {
+                break;
+            }
+            if (depth >= decap.maxDepth) {
+                info.depth_exceeded = true;
+                break;
+            }
+
+            if (vlan) {
+                if (len < offset + 4) {
+                    break;
+                }
+                type = (data[offset + 2] << 8) | data[offset + 3];
+                offset += 4;
+                info.vlan_tags++;
+            } else if (mpls) {
+                // One label per layer; the payload type is guessed from the
+                // IP version nibble after the bottom of the stack
+                if (len < offset + 4) {
+                    break;
+                }
+                bool bottom = (data[offset + 2] & 0x01) != 0;
+                offset += 4;
+                info.mpls_labels++;
+                if (bottom) {
+                    uint8_t version = len > offset ? data[offset] >> 4 : 0;
+                    type = version == 4 ? 0x0800 : version == 6 ? 0x86DD : 0;
+                }
+            } else if (ip) {
+                uint32_t inner_offset;
+                uint16_t inner_type;
+                if (!FindTunnel(data, len, offset, type, info, &inner_offset, &inner_type)) {
+                    break;
+                }
+                offset = inner_offset;
+                type = inner_type;
+            } else {
+                // Transparent Ethernet bridging: an inner Ethernet header
+                if (len < offset + 14) {
+                    break;
+                }
+                type = (data[offset + 12] << 8) | data[offset + 13];
+                offset += 14;
+            }
+        }
+        info.l3_type = type;
+        info.l3_offset = offset;
+    }
+
+private:
+    // Decapsulate with the common case kept inline: untagged IPv4 that
+    // cannot be a tunnel is already at its L3 header
+    static void LocateL3(const uint8_t* data, uint32_t len, const DecapConfig& decap, EncapInfo& info) {
+        if (len >= 34 && data[12] == 0x08 && data[13] == 0x00 &&
+            data[23] != IPPROTO_GRE && data[23] != IPPROTO_UDP) {
+            info.l3_type = 0x0800;
+            info.l3_offset = 14;
+            return;
+        }
+        Decapsulate(data, len, decap, info);
+    }
+
+    // Extension headers walked before giving up on a chain
+    static constexpr int MAX_IPV6_EXT_HEADERS = 8;
+
+    // GRE/Geneve protocol type for an encapsulated Ethernet frame
+    static constexpr uint16_t TEB_ETHERTYPE = 0x6558;
+    static constexpr uint16_t VXLAN_PORT = 4789;
+    static constexpr uint16_t GENEVE_PORT = 6081;
+
+    // FIND TUNNEL - If the IP header at offset carries GRE, VXLAN or Geneve,
+    // report where the encapsulated frame starts and its ethertype. Fragments
+    // are never decapsulated.
+    static bool FindTunnel(const uint8_t* data, uint32_t len, uint32_t offset, uint16_t type,
+                           EncapInfo& info, uint32_t* inner_offset, uint16_t* inner_type) {
+        uint8_t protocol;
+        uint32_t l4;
+        if (type == 0x0800) {
+            if (len < offset + 20) {
+                return false;
+            }
+            const uint8_t* ip_data = data + offset;
+            protocol = ip_data[9];
+            if ((protocol != IPPROTO_GRE && protocol != IPPROTO_UDP) ||
+                (((ip_data[6] << 8) | ip_data[7]) & 0x3FFF) != 0) {
+                return false;
+            }
+            uint32_t ip_header_len = (ip_data[0] & 0x0F) * 4;
+            if (ip_header_len < 20) {
+                return false;
+            }
+            l4 = offset + ip_header_len;
+        } else {
+            IPv6Chain chain;
+            if (!WalkIPv6(data + offset, len - offset, chain) || chain.fragment) {
+                return false;
+            }
+            protocol = chain.protocol;
+            l4 = offset + chain.l4_offset;
+        }
+
+        if (protocol == IPPROTO_GRE) {
+            // Version 0 only; optional checksum, key and sequence words
+            if (len < l4 + 4) {
+                return false;
+            }
+            uint16_t flags = (data[l4] << 8) | data[l4 + 1];
+            if ((flags & 0x4007) != 0) {
+                return false;  // Source routing or enhanced (PPTP) GRE
+            }
+            uint32_t header = 4;
+            uint32_t key = 0;
+            if (flags & 0x8000) header += 4;
+            if (flags & 0x2000) {
+                if (len < l4 + header + 4) {
+                    return false;
+                }
+                key = (static_cast<uint32_t>(data[l4 + header]) << 24) | (data[l4 + header + 1] << 16) |
+                      (data[l4 + header + 2] << 8) | data[l4 + header + 3];
+                header += 4;
+            }
+            if (flags & 0x1000) header += 4;
+            if (len < l4 + header) {
+                return false;
+            }
+            *inner_type = (data[l4 + 2] << 8) | data[l4 + 3];
+            *inner_offset = l4 + header;
+            info.tunnel = TunnelType::GRE;
+            info.tunnel_id = key;
+            return true;
+        }
+
+        if (protocol != IPPROTO_UDP || len < l4 + 16) {
+            return false;
+        }
+        uint16_t dst_port = (data[l4 + 2] << 8) | data[l4 + 3];
+        const uint8_t* tunnel = data + l4 + 8;
+        if (dst_port == VXLAN_PORT) {
+            if ((tunnel[0] & 0x08) == 0) {
+                return false;  // VNI not valid
+            }
+            *inner_type = TEB_ETHERTYPE;
+            *inner_offset = l4 + 16;
+            info.tunnel = TunnelType::VXLAN;
+        } else if (dst_port == GENEVE_PORT) {
+            if ((tunnel[0] >> 6) != 0) {
+                return false;  // Unknown version
+            }
+            uint32_t options = (tunnel[0] & 0x3F) * 4;
+            if (len < l4 + 16 + options) {
+                return false;
+            }
+            *inner_type = (tunnel[2] << 8) | tunnel[3];
+            *inner_offset = l4 + 16 + options;
+            info.tunnel = TunnelType::GENEVE;
+        } else {
+            return false;
+        }
+        info.tunnel_id = (static_cast<uint32_t>(tunnel[4]) << 16) | (tunnel[5] << 8) | tunnel[6];
+        return true;
+    }
+
+    // IPV6 CHAIN - Where the extension header chain ends
+    struct IPv6Chain {
+        uint8_t protocol = 0;         // Next header after the chain
+        uint32_t l4_offset = 40;      // From the start of the fixed header
+        bool fragment = false;
+        bool later_fragment = false;  // Fragment offset != 0: no L4 header
+        uint32_t fragment_header = 0; // Offset of the fragment header, if any
+        uint32_t fragment_next = 6;   // Offset of the next-header byte naming it
+    };
+
+    // Walks hop-by-hop, routing, fragment and destination-options headers.
+    // False if the fixed header or a walked extension header is truncated,
+    // or the chain is longer than MAX_IPV6_EXT_HEADERS.
+    static bool WalkIPv6(const uint8_t* ip_data, uint32_t remaining, IPv6Chain& chain) {
+        if (remaining < 40 || ((ip_data[0] >> 4) & 0x0F) != 6) {
+            return false;
+        }
+        uint8_t next = ip_data[6];
+        uint32_t offset = 40;
+        uint32_t next_at = 6;
+        for (int i = 0; i < MAX_IPV6_EXT_HEADERS; i++) {
+            switch (next) {
+                case 0:   // Hop-by-hop options
+                case 43:  // Routing
+                case 60:  // Destination options
+                    if (remaining < offset + 8) {
+                        return false;
+                    }
+                    next = ip_data[offset];
+                    next_at = offset;
+                    offset += (ip_data[offset + 1] + 1) * 8;
+                    break;
+                case 44:  // Fragment
+                    if (remaining < offset + 8) {
+                        return false;
+                    }
+                    chain.fragment = true;
+                    chain.later_fragment = (((ip_data[offset + 2] << 8) | ip_data[offset + 3]) & 0xFFF8) != 0;
+                    chain.fragment_header = offset;
+                    chain.fragment_next = next_at;
+                    next = ip_data[offset];
+                    next_at = offset;
+                    offset += 8;
+                    if (chain.later_fragment) {
+                        // The rest is fragment data, not headers
+                        chain.protocol = next;
+                        chain.l4_offset = offset;
+                        return true;
+                    }
+                    break;
+                default:
+                    chain.protocol = next;
+                    chain.l4_offset = offset;
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    static void ParseIPv6(const uint8_t* ip_data, uint32_t remaining, ParsedPacket& result) {
+        IPv6Chain chain;
+        if (!WalkIPv6(ip_data, remaining, chain)) {
+            return;
+        }
+
+        result.valid_ip = true;
+        result.ip_version = 6;
+        result.ip_header_len = 40;
+        result.ip6_ext_len = static_cast<uint16_t>(chain.l4_offset - 40);
+        result.ip_tos = static_cast<uint8_t>(((ip_data[0] & 0x0F) << 4) | (ip_data[1] >> 4));
+        result.ip_total_len = static_cast<uint16_t>(((ip_data[4] << 8) | ip_data[5]) + 40);
+        result.ip_ttl = ip_data[7];
+        result.ip_protocol = chain.protocol;
+        result.ip_fragment = chain.fragment;
+        result.ip6_src = ip_data + 8;
+        result.ip6_dst = ip_data + 24;
         
+        uint32_t payload_len = (ip_data[4] << 8) | ip_data[5];
+        if (payload_len != 0) {
+            remaining = (std::min)(remaining, 40 + payload_len);
+        }
+
+        if (!chain.later_fragment && remaining > chain.l4_offset) {
+            ParseTransport(ip_data + chain.l4_offset, remaining - chain.l4_offset, result);
+        }
+    }
+
+    static void ParseTransport(const uint8_t* transport_data, uint32_t remaining, ParsedPacket& result) {
         // Parse TCP
-        if (result.ip_protocol == IPPROTO_TCP && remaining >= 20) {
+        if (result.ip_protocol == IPPROTO_TCP && remaining >= 20 && (transport_data[12] >> 4) >= 5) {
             result.valid_transport = true;
             result.tcp_src_port = (transport_data[0] << 8) | transport_data[1];
             result.tcp_dst_port = (transport_data[2] << 8) | transport_data[3];
@@ -248,17 +1008,64 @@ public:
             result.udp_src_port = (transport_data[0] << 8) | transport_data[1];
             result.udp_dst_port = (transport_data[2] << 8) | transport_data[3];
             result.udp_len = (transport_data[4] << 8) | transport_data[5];
+            if (result.udp_len >= 8) {
+                remaining = (std::min)(remaining, static_cast<uint32_t>(result.udp_len));
+            }
             
             if (remaining > 8) {
                 result.payload = transport_data + 8;
                 result.payload_len = static_cast<uint16_t>(remaining - 8);
             }
         }
-        
-        return true;
+    }
+
+    static uint32_t SymmetricFlowHashIPv6(const uint8_t* ip_data, uint32_t remaining) {
+        IPv6Chain chain;
+        if (!WalkIPv6(ip_data, remaining, chain)) {
+            return 0;
+        }
+
+        // Order the addresses, then fold both into 64 bits
+        const uint8_t* lo_ip = ip_data + 8;
+        const uint8_t* hi_ip = ip_data + 24;
+        if (memcmp(lo_ip, hi_ip, 16) > 0) {
+            std::swap(lo_ip, hi_ip);
+        }
+        uint64_t words[4];
+        memcpy(words, lo_ip, 16);
+        memcpy(words + 2, hi_ip, 16);
+        uint64_t folded = words[0] ^ (words[1] * 0xC2B2AE3D27D4EB4FULL) ^
+                          ((words[2] ^ (words[3] * 0xC2B2AE3D27D4EB4FULL)) * 0x165667B19E3779F9ULL);
+
+        uint32_t ports = 0;
+        if (!chain.fragment && remaining >= chain.l4_offset + 4) {
+            ports = SymmetricPorts(ip_data + chain.l4_offset, chain.protocol);
+        }
+        return FinishFlowHash(folded, ports, chain.protocol);
+    }
+
+    // Lower port in the high half; 0 except for TCP
+    static uint32_t SymmetricPorts(const uint8_t* transport_data, uint8_t protocol) {
+        if (protocol != IPPROTO_TCP) {
+            return 0;
+        }
+        uint16_t src_port = (transport_data[0] << 8) | transport_data[1];
+        uint16_t dst_port = (transport_data[2] << 8) | transport_data[3];
+        uint16_t lo = src_port < dst_port ? src_port : dst_port;
+        uint16_t hi = src_port < dst_port ? dst_port : src_port;
+        return (static_cast<uint32_t>(lo) << 16) | hi;
+    }
+
+    static uint32_t FinishFlowHash(uint64_t h, uint32_t ports, uint8_t protocol) {
+        h ^= (static_cast<uint64_t>(ports) * 0x9E3779B97F4A7C15ULL) ^ protocol;
+        // splitmix64 finalizer
+        h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27; h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return static_cast<uint32_t>(h);
     }
 };
 
-} 
+}
 
 #endif 
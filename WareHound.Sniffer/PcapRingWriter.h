@@ -0,0 +1,375 @@
+#pragma once
+#ifndef PCAP_RING_WRITER_H
+#define PCAP_RING_WRITER_H
+
+#include "Sniffer.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Rolling capture-to-disk settings
+struct PcapRingOptions {
+    std::string directory = ".";
+    std::string filePrefix = "warehound";
+    uint64_t maxFileBytes = 64ull << 20;       // rotate after this many bytes
+    uint32_t maxFileSeconds = 0;               // rotate after this long (0 = never)
+    uint64_t maxTotalBytes = 1ull << 30;       // delete oldest files beyond this (0 = keep all)
+    size_t writeBufferBytes = 1u << 20;        // rounded up to WRITE_ALIGNMENT
+    uint32_t snaplen = 65535;
+    bool directIo = false;                     // O_DIRECT on Linux, ignored elsewhere; dropped for
+                                               // the rest of a file once an idle flush writes a partial buffer
+};
+
+struct PcapRingStats {
+    uint64_t packetsWritten = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t filesOpened = 0;
+    uint64_t filesDeleted = 0;
+    uint64_t writeErrors = 0;
+};
+
+// PCAP RING WRITER - Streams captured frames into rotated pcap files
+// Records are packed into one aligned buffer that goes to disk in whole
+// buffer-sized writes, so the file sees large sequential I/O regardless of
+// packet size. Only files this writer created count toward maxTotalBytes.
+// Runs on the delivering thread; register it async so disk stalls stay off
+// the dispatcher.
+class PcapRingWriterSubscriber : public IPacketSubscriber {
+public:
+    static constexpr size_t WRITE_ALIGNMENT = 4096;
+
+    explicit PcapRingWriterSubscriber(const PcapRingOptions& options = PcapRingOptions())
+        : options(options), fileBytes(0), fileSequence(0), totalBytes(0), fill(0)
+    {
+        size_t size = (options.writeBufferBytes + WRITE_ALIGNMENT - 1) & ~(WRITE_ALIGNMENT - 1);
+        bufferSize = size < WRITE_ALIGNMENT ? WRITE_ALIGNMENT : size;
+        storage.reset(new uint8_t[bufferSize + WRITE_ALIGNMENT]);
+        uintptr_t base = reinterpret_cast<uintptr_t>(storage.get());
+        buffer = reinterpret_cast<uint8_t*>((base + WRITE_ALIGNMENT - 1) & ~(WRITE_ALIGNMENT - 1));
+
+        std::error_code ec;
+        std::filesystem::create_directories(this->options.directory, ec);
+    }
+
+    ~PcapRingWriterSubscriber() override {
+        CloseFile();
+    }
+
+    PcapRingWriterSubscriber(const PcapRingWriterSubscriber&) = delete;
+    PcapRingWriterSubscriber& operator=(const PcapRingWriterSubscriber&) = delete;
+
+    void OnPacketCaptured(const tagSnapshot& packet) override {
+        const tagSnapshot* one = &packet;
+        OnPacketBatch(std::span<const tagSnapshot* const>(&one, 1));
+    }
+
+    void OnPacketBatch(std::span<const tagSnapshot* const> packets) override {
+        RotateIfExpired();
+        for (const tagSnapshot* packet : packets) {
+            WritePacket(*packet);
+        }
+    }
+
+    void OnHeartbeat(const Heartbeat&) override {
+        // Idle links still rotate on time; push what is buffered so the
+        // current file is readable while capture is quiet
+        RotateIfExpired();
+        if (file.IsOpen()) {
+            FlushBuffer();
+        }
+    }
+
+    PcapRingStats GetStats() const {
+        PcapRingStats stats;
+        stats.packetsWritten = packetsWritten.load(std::memory_order_relaxed);
+        stats.bytesWritten = bytesWritten.load(std::memory_order_relaxed);
+        stats.filesOpened = filesOpened.load(std::memory_order_relaxed);
+        stats.filesDeleted = filesDeleted.load(std::memory_order_relaxed);
+        stats.writeErrors = writeErrors.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    // PCAP FILE FORMAT - classic pcap with the nanosecond magic, host byte order
+    struct FileHeader {
+        uint32_t magic;
+        uint16_t versionMajor;
+        uint16_t versionMinor;
+        int32_t thisZone;
+        uint32_t sigFigs;
+        uint32_t snaplen;
+        uint32_t linkType;
+    };
+
+    struct RecordHeader {
+        uint32_t tsSec;
+        uint32_t tsNsec;
+        uint32_t inclLen;
+        uint32_t origLen;
+    };
+
+    // OUTPUT FILE - unbuffered OS handle; all buffering happens above
+    class OutputFile {
+    public:
+        OutputFile() = default;
+        ~OutputFile() { Close(); }
+
+        bool Open(const std::string& path, bool directIo) {
+#ifdef _WIN32
+            (void)directIo;
+            handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                                 FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            return handle != INVALID_HANDLE_VALUE;
+#else
+            int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+#ifdef O_DIRECT
+            if (directIo) {
+                flags |= O_DIRECT;
+            }
+#else
+            (void)directIo;
+#endif
+            fd = open(path.c_str(), flags, 0644);
+#ifdef O_DIRECT
+            if (fd < 0 && directIo) {
+                // Filesystems like tmpfs refuse O_DIRECT
+                fd = open(path.c_str(), flags & ~O_DIRECT, 0644);
+            }
+#endif
+            return fd >= 0;
+#endif
+        }
+
+        bool Write(const uint8_t* data, size_t len) {
+            while (len > 0) {
+#ifdef _WIN32
+                DWORD written = 0;
+                if (!WriteFile(handle, data, static_cast<DWORD>(len), &written, nullptr) || written == 0) {
+                    return false;
+                }
+#else
+                ssize_t written = write(fd, data, len);
+                if (written <= 0) {
+                    if (written < 0 && errno == EINTR) continue;
+                    return false;
+                }
+#endif
+                data += written;
+                len -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+
+        // The tail of a file is rarely block sized, which O_DIRECT rejects
+        void DisableDirectIo() {
+#if !defined(_WIN32) && defined(O_DIRECT)
+            int flags = fcntl(fd, F_GETFL);
+            if (flags >= 0 && (flags & O_DIRECT)) {
+                fcntl(fd, F_SETFL, flags & ~O_DIRECT);
+            }
+#endif
+        }
+
+        bool IsOpen() const {
+#ifdef _WIN32
+            return handle != INVALID_HANDLE_VALUE;
+#else
+            return fd >= 0;
+#endif
+        }
+
+        void Close() {
+#ifdef _WIN32
+            if (handle != INVALID_HANDLE_VALUE) {
+                CloseHandle(handle);
+                handle = INVALID_HANDLE_VALUE;
+            }
+#else
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+#endif
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+        int fd = -1;
+#endif
+    };
+
+    void WritePacket(const tagSnapshot& packet) {
+        uint32_t inclLen = packet.capture_len < options.snaplen ? packet.capture_len : options.snaplen;
+        uint64_t recordBytes = sizeof(RecordHeader) + inclLen;
+
+        if (file.IsOpen() && options.maxFileBytes > 0 && fileBytes + recordBytes > options.maxFileBytes) {
+            CloseFile();
+        }
+        if (!file.IsOpen() && !OpenFile()) {
+            return;
+        }
+
+        RecordHeader header;
+        header.tsSec = static_cast<uint32_t>(packet.timestamp_ns / 1000000000ULL);
+        header.tsNsec = static_cast<uint32_t>(packet.timestamp_ns % 1000000000ULL);
+        header.inclLen = inclLen;
+        header.origLen = packet.original_len;
+        Append(&header, sizeof(header));
+        Append(packet.raw_data, inclLen);
+
+        fileBytes += recordBytes;
+        packetsWritten.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Copies into the aligned buffer, writing it out each time it fills
+    void Append(const void* data, size_t len) {
+        const uint8_t* src = static_cast<const uint8_t*>(data);
+        while (len > 0) {
+            size_t chunk = bufferSize - fill;
+            if (chunk > len) chunk = len;
+            memcpy(buffer + fill, src, chunk);
+            fill += chunk;
+            src += chunk;
+            len -= chunk;
+            if (fill == bufferSize) {
+                FlushBuffer();
+            }
+        }
+    }
+
+    // Full buffers keep O_DIRECT alignment; a partial flush only happens at
+    // close or on an idle heartbeat, and drops O_DIRECT for the rest of the
+    // file (the next file opens with it again)
+    void FlushBuffer() {
+        if (fill == 0) {
+            return;
+        }
+        if (fill != bufferSize) {
+            file.DisableDirectIo();
+        }
+        if (file.Write(buffer, fill)) {
+            bytesWritten.fetch_add(fill, std::memory_order_relaxed);
+        } else {
+            writeErrors.fetch_add(1, std::memory_order_relaxed);
+        }
+        fill = 0;
+    }
+
+    bool OpenFile() {
+        std::string path = NextPath();
+        if (!file.Open(path, options.directIo)) {
+            writeErrors.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "[PcapRingWriter] Cannot open " << path << std::endl;
+            return false;
+        }
+
+        FileHeader header;
+        header.magic = 0xA1B23C4D;
+        header.versionMajor = 2;
+        header.versionMinor = 4;
+        header.thisZone = 0;
+        header.sigFigs = 0;
+        header.snaplen = options.snaplen;
+        header.linkType = 1;  // DLT_EN10MB
+        Append(&header, sizeof(header));
+
+        currentPath = path;
+        fileBytes = sizeof(header);
+        fileOpened = std::chrono::steady_clock::now();
+        filesOpened.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void CloseFile() {
+        if (!file.IsOpen()) {
+            return;
+        }
+        FlushBuffer();
+        file.Close();
+
+        closedFiles.push_back({currentPath, fileBytes});
+        totalBytes += fileBytes;
+        fileBytes = 0;
+        EnforceTotalLimit();
+    }
+
+    void RotateIfExpired() {
+        if (options.maxFileSeconds == 0 || !file.IsOpen()) {
+            return;
+        }
+        if (std::chrono::steady_clock::now() - fileOpened >= std::chrono::seconds(options.maxFileSeconds)) {
+            CloseFile();
+        }
+    }
+
+    // Oldest files go first; the file being written is never deleted
+    void EnforceTotalLimit() {
+        if (options.maxTotalBytes == 0) {
+            return;
+        }
+        while (!closedFiles.empty() && totalBytes > options.maxTotalBytes) {
+            std::error_code ec;
+            std::filesystem::remove(closedFiles.front().path, ec);
+            if (!ec) {
+                filesDeleted.fetch_add(1, std::memory_order_relaxed);
+            }
+            totalBytes -= closedFiles.front().bytes;
+            closedFiles.pop_front();
+        }
+    }
+
+    // <prefix>_<YYYYmmdd_HHMMSS>_<seq>.pcap, so names also sort by age
+    std::string NextPath() {
+        time_t now = time(nullptr);
+        struct tm local;
+#ifdef _WIN32
+        localtime_s(&local, &now);
+#else
+        localtime_r(&now, &local);
+#endif
+        char stamp[32];
+        strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local);
+        char name[64];
+        snprintf(name, sizeof(name), "_%s_%05u.pcap", stamp, fileSequence++);
+        return (std::filesystem::path(options.directory) / (options.filePrefix + name)).string();
+    }
+
+    struct ClosedFile {
+        std::string path;
+        uint64_t bytes;
+    };
+
+    PcapRingOptions options;
+    OutputFile file;
+    std::string currentPath;
+    uint64_t fileBytes;
+    uint32_t fileSequence;
+    std::chrono::steady_clock::time_point fileOpened;
+    std::deque<ClosedFile> closedFiles;
+    uint64_t totalBytes;
+
+    std::unique_ptr<uint8_t[]> storage;
+    uint8_t* buffer;
+    size_t bufferSize;
+    size_t fill;
+
+    std::atomic<uint64_t> packetsWritten{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    std::atomic<uint64_t> filesOpened{0};
+    std::atomic<uint64_t> filesDeleted{0};
+    std::atomic<uint64_t> writeErrors{0};
+};
+
+#endif // PCAP_RING_WRITER_H
@@ -13,26 +13,17 @@ public:
     
     // DETECT - Main detection function
     static AppProtocol Detect(const ParsedPacket& packet, uint8_t* confidence = nullptr) {
-        AppProtocol result = AppProtocol::UNKNOWN;
         uint8_t conf = 0;
-        
-        // Method 1: By port (fast)
-        result = DetectByPort(packet, &conf);
-        
-        // Method 2: By signature (if payload exists and port detection uncertain)
-        if (packet.payload != nullptr && packet.payload_len > 0) {
-            uint8_t sig_conf = 0;
-            AppProtocol sig_result = DetectBySignature(packet.payload, packet.payload_len, &sig_conf);
-            
-            // Signature has priority if found
-            if (sig_result != AppProtocol::UNKNOWN && sig_conf >= conf) {
-                result = sig_result;
-                conf = sig_conf;
-            }
-        }
-        
-        if (confidence) *confidence = conf;
-        return result;
+        AppProtocol result = DetectByPort(packet, &conf);
+        return Detect(result, conf, packet.payload, packet.payload_len, confidence);
+    }
+    
+    // Reads only the ports and payload bounds from the view
+    static AppProtocol Detect(const PacketView& packet, uint8_t* confidence = nullptr) {
+        uint8_t conf = 0;
+        AppProtocol result = DetectByPort(packet, &conf);
+        uint32_t payload_len = (std::min)(packet.PayloadLen(), static_cast<uint32_t>(0xFFFF));
+        return Detect(result, conf, packet.Payload(), static_cast<uint16_t>(payload_len), confidence);
     }
     
     //=========================================================================
@@ -46,7 +37,20 @@ public:
         } else if (packet.ip_protocol == IPPROTO_UDP) {
             port = (std::min)(packet.udp_src_port, packet.udp_dst_port);
         }
+        return DetectByPort(port, confidence);
+    }
+    
+    static AppProtocol DetectByPort(const PacketView& packet, uint8_t* confidence = nullptr) {
+        uint16_t port = 0;
         
+        if (packet.valid_transport) {
+            port = (std::min)(packet.SrcPort(), packet.DstPort());
+        }
+        return DetectByPort(port, confidence);
+    }
+    
+    // Lower of the two ports, 0 if there are none
+    static AppProtocol DetectByPort(uint16_t port, uint8_t* confidence = nullptr) {
         if (confidence) *confidence = 70;  // Default 70% confidence for port
         
         // Well-known ports
@@ -275,6 +279,25 @@ public:
             default:                      return "UNKNOWN";
         }
     }
+
+private:
+    // Method 1 (port) has already run; Method 2 (signature) may override it
+    static AppProtocol Detect(AppProtocol result, uint8_t conf, const uint8_t* payload,
+                              uint16_t payload_len, uint8_t* confidence) {
+        if (payload != nullptr && payload_len > 0) {
+            uint8_t sig_conf = 0;
+            AppProtocol sig_result = DetectBySignature(payload, payload_len, &sig_conf);
+            
+            // Signature has priority if found
+            if (sig_result != AppProtocol::UNKNOWN && sig_conf >= conf) {
+                result = sig_result;
+                conf = sig_conf;
+            }
+        }
+        
+        if (confidence) *confidence = conf;
+        return result;
+    }
 };
 
 } 
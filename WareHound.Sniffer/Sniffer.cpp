@@ -4,21 +4,39 @@
 #include "handleProto.h"
 #include "FlowTracker.h"
 #include <shared_mutex>
+#include <unordered_map>
 #include <fstream>
+#include <ctime>
+#ifdef _WIN32
 #include <ws2tcpip.h>  // for inet_ntop
+#else
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
 
-// Forward declaration for statistics integration
-extern void ProcessPacketForStats(const uint8_t* data, uint32_t len, uint64_t timestamp_us);
-
-// DNS Cache
-static std::map<std::string, std::string> g_dnsCache;
+// Forward declarations for statistics integration
+extern void ProcessPacketForStats(size_t shardIndex, const WareHound::PacketView& packet);
+extern void SetStatsShardCount(size_t shardCount);
+extern void SetStatsDecapConfig(const WareHound::DecapConfig& decap);
+extern void SetStatsFlowEviction(WareHound::FlowEvictionPolicy policy);
+extern void SetBackpressureStatsProvider(std::function<std::vector<BackpressureStats>()> provider);
+extern void SetFilterStatsProvider(std::function<FilterStats()> provider);
+extern void SetCaptureSettingsProvider(std::function<CaptureSettings()> provider);
+
+// DNS Cache - keyed on the binary address so lookups build no strings
+static std::unordered_map<WareHound::IpAddress, std::string, WareHound::IpAddressHash> g_dnsCache;
 static std::shared_mutex g_dnsCacheMutex;
 static const size_t MAX_DNS_CACHE_SIZE = 10000;
 
-static void addToDnsCache(const std::string& ip, const std::string& hostname) {
+static void addToDnsCache(const WareHound::IpAddress& ip, const std::string& hostname) {
     std::unique_lock<std::shared_mutex> lock(g_dnsCacheMutex);
     if (g_dnsCache.size() >= MAX_DNS_CACHE_SIZE) {
-        // Remove oldest entry (first in map)
+        // Remove an arbitrary entry
         if (!g_dnsCache.empty()) {
             g_dnsCache.erase(g_dnsCache.begin());
         }
@@ -26,7 +44,7 @@ static void addToDnsCache(const std::string& ip, const std::string& hostname) {
     g_dnsCache[ip] = hostname;
 }
 
-static bool lookupDnsCache(const std::string& ip, char* output, int max_len) {
+static bool lookupDnsCache(const WareHound::IpAddress& ip, char* output, int max_len) {
     std::shared_lock<std::shared_mutex> lock(g_dnsCacheMutex);
     auto it = g_dnsCache.find(ip);
     if (it != g_dnsCache.end() && !it->second.empty()) {
@@ -192,19 +210,13 @@ static void parse_dns_response(const u_char* dns_data, size_t dns_data_len, cons
         
         // A record (IPv4)
         if (rtype == 1 && rclass == 1 && rdlength == 4) {
-            char ip_str[INET_ADDRSTRLEN];
-            struct in_addr addr;
+            uint32_t addr;
             memcpy(&addr, dns_data + offset, 4);
-            inet_ntop(AF_INET, &addr, ip_str, INET_ADDRSTRLEN);
-            addToDnsCache(ip_str, hostname);
+            addToDnsCache(WareHound::IpAddress::FromV4(addr), hostname);
         }
         // AAAA record (IPv6)
         else if (rtype == 28 && rclass == 1 && rdlength == 16) {
-            char ip_str[INET6_ADDRSTRLEN];
-            struct in6_addr addr;
-            memcpy(&addr, dns_data + offset, 16);
-            inet_ntop(AF_INET6, &addr, ip_str, INET6_ADDRSTRLEN);
-            addToDnsCache(ip_str, hostname);
+            addToDnsCache(WareHound::IpAddress::FromV6(dns_data + offset), hostname);
         }
         
         offset += rdlength;
@@ -212,219 +224,876 @@ static void parse_dns_response(const u_char* dns_data, size_t dns_data_len, cons
 }
 
 
+// Called first thing on each pipeline thread
+static void PinThread(const char* name, int core) {
+    if (core == WareHound::ANY_CORE) {
+        return;
+    }
+    if (!WareHound::PinCurrentThread(core)) {
+        std::cerr << "[" << name << "] Could not pin thread to core " << core << std::endl;
+    }
+}
+
+// WaitSignal Implementation
+
+void WaitSignal::NotifyIfWaiting() {
+    if (waiting.load(std::memory_order_relaxed)) {
+        sequence.fetch_add(1, std::memory_order_release);
+        sequence.notify_all();
+    }
+}
+
+void WaitSignal::NotifyAll() {
+    sequence.fetch_add(1, std::memory_order_release);
+    sequence.notify_all();
+}
+
 // PacketBuffer Implementation
 
-PacketBuffer::PacketBuffer(size_t maxSize) : maxSize(maxSize) {}
+PacketBuffer::PacketBuffer(size_t capacity, size_t arenaBytes, std::shared_ptr<WaitSignal> dataSignal, int numaNode)
+    : ring(capacity, numaNode), arena(arenaBytes, numaNode), shutdown(false),
+      dataSignal(dataSignal ? std::move(dataSignal) : std::make_shared<WaitSignal>()),
+      policy(BackpressurePolicy::Block), sampleRate(1), sampleThreshold(0), sampleCounter(0),
+      droppedFull(0), droppedOldest(0), droppedSampled(0), producerStalls(0), pressure(0), highWater(0) {}
 
-void PacketBuffer::Push(const tagSnapshot& item) {
-    std::unique_lock<std::mutex> lock(mutex);
-    notFull.wait(lock, [this] { return queue.size() < maxSize; });
-    queue.push(item);
-    lock.unlock();
-    notEmpty.notify_one();
+void PacketBuffer::SetPolicy(BackpressurePolicy policy, uint32_t sampleRate, uint32_t sampleThresholdPercent) {
+    this->policy = policy;
+    this->sampleRate = sampleRate < 1 ? 1 : sampleRate;
+    this->sampleThreshold = (std::min)(sampleThresholdPercent, 100u) * 10;
 }
 
-bool PacketBuffer::Pop(tagSnapshot& item) {
-    std::unique_lock<std::mutex> lock(mutex);
-    notEmpty.wait(lock, [this] { return !queue.empty(); });
-    item = queue.front();
-    queue.pop();
-    lock.unlock();
-    notFull.notify_one();
-    return true;
+// DropOldest consumers lock the tail slot so the producer cannot evict it
+size_t PacketBuffer::Peek(const tagSnapshot** out, size_t max) {
+    return policy == BackpressurePolicy::DropOldest ? ring.TryAcquireBatch(out, max) : ring.TryPeekBatch(out, max);
+}
+
+// Producer-side pressure: whichever of slots and arena bytes is fuller,
+// measured on each successful claim
+void PacketBuffer::NotePressure(const tagSnapshot* oldest) {
+    size_t slots = (ring.Size() + 1) * 1000 / ring.Capacity();
+    size_t bytes = arena.Used(oldest ? &oldest->raw_offset : nullptr) * 1000 / arena.Capacity();
+    uint32_t permille = static_cast<uint32_t>((std::max)(slots, bytes));
+    pressure.store(permille, std::memory_order_relaxed);
+    if (permille > highWater.load(std::memory_order_relaxed)) {
+        highWater.store(permille, std::memory_order_relaxed);
+    }
+}
+
+tagSnapshot* PacketBuffer::TryClaim(uint32_t rawLen, uint8_t** raw) {
+    tagSnapshot* slot = ring.TryClaim();
+    if (!slot) {
+        return nullptr;
+    }
+    // The oldest in-flight slot marks where live arena data begins
+    const tagSnapshot* oldest = ring.OldestInFlight();
+    uint32_t offset = 0;
+    if (!arena.Allocate(rawLen, oldest ? &oldest->raw_offset : nullptr, &offset)) {
+        return nullptr;
+    }
+    slot->raw_offset = offset;
+    slot->raw_data = arena.At(offset);
+    slot->capture_len = rawLen;
+    *raw = arena.At(offset);
+    NotePressure(oldest);
+    return slot;
+}
+
+tagSnapshot* PacketBuffer::BeginPush(uint32_t rawLen, uint8_t** raw) {
+    if (rawLen > WareHound::PacketArena::MAX_RECORD) {
+        rawLen = WareHound::PacketArena::MAX_RECORD;
+    }
+    if (policy == BackpressurePolicy::Sample && pressure.load(std::memory_order_relaxed) >= sampleThreshold &&
+        !ring.IsEmpty()) {
+        if (++sampleCounter % sampleRate != 0) {
+            droppedSampled.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+    for (int spin = 0; ; ++spin) {
+        if (shutdown.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        if (tagSnapshot* slot = TryClaim(rawLen, raw)) {
+            return slot;
+        }
+        if (policy == BackpressurePolicy::DropOldest && ring.TryDropOldest()) {
+            droppedOldest.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (policy != BackpressurePolicy::Block) {
+            // Nothing evictable (or not allowed to evict): lose this packet
+            droppedFull.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (spin < SPIN_COUNT) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (spin == SPIN_COUNT) {
+            producerStalls.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Park until the consumer frees a slot or arena space
+        uint32_t seen = spaceSignal.sequence.load(std::memory_order_acquire);
+        spaceSignal.waiting.store(true, std::memory_order_seq_cst);
+        if (tagSnapshot* slot = TryClaim(rawLen, raw)) {
+            spaceSignal.waiting.store(false, std::memory_order_relaxed);
+            return slot;
+        }
+        if (!shutdown.load(std::memory_order_acquire)) {
+            spaceSignal.sequence.wait(seen, std::memory_order_acquire);
+        }
+        spaceSignal.waiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+void PacketBuffer::CommitPush() {
+    ring.Publish();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    dataSignal->NotifyIfWaiting();
+}
+
+const tagSnapshot* PacketBuffer::BeginPop() {
+    const tagSnapshot* slot = nullptr;
+    return BeginPopBatch(&slot, 1) ? slot : nullptr;
+}
+
+const tagSnapshot* PacketBuffer::TryBeginPop() {
+    const tagSnapshot* slot = nullptr;
+    return TryBeginPopBatch(&slot, 1) ? slot : nullptr;
+}
+
+void PacketBuffer::EndPop() {
+    EndPopBatch(1);
+}
+
+size_t PacketBuffer::BeginPopBatch(const tagSnapshot** out, size_t max) {
+    for (int spin = 0; ; ++spin) {
+        if (shutdown.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        if (size_t count = Peek(out, max)) {
+            return count;
+        }
+        if (spin < SPIN_COUNT) {
+            std::this_thread::yield();
+            continue;
+        }
+        // Park until the producer publishes a slot
+        uint32_t seen = dataSignal->sequence.load(std::memory_order_acquire);
+        dataSignal->waiting.store(true, std::memory_order_seq_cst);
+        if (ring.IsEmpty() && !shutdown.load(std::memory_order_acquire)) {
+            dataSignal->sequence.wait(seen, std::memory_order_acquire);
+        }
+        dataSignal->waiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+size_t PacketBuffer::TryBeginPopBatch(const tagSnapshot** out, size_t max) {
+    if (shutdown.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    return Peek(out, max);
+}
+
+void PacketBuffer::EndPopBatch(size_t count) {
+    ring.Release(count);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    spaceSignal.NotifyIfWaiting();
+}
+
+void PacketBuffer::Shutdown() {
+    shutdown.store(true, std::memory_order_release);
+    dataSignal->NotifyAll();
+    spaceSignal.NotifyAll();
+}
+
+void PacketBuffer::Reset() {
+    ring.Reset();
+    arena.Reset();
+    sampleCounter = 0;
+    droppedFull.store(0, std::memory_order_relaxed);
+    droppedOldest.store(0, std::memory_order_relaxed);
+    droppedSampled.store(0, std::memory_order_relaxed);
+    producerStalls.store(0, std::memory_order_relaxed);
+    pressure.store(0, std::memory_order_relaxed);
+    highWater.store(0, std::memory_order_relaxed);
+    shutdown.store(false, std::memory_order_release);
+}
+
+BackpressureStats PacketBuffer::GetStats() const {
+    BackpressureStats stats;
+    stats.droppedFull = droppedFull.load(std::memory_order_relaxed);
+    stats.droppedOldest = droppedOldest.load(std::memory_order_relaxed);
+    stats.droppedSampled = droppedSampled.load(std::memory_order_relaxed);
+    stats.producerStalls = producerStalls.load(std::memory_order_relaxed);
+    stats.occupancy = ring.Size();
+    stats.capacity = ring.Capacity();
+    // Arena fill is only known as of the last push; an empty ring holds nothing
+    stats.occupancyPercent = stats.occupancy == 0 ? 0.0 : pressure.load(std::memory_order_relaxed) / 10.0;
+    stats.highWaterPercent = highWater.load(std::memory_order_relaxed) / 10.0;
+    return stats;
+}
+
+bool PacketBuffer::IsShutdown() const {
+    return shutdown.load(std::memory_order_acquire);
 }
 
 bool PacketBuffer::IsFull() const {
-    std::lock_guard<std::mutex> lock(mutex);
-    return queue.size() >= maxSize;
+    return ring.IsFull();
 }
 
 bool PacketBuffer::IsEmpty() const {
-    std::lock_guard<std::mutex> lock(mutex);
-    return queue.empty();
+    return ring.IsEmpty();
+}
+
+size_t PacketBuffer::Size() const {
+    return ring.Size();
+}
+
+size_t PacketBuffer::Capacity() const {
+    return ring.Capacity();
+}
+
+// CaptureWaiter Implementation
+
+#ifdef _WIN32
+
+CaptureWaiter::CaptureWaiter() : pcapEvent(nullptr), wakeEvent(CreateEventW(nullptr, FALSE, FALSE, nullptr)) {}
+
+CaptureWaiter::~CaptureWaiter() {
+    if (wakeEvent) {
+        CloseHandle(wakeEvent);
+    }
+}
+
+bool CaptureWaiter::Attach(WareHound::ICaptureSource& source) {
+    pcapEvent = source.GetEvent();
+    return pcapEvent != nullptr && wakeEvent != nullptr;
+}
+
+CaptureWaiter::Result CaptureWaiter::Wait(int timeoutMs) {
+    HANDLE handles[2] = { wakeEvent, pcapEvent };
+    DWORD res = WaitForMultipleObjects(2, handles, FALSE, static_cast<DWORD>(timeoutMs));
+    if (res == WAIT_OBJECT_0) return Result::Woken;
+    if (res == WAIT_OBJECT_0 + 1) return Result::Readable;
+    return Result::Timeout;
+}
+
+void CaptureWaiter::Wake() {
+    if (wakeEvent) {
+        SetEvent(wakeEvent);
+    }
+}
+
+#else
+
+CaptureWaiter::CaptureWaiter() : pcapFd(-1), wakeFds{-1, -1} {
+#ifdef __linux__
+    wakeFds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+    if (pipe(wakeFds) == 0) {
+        fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+    }
+#endif
+}
+
+CaptureWaiter::~CaptureWaiter() {
+    for (int fd : wakeFds) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+bool CaptureWaiter::Attach(WareHound::ICaptureSource& source) {
+    pcapFd = source.GetSelectableFd();
+    return pcapFd >= 0 && wakeFds[0] >= 0;
+}
+
+CaptureWaiter::Result CaptureWaiter::Wait(int timeoutMs) {
+    struct pollfd fds[2];
+    fds[0].fd = wakeFds[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = pcapFd;
+    fds[1].events = POLLIN;
+
+    int res = poll(fds, 2, timeoutMs);
+    if (res <= 0) {
+        return Result::Timeout;
+    }
+    if (fds[0].revents & POLLIN) {
+        uint64_t drain;
+        while (read(wakeFds[0], &drain, sizeof(drain)) > 0) {}
+        return Result::Woken;
+    }
+    return Result::Readable;
 }
 
-PacketCapturer::PacketCapturer(std::shared_ptr<PacketBuffer> buffer, HANDLE eventHandle) 
-    : buffer(buffer), _eventHandles(eventHandle) {
+void CaptureWaiter::Wake() {
+    uint64_t one = 1;
+#ifdef __linux__
+    ssize_t res = write(wakeFds[0], &one, sizeof(one));
+#else
+    ssize_t res = write(wakeFds[1], &one, 1);
+#endif
+    (void)res;
+}
 
+#endif
+
+// PacketCapturer Implementation
+
+PacketCapturer::PacketCapturer(std::vector<std::shared_ptr<PacketBuffer>> outputs, HANDLE eventHandle,
+                               const CaptureConfig& config) 
+    : _eventHandles(eventHandle), buffer(outputs.front()), config(config), packetCount(0),
+      eventDriven(false), nanoTimestamps(false), heartbeatSequence(0), capturing(false), filterPending(false),
+      filterSwaps(0), kernelReceived(0), kernelDropped(0), filteredPackets(0), filteredCounted(false),
+      packetCountBase(0), lastStatsSample(0) {
+
+    if (config.workerCount > 0) {
+        // Input arenas split the default budget, like the output buffers
+        size_t arenaBytes = WareHound::PacketArena::DEFAULT_CAPACITY / outputs.size();
+        for (size_t i = 0; i < outputs.size(); i++) {
+            int core = config.threading.WorkerCore(i);
+            workers.push_back(std::make_unique<CaptureWorker>(i, outputs[i], arenaBytes, config.decap,
+                                                              core, config.threading.NodeOf(core)));
+            workers.back()->Input().SetPolicy(config.backpressure, static_cast<uint32_t>(config.sampleRate));
+        }
+    } else {
+        inlineProcessor = std::make_unique<PacketProcessor>(buffer, 0, config.decap);
+    }
+    SetStatsShardCount(outputs.size());
+    SetStatsDecapConfig(config.decap);
+    SetStatsFlowEviction(config.flowEviction);
 }
 
 PacketCapturer::~PacketCapturer() {
     Stop();
 }
 
-void PacketCapturer::Start(pcap_t* handle, std::atomic<bool>& running, HANDLE eventHandle) {
-    captureThread = std::thread(&PacketCapturer::CaptureLoop, this, handle, std::ref(running), eventHandle);
+void PacketCapturer::Start(std::shared_ptr<WareHound::ICaptureSource> source, std::atomic<bool>& running, HANDLE eventHandle) {
+    for (auto& worker : workers) {
+        worker->Start();
+    }
+    {
+        std::lock_guard<std::mutex> lock(filterMutex);
+        this->source = source;
+        capturing = source != nullptr;
+    }
+    captureThread = std::thread(&PacketCapturer::CaptureLoop, this, source, std::ref(running), eventHandle);
 }
 
 void PacketCapturer::Stop() {
+    Wake();
+    // Unblock a capture thread stuck on a full worker input first
+    for (auto& worker : workers) {
+        worker->Input().Shutdown();
+    }
     if (captureThread.joinable()) {
         captureThread.join();
     }
+    for (auto& worker : workers) {
+        worker->Stop();
+    }
+}
+
+void PacketCapturer::Wake() {
+    waiter.Wake();
+}
+
+void PacketCapturer::CollectStats(std::vector<BackpressureStats>& out) const {
+    for (const auto& worker : workers) {
+        out.push_back(worker->Input().GetStats());
+    }
 }
 
-void PacketCapturer::CaptureLoop(pcap_t* handle, std::atomic<bool>& running, HANDLE eventHandle) {
+void PacketCapturer::CaptureLoop(std::shared_ptr<WareHound::ICaptureSource> source, std::atomic<bool>& running, HANDLE eventHandle) {
+    PinThread("CaptureLoop", config.threading.captureCore);
+    std::cout << "[CaptureLoop] Starting capture loop (batch size " << config.batchSize
+              << ", workers " << workers.size() << ")..." << std::endl;
+
+    while (running && !source) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    if (source) {
+        // Live sources switch to non-blocking reads and park on the selectable
+        // fd/event; otherwise reads block up to the kernel read timeout
+        eventDriven = false;
+        nanoTimestamps = source->NanosecondTimestamps();
+        if (!source->IsOffline() && waiter.Attach(*source)) {
+            eventDriven = source->SetNonBlocking(true);
+        }
+        lastActivity = std::chrono::steady_clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(filterMutex);
+            if (!config.filter.empty() && !source->SetFilter(config.filter)) {
+                std::cerr << "[CaptureLoop] Filter \"" << config.filter << "\" not installed: "
+                          << source->GetError() << std::endl;
+            }
+        }
+        statsBase = WareHound::CaptureSourceStats();
+        source->GetStats(statsBase);
+        packetCountBase = packetCount;
+        lastStatsSample = packetCount;
+
+        if (config.batchSize > 1) {
+            BatchCaptureLoop(*source, running);
+        } else {
+            SingleCaptureLoop(*source, running);
+        }
+
+        SampleSourceStats(*source);
+        if (eventDriven) {
+            source->SetNonBlocking(false);
+        }
+
+        // From here SetFilter applies directly; settle a swap that raced the exit
+        std::lock_guard<std::mutex> lock(filterMutex);
+        capturing = false;
+        ApplyPendingFilterLocked(*source);
+    }
+    std::cout << "[CaptureLoop] Exiting capture loop after " << packetCount << " packets." << std::endl;
+}
+
+void PacketCapturer::SingleCaptureLoop(WareHound::ICaptureSource& source, std::atomic<bool>& running) {
     int res;
     struct pcap_pkthdr* pkthdr;
     const u_char* packetd_ptr;
-    int packet_count = 0;
-
-    std::cout << "[CaptureLoop] Starting capture loop..." << std::endl;
 
     while (running) {
-        if (!handle) {
-             std::this_thread::sleep_for(std::chrono::milliseconds(100));
-             continue;
+        if (filterPending.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(filterMutex);
+            ApplyPendingFilterLocked(source);
         }
 
-        res = pcap_next_ex(handle, &pkthdr, &packetd_ptr);
+        res = source.Next(&pkthdr, &packetd_ptr);
         
-        if (res == 0) {
+        if (res > 0) {
+            ProcessPacket(pkthdr, packetd_ptr);
+            if (packetCount - lastStatsSample >= STATS_SAMPLE_PACKETS) {
+                SampleSourceStats(source);
+            }
+        }
+        else if (res == 0) {
+            WaitForPackets();
+        }
+        else if (res == PCAP_ERROR_BREAK && source.IsOffline()) {
+            // End of savefile
+            break;
+        }
+        else {
+            // Error
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            tagSnapshot new_item; 
-            parserHelper.defaultToStruct(new_item); 
-            buffer->Push(new_item);
-            continue;
         }
+    }
+}
+
+// Drains up to batchSize packets per source call straight into the ring
+void PacketCapturer::BatchCaptureLoop(WareHound::ICaptureSource& source, std::atomic<bool>& running) {
+    u_char* self = reinterpret_cast<u_char*>(this);
+
+    while (running) {
+        if (filterPending.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(filterMutex);
+            ApplyPendingFilterLocked(source);
+        }
+
+        int res = source.Dispatch(config.batchSize, &PacketCapturer::DispatchHandler, self);
 
         if (res > 0) {
-            packet_count++;
-            if (packet_count == 1) {
-                std::cout << "[CaptureLoop] First packet captured! caplen=" << pkthdr->caplen << ", len=" << pkthdr->len << std::endl;
+            if (packetCount - lastStatsSample >= STATS_SAMPLE_PACKETS) {
+                SampleSourceStats(source);
             }
-            ProcessPacket(pkthdr, packetd_ptr);
+            continue;
         }
-        else if (res == 0) {
-            // Timeout
+
+        if (res == 0) {
+            if (source.IsOffline()) {
+                // pcap_dispatch returns 0 at the end of a savefile
+                break;
+            }
+            WaitForPackets();
+        }
+        else if (res == PCAP_ERROR_BREAK) {
             continue;
         }
         else {
-            // Error or EOF
+            std::cerr << "[CaptureLoop] Dispatch failed: " << source.GetError() << std::endl;
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
     }
-    std::cout << "[CaptureLoop] Exiting capture loop." << std::endl;
+}
+
+// Nothing was read: park until packets arrive, Wake() or the heartbeat is due
+void PacketCapturer::WaitForPackets() {
+    auto interval = std::chrono::milliseconds(config.heartbeatIntervalMs);
+    auto idle = std::chrono::steady_clock::now() - lastActivity;
+
+    if (idle >= interval) {
+        PushHeartbeat();
+        if (source) {
+            SampleSourceStats(*source);
+        }
+        lastActivity = std::chrono::steady_clock::now();
+        idle = std::chrono::steady_clock::duration::zero();
+    }
+
+    if (eventDriven) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(interval - idle);
+        waiter.Wait(static_cast<int>(remaining.count()) + 1);
+    }
+    // Blocking handles already waited out the kernel read timeout
+}
+
+bool PacketCapturer::SetFilter(const std::string& expression) {
+    // One swap in flight at a time
+    std::lock_guard<std::mutex> serial(filterCallMutex);
+    std::future<bool> result;
+    {
+        std::lock_guard<std::mutex> lock(filterMutex);
+        if (!capturing) {
+            if (source && !source->SetFilter(expression)) {
+                return false;
+            }
+            config.filter = expression;
+            return true;
+        }
+        pendingFilter = expression;
+        filterResult = std::promise<bool>();
+        result = filterResult.get_future();
+        filterPending.store(true, std::memory_order_release);
+    }
+    // An idle capture thread is parked on the waiter
+    Wake();
+    return result.get();
+}
+
+void PacketCapturer::ApplyPendingFilterLocked(WareHound::ICaptureSource& source) {
+    if (!filterPending.load(std::memory_order_relaxed)) {
+        return;
+    }
+    bool installed = source.SetFilter(pendingFilter);
+    if (installed) {
+        // Later restarts keep the new filter
+        config.filter = pendingFilter;
+        filterSwaps.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        std::cerr << "[CaptureLoop] Filter \"" << pendingFilter << "\" rejected: " << source.GetError() << std::endl;
+    }
+    filterPending.store(false, std::memory_order_relaxed);
+    filterResult.set_value(installed);
+}
+
+// Kernel counters are polled from the capture thread, which owns the source
+void PacketCapturer::SampleSourceStats(WareHound::ICaptureSource& source) {
+    lastStatsSample = packetCount;
+    WareHound::CaptureSourceStats now;
+    if (!source.GetStats(now)) {
+        return;
+    }
+    uint64_t received = now.received >= statsBase.received ? now.received - statsBase.received : 0;
+    uint64_t dropped = now.dropped >= statsBase.dropped ? now.dropped - statsBase.dropped : 0;
+    kernelReceived.store(received, std::memory_order_relaxed);
+    kernelDropped.store(dropped, std::memory_order_relaxed);
+
+    // Whatever the kernel saw but neither dropped nor handed to us was filtered
+    if (now.receivedBeforeFilter) {
+        uint64_t accepted = dropped + (packetCount - packetCountBase);
+        filteredPackets.store(received > accepted ? received - accepted : 0, std::memory_order_relaxed);
+    }
+    filteredCounted.store(now.receivedBeforeFilter, std::memory_order_relaxed);
+}
+
+FilterStats PacketCapturer::GetFilterStats() const {
+    FilterStats stats;
+    {
+        std::lock_guard<std::mutex> lock(filterMutex);
+        stats.expression = config.filter;
+    }
+    stats.swaps = filterSwaps.load(std::memory_order_relaxed);
+    stats.kernelReceived = kernelReceived.load(std::memory_order_relaxed);
+    stats.kernelDropped = kernelDropped.load(std::memory_order_relaxed);
+    stats.filtered = filteredPackets.load(std::memory_order_relaxed);
+    stats.filteredCounted = filteredCounted.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void PacketCapturer::DispatchHandler(u_char* user, const struct pcap_pkthdr* pkthdr, const u_char* packet) {
+    reinterpret_cast<PacketCapturer*>(user)->ProcessPacket(pkthdr, packet);
+}
+
+void PacketCapturer::PushHeartbeat() {
+    // Sharded heartbeats travel through worker 0 so they stay ordered with its packets
+    PacketBuffer& target = workers.empty() ? *buffer : workers.front()->Input();
+    uint8_t* raw = nullptr;
+    tagSnapshot* item = target.BeginPush(sizeof(Heartbeat), &raw);
+    if (!item) {
+        return;
+    }
+    Heartbeat heartbeat;
+    heartbeat.magic = HEARTBEAT_MAGIC;
+    heartbeat.sequence = ++heartbeatSequence;
+    heartbeat.timestamp_sec = static_cast<uint64_t>(std::time(nullptr));
+    heartbeat.packets_captured = packetCount;
+    memcpy(raw, &heartbeat, sizeof(Heartbeat));
+
+    item->kind = SNAPSHOT_HEARTBEAT;
+    item->original_len = 0;
+    target.CommitPush();
 }
 
 void PacketCapturer::ProcessPacket(const struct pcap_pkthdr* pkthdr, const u_char* packet) {
+    lastActivity = std::chrono::steady_clock::now();
+    if (++packetCount == 1) {
+        std::cout << "[CaptureLoop] First packet captured! caplen=" << pkthdr->caplen << ", len=" << pkthdr->len << std::endl;
+    }
 
-    // Process packet for native statistics (FlowTracker)
-    uint64_t timestamp_us = static_cast<uint64_t>(pkthdr->ts.tv_sec) * 1000000 + pkthdr->ts.tv_usec;
-    ProcessPacketForStats(packet, pkthdr->caplen, timestamp_us);
+    // Everything downstream sees the trimmed frame; len keeps the wire size
+    struct pcap_pkthdr header = *pkthdr;
+    header.caplen = CaptureLength(pkthdr, packet);
+    uint64_t timestamp_ns = static_cast<uint64_t>(pkthdr->ts.tv_sec) * 1000000000ULL +
+                            static_cast<uint64_t>(pkthdr->ts.tv_usec) * (nanoTimestamps ? 1 : 1000);
 
-    int link_hdr_length = 0; 
-    
-    const u_char* packetd_ptr = packet;
-    struct ether_header* eptr = (struct ether_header*)packetd_ptr;
-    struct ip* ip_hdr = (struct ip*)(packetd_ptr + sizeof(struct ether_header));
+    if (workers.empty()) {
+        inlineProcessor->Process(&header, packet, timestamp_ns);
+    } else {
+        ShardPacket(&header, packet, timestamp_ns);
+    }
+}
+
+// Seconds/microseconds stay for readers that predate timestamp_ns
+static void SetSnapshotTime(tagSnapshot& item, uint64_t timestamp_ns) {
+    item.timestamp_ns = timestamp_ns;
+    item.timestamp_sec = timestamp_ns / 1000000000ULL;
+    item.timestamp_usec = static_cast<uint32_t>((timestamp_ns % 1000000000ULL) / 1000);
+}
+
+uint32_t PacketCapturer::CaptureLength(const struct pcap_pkthdr* pkthdr, const u_char* packet) const {
+    uint32_t len = (std::min)(pkthdr->caplen, config.snaplen);
+    if (config.headersOnly) {
+        len = (std::min)(len, WareHound::PacketParser::HeaderLength(packet, len, config.decap) + config.payloadPrefix);
+    }
+    return len;
+}
+
+// Sharded mode: the capture thread only hashes and copies the frame
+void PacketCapturer::ShardPacket(const struct pcap_pkthdr* pkthdr, const u_char* packet, uint64_t timestamp_ns) {
+    uint32_t hash = WareHound::PacketParser::SymmetricFlowHash(packet, pkthdr->caplen, config.decap);
+    PacketBuffer& input = workers[hash % workers.size()]->Input();
+
+    uint32_t copy_len = (pkthdr->caplen > 65536) ? 65536 : pkthdr->caplen;
+    uint8_t* raw = nullptr;
+    tagSnapshot* item = input.BeginPush(copy_len, &raw);
+    if (!item) {
+        return;
+    }
+    item->kind = SNAPSHOT_PACKET;
+    item->original_len = pkthdr->len;
+    SetSnapshotTime(*item, timestamp_ns);
+    memcpy(raw, packet, copy_len);
+
+    input.CommitPush();
+}
+
+// PacketProcessor Implementation
+
+PacketProcessor::PacketProcessor(std::shared_ptr<PacketBuffer> output, size_t statsShard,
+                                 const WareHound::DecapConfig& decap)
+    : output(output), statsShard(statsShard), decap(decap) {
+    handleProto pointers;
+    pointers.protoStr = protoStr;
+    pointers._src_port = &protoSrcPort;
+    pointers._dst_port = &protoDstPort;
+    protoNames = std::make_unique<handleProto>(&pointers);
+}
 
-    char packet_srcip[INET_ADDRSTRLEN];
-    char packet_dstip[INET_ADDRSTRLEN];
-    strcpy(packet_srcip, inet_ntoa(ip_hdr->ip_src));
-    strcpy(packet_dstip, inet_ntoa(ip_hdr->ip_dst));
+void PacketProcessor::Forward(const tagSnapshot& source) {
+    uint8_t* raw = nullptr;
+    tagSnapshot* item = output->BeginPush(source.capture_len, &raw);
+    if (!item) {
+        return;
+    }
+    memcpy(item, &source, sizeof(SnapshotHeader));
+    item->kind = source.kind;
+    memcpy(raw, source.raw_data, source.capture_len);
+    output->CommitPush();
+}
 
-    char source_mac[32]; 
-    char dest_mac[32];
-    ether_ntoa(eptr->ether_shost, source_mac, sizeof(source_mac));
-    ether_ntoa(eptr->ether_dhost, dest_mac, sizeof(dest_mac));
+// Address text for a 22-byte snapshot field; IPv6 longer than that is cut
+static void FormatAddress(const WareHound::IpAddress& ip, char* out, size_t outSize) {
+    char text[INET6_ADDRSTRLEN];
+    ip.ToString(text, sizeof(text));
+    strncpy(out, text, outSize - 1);
+    out[outSize - 1] = '\0';
+}
+
+void PacketProcessor::Process(const struct pcap_pkthdr* pkthdr, const u_char* packet, uint64_t timestamp_ns) {
+    // One parse feeds the native statistics and every field below
+    WareHound::PacketView view;
+    if (!WareHound::PacketParser::Parse(packet, pkthdr->caplen, timestamp_ns, view, decap)) {
+        view.timestamp_ns = timestamp_ns;
+    }
+    view.original_len = (std::max)(pkthdr->len, pkthdr->caplen);
+
+    // Process packet for native statistics (FlowTracker)
+    ProcessPacketForStats(statsShard, view);
+
+    char packet_srcip[22] = "";
+    char packet_dstip[22] = "";
+    WareHound::IpAddress src_ip;
+    WareHound::IpAddress dst_ip;
+    if (view.valid_ip) {
+        src_ip = view.IpSrc();
+        dst_ip = view.IpDst();
+        FormatAddress(src_ip, packet_srcip, sizeof(packet_srcip));
+        FormatAddress(dst_ip, packet_dstip, sizeof(packet_dstip));
+    }
+
+    char source_mac[32] = "";
+    char dest_mac[32] = "";
+    if (view.data) {
+        ether_ntoa(view.EthSrc(), source_mac, sizeof(source_mac));
+        ether_ntoa(view.EthDst(), dest_mac, sizeof(dest_mac));
+    }
 
     char host_names[22];
     strcpy(host_names, ""); 
 
-    int packet_id = ntohs(ip_hdr->ip_id);
-    int protocol_type = ip_hdr->ip_p;
+    int packet_id = view.valid_ip ? view.IpId() : 0;
+    int protocol_type = view.ip_protocol;
     
-    int src_port = 0;
-    int dst_port = 0;
-
-    if (protocol_type == IPPROTO_TCP) {
-        struct sniff_tcp* tcpip_header = (struct sniff_tcp*)(packetd_ptr + sizeof(struct ether_header) + sizeof(struct ip));
-        dst_port = ntohs(tcpip_header->th_dport);
-        src_port = ntohs(tcpip_header->th_sport);
-
-        if (!lookupDnsCache(packet_dstip, host_names, sizeof(host_names))) {
-            lookupDnsCache(packet_srcip, host_names, sizeof(host_names));
-        }
-    }
-    else if (protocol_type == IPPROTO_UDP) {
-        struct sniff_udp* udp_header = (struct sniff_udp*)(packetd_ptr + sizeof(struct ether_header) + sizeof(struct ip));
-        src_port = ntohs(udp_header->uh_sport);
-        dst_port = ntohs(udp_header->uh_dport);
-
-        if (src_port == 53 || dst_port == 53) {
-            // Calculate DNS payload location and size
-            const u_char* dns_data = (u_char*)udp_header + sizeof(struct sniff_udp);
-            size_t udp_len = ntohs(udp_header->uh_len);
-
-            // Validate UDP length
-            if (udp_len > sizeof(struct sniff_udp) + sizeof(struct dns_header)) {
-                size_t dns_data_len = udp_len - sizeof(struct sniff_udp);
-                struct dns_header* dns = (struct dns_header*)dns_data;
-
-                // Check for valid DNS query/response
-                uint16_t qdcount = ntohs(dns->qdcount);
-                if (qdcount > 0 && qdcount < 100) {
-                    int offset = sizeof(struct dns_header);
-                    if (extract_dns_name(dns_data, dns_data_len, offset, host_names, sizeof(host_names))) {
-                        // For DNS responses (from port 53), parse answer section to cache IP->hostname
-                        if (src_port == 53) {
-                            parse_dns_response(dns_data, dns_data_len, host_names);
-                        }
+    int src_port = view.valid_transport ? view.SrcPort() : 0;
+    int dst_port = view.valid_transport ? view.DstPort() : 0;
+
+    if (protocol_type == IPPROTO_UDP && view.valid_transport && (src_port == 53 || dst_port == 53)) {
+        // DNS payload, bounded by both the UDP length and what was captured
+        const u_char* dns_data = view.Payload();
+        size_t udp_len = view.UdpLen();
+        size_t dns_data_len = udp_len > sizeof(struct sniff_udp) ? udp_len - sizeof(struct sniff_udp) : 0;
+        dns_data_len = (std::min)(dns_data_len, static_cast<size_t>(view.PayloadLen()));
+
+        if (dns_data && dns_data_len > sizeof(struct dns_header)) {
+            struct dns_header* dns = (struct dns_header*)dns_data;
+
+            // Check for valid DNS query/response
+            uint16_t qdcount = ntohs(dns->qdcount);
+            if (qdcount > 0 && qdcount < 100) {
+                int offset = sizeof(struct dns_header);
+                if (extract_dns_name(dns_data, dns_data_len, offset, host_names, sizeof(host_names))) {
+                    // For DNS responses (from port 53), parse answer section to cache IP->hostname
+                    if (src_port == 53) {
+                        parse_dns_response(dns_data, dns_data_len, host_names);
                     }
                 }
             }
         }
-        else {
-            // Non-DNS UDP - try cache lookup
-            if (!lookupDnsCache(packet_dstip, host_names, sizeof(host_names))) {
-                lookupDnsCache(packet_srcip, host_names, sizeof(host_names));
-            }
-        }
     }
-    else {
-        // ICMP or other protocols - try cache lookup
-        if (!lookupDnsCache(packet_dstip, host_names, sizeof(host_names))) {
-            lookupDnsCache(packet_srcip, host_names, sizeof(host_names));
+    else if (view.valid_ip) {
+        // Everything else - try cache lookup
+        if (!lookupDnsCache(dst_ip, host_names, sizeof(host_names))) {
+            lookupDnsCache(src_ip, host_names, sizeof(host_names));
         }
     }
 
-    // Use handleProto class to resolve protocol name
-    char protoStr[22] = "UNKNOWN";
-    handleProto protoHandler;
-    handleProto* pHandler = &protoHandler;
-    protoHandler.protoStr = protoStr;
-    protoHandler._src_port = &src_port;
-    protoHandler._dst_port = &dst_port;
-    
-    // Initialize and call the handler
-    handleProto hp(pHandler);
-    
-    auto it = hp.caseMap.find(protocol_type);
-    if (it != hp.caseMap.end()) {
-        it->second();
-    } else {
-        snprintf(protoStr, 22, "PROTO-%d", protocol_type);
+    // Resolve protocol name through the handleProto table built at construction
+    strcpy(protoStr, "UNKNOWN");
+    if (view.valid_ip) {
+        protoSrcPort = src_port;
+        protoDstPort = dst_port;
+        auto it = protoNames->caseMap.find(protocol_type);
+        if (it != protoNames->caseMap.end()) {
+            it->second();
+        } else {
+            snprintf(protoStr, sizeof(protoStr), "PROTO-%d", protocol_type);
+        }
+    } else if (view.EthType() == 0x0806) {
+        strcpy(protoStr, "ARP");
     }
 
-    tagSnapshot item;
-    parserHelper.addToStruct(protoStr, packet_srcip, packet_dstip, source_mac, dest_mac, packet_id, dst_port, src_port, host_names, item);
+    // Fill the ring slot in place; the arena reserves only caplen bytes.
+    // nullptr means the buffer is shutting down.
+    uint32_t copy_len = (pkthdr->caplen > 65536) ? 65536 : pkthdr->caplen;
+    uint8_t* raw = nullptr;
+    tagSnapshot* item = output->BeginPush(copy_len, &raw);
+    if (!item) {
+        return;
+    }
+    parserHelper.addToStruct(protoStr, packet_srcip, packet_dstip, source_mac, dest_mac, packet_id, dst_port, src_port, host_names, *item);
+    item->kind = SNAPSHOT_PACKET;
     
     // Store raw packet data for PCAP save functionality
-    item.capture_len = pkthdr->caplen;
-    item.original_len = pkthdr->len;
-    item.timestamp_sec = static_cast<uint64_t>(pkthdr->ts.tv_sec);
-    item.timestamp_usec = static_cast<uint32_t>(pkthdr->ts.tv_usec);
+    item->original_len = pkthdr->len;
+    SetSnapshotTime(*item, timestamp_ns);
+    memcpy(raw, packet, copy_len);
     
-    // Copy raw packet bytes (limited to 65536 max)
-    uint32_t copy_len = (pkthdr->caplen > 65536) ? 65536 : pkthdr->caplen;
-    memcpy(item.raw_data, packet, copy_len);
-    
-    buffer->Push(item);
+    output->CommitPush();
+}
+
+// CaptureWorker Implementation
+
+CaptureWorker::CaptureWorker(size_t index, std::shared_ptr<PacketBuffer> output, size_t inputArenaBytes,
+                             const WareHound::DecapConfig& decap, int core, int numaNode)
+    : input(4096, inputArenaBytes, nullptr, numaNode), processor(output, index, decap), core(core) {}
+
+CaptureWorker::~CaptureWorker() {
+    input.Shutdown();
+    Stop();
+}
+
+void CaptureWorker::Start() {
+    input.Reset();
+    workerThread = std::thread(&CaptureWorker::WorkLoop, this);
+}
+
+void CaptureWorker::Stop() {
+    if (workerThread.joinable()) {
+        workerThread.join();
+    }
+}
+
+void CaptureWorker::WorkLoop() {
+    PinThread("CaptureWorker", core);
+    const tagSnapshot* items[64];
+    while (size_t count = input.BeginPopBatch(items, 64)) {
+        for (size_t i = 0; i < count; i++) {
+            const tagSnapshot* item = items[i];
+            if (item->kind == SNAPSHOT_PACKET) {
+                struct pcap_pkthdr pkthdr;
+                pkthdr.ts.tv_sec = static_cast<decltype(pkthdr.ts.tv_sec)>(item->timestamp_sec);
+                pkthdr.ts.tv_usec = static_cast<decltype(pkthdr.ts.tv_usec)>(item->timestamp_usec);
+                pkthdr.caplen = item->capture_len;
+                pkthdr.len = item->original_len;
+                processor.Process(&pkthdr, item->raw_data, item->timestamp_ns);
+            } else {
+                processor.Forward(*item);
+            }
+        }
+        input.EndPopBatch(count);
+    }
+}
+
+// Runs of packets go out as one OnPacketBatch; heartbeats keep their place
+static void DeliverBatch(IPacketSubscriber& sub, const tagSnapshot* const* items, size_t count) {
+    size_t runStart = 0;
+    for (size_t i = 0; i <= count; i++) {
+        if (i < count && items[i]->kind != SNAPSHOT_HEARTBEAT) {
+            continue;
+        }
+        if (i > runStart) {
+            sub.OnPacketBatch(std::span<const tagSnapshot* const>(items + runStart, i - runStart));
+        }
+        if (i < count) {
+            sub.OnHeartbeat(*reinterpret_cast<const Heartbeat*>(items[i]->raw_data));
+        }
+        runStart = i + 1;
+    }
 }
 
 // PacketDispatcher Implementation
-PacketDispatcher::PacketDispatcher(std::shared_ptr<PacketBuffer> buffer) 
-    : buffer(buffer) {}
+PacketDispatcher::PacketDispatcher(std::vector<std::shared_ptr<PacketBuffer>> buffers, std::shared_ptr<WaitSignal> dataSignal,
+                                   int core) 
+    : buffers(buffers), dataSignal(dataSignal), nextBuffer(0), core(core) {}
 
 PacketDispatcher::~PacketDispatcher() {
     Stop();
@@ -445,15 +1114,55 @@ void PacketDispatcher::Stop() {
 }
 
 void PacketDispatcher::DispatchLoop(std::atomic<bool>& running) {
-    tagSnapshot item;
+    PinThread("DispatchLoop", core);
     while (running) {
-        if (buffer->Pop(item)) {
-            for (auto& sub : subscribers) {
-                sub->OnPacketCaptured(item);
+        // Borrow the slots; subscribers see them in place until EndPopBatch
+        PacketBuffer* source = buffers.front().get();
+        size_t count = buffers.size() == 1 ? source->BeginPopBatch(batch, MAX_BATCH) : PopAny(&source);
+        if (count == 0) {
+            break;
+        }
+        Deliver(count);
+        source->EndPopBatch(count);
+    }
+}
+
+// Next batch from any worker buffer, round-robin; parks on the shared signal
+// when all are empty. Returns 0 once the buffers are shut down.
+size_t PacketDispatcher::PopAny(PacketBuffer** source) {
+    for (int spin = 0; ; ++spin) {
+        for (size_t i = 0; i < buffers.size(); i++) {
+            PacketBuffer* candidate = buffers[(nextBuffer + i) % buffers.size()].get();
+            if (size_t count = candidate->TryBeginPopBatch(batch, MAX_BATCH)) {
+                nextBuffer = (nextBuffer + i + 1) % buffers.size();
+                *source = candidate;
+                return count;
             }
-        } else {
-             std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
+        if (buffers.front()->IsShutdown()) {
+            return 0;
+        }
+        if (spin < SPIN_COUNT) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint32_t seen = dataSignal->sequence.load(std::memory_order_acquire);
+        dataSignal->waiting.store(true, std::memory_order_seq_cst);
+        bool empty = true;
+        for (auto& buffer : buffers) {
+            empty = empty && buffer->IsEmpty();
+        }
+        if (empty && !buffers.front()->IsShutdown()) {
+            dataSignal->sequence.wait(seen, std::memory_order_acquire);
+        }
+        dataSignal->waiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+void PacketDispatcher::Deliver(size_t count) {
+    for (auto& sub : subscribers) {
+        DeliverBatch(*sub, batch, count);
     }
 }
 
@@ -468,25 +1177,143 @@ PipeWriterSubscriber::~PipeWriterSubscriber() {
 }
 
 void PipeWriterSubscriber::OnPacketCaptured(const tagSnapshot& packet) {
+    const tagSnapshot* one = &packet;
+    OnPacketBatch(std::span<const tagSnapshot* const>(&one, 1));
+}
+
+void PipeWriterSubscriber::OnPacketBatch(std::span<const tagSnapshot* const> packets) {
 #ifdef _WIN32
+    for (const tagSnapshot* packet : packets) {
+        if (hPipe == INVALID_HANDLE_VALUE) {
+            break;
+        }
+        if (!message.empty() && message.size() + GetSnapshotIPCSize(packet) > MAX_MESSAGE_BYTES) {
+            Flush();
+        }
+        AppendRecord(*packet);
+    }
+    Flush();
+#else
+    // Linux/Mac implementation
+    // std::cout << "Packet: " << packet.id << std::endl;
+#endif
+}
+
+// Header and frame bytes go out back to back
+void PipeWriterSubscriber::AppendRecord(const tagSnapshot& packet) {
+    size_t offset = message.size();
+    message.resize(offset + GetSnapshotIPCSize(&packet));
+    memcpy(message.data() + offset, &packet, sizeof(SnapshotHeader));
+    if (packet.capture_len > 0) {
+        memcpy(message.data() + offset + sizeof(SnapshotHeader), packet.raw_data, packet.capture_len);
+    }
+}
+
+void PipeWriterSubscriber::Flush() {
+#ifdef _WIN32
+    if (message.empty()) {
+        return;
+    }
     if (hPipe != INVALID_HANDLE_VALUE) {
         DWORD written = 0;
-        
-        BOOL success = WriteFile(hPipe, &packet, sizeof(tagSnapshot), &written, NULL);
+        BOOL success = WriteFile(hPipe, message.data(), static_cast<DWORD>(message.size()), &written, NULL);
         
         if (!success) {
             hPipe = INVALID_HANDLE_VALUE;
-        } else if (written != sizeof(tagSnapshot)) {
-            std::cerr << "PipeWriter  Incomplete write: " << written << "/" << sizeof(tagSnapshot) << " bytes" << std::endl;
+        } else if (written != message.size()) {
+            std::cerr << "PipeWriter  Incomplete write: " << written << "/" << message.size() << " bytes" << std::endl;
+        }
+    }
+    message.clear();
+#endif
+}
+
+void PipeWriterSubscriber::OnHeartbeat(const Heartbeat& heartbeat) {
+#ifdef _WIN32
+    if (hPipe != INVALID_HANDLE_VALUE) {
+        DWORD written = 0;
+        if (!WriteFile(hPipe, &heartbeat, sizeof(Heartbeat), &written, NULL)) {
+            hPipe = INVALID_HANDLE_VALUE;
         }
     }
-#else
-    // Linux/Mac implementation
-    // std::cout << "Packet: " << packet.id << std::endl;
 #endif
 }
 
 
+// AsyncSubscriber Implementation
+AsyncSubscriber::AsyncSubscriber(std::shared_ptr<IPacketSubscriber> inner, const SubscriberOptions& options)
+    : inner(inner), core(options.core),
+      queue(options.queueCapacity, options.queueArenaBytes, nullptr, WareHound::NumaNodeOfCore(options.core)),
+      enqueued(0), delivered(0) {
+    queue.SetPolicy(options.policy);
+    deliveryThread = std::thread(&AsyncSubscriber::DeliveryLoop, this);
+}
+
+AsyncSubscriber::~AsyncSubscriber() {
+    queue.Shutdown();
+    if (deliveryThread.joinable()) {
+        deliveryThread.join();
+    }
+}
+
+void AsyncSubscriber::OnPacketCaptured(const tagSnapshot& packet) {
+    Enqueue(packet);
+}
+
+void AsyncSubscriber::OnPacketBatch(std::span<const tagSnapshot* const> packets) {
+    for (const tagSnapshot* packet : packets) {
+        Enqueue(*packet);
+    }
+}
+
+void AsyncSubscriber::OnHeartbeat(const Heartbeat& heartbeat) {
+    uint8_t* raw = nullptr;
+    tagSnapshot* item = queue.BeginPush(sizeof(Heartbeat), &raw);
+    if (!item) {
+        return;
+    }
+    memcpy(raw, &heartbeat, sizeof(Heartbeat));
+    item->kind = SNAPSHOT_HEARTBEAT;
+    item->original_len = 0;
+    queue.CommitPush();
+    enqueued.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Copy header and frame bytes; nullptr from BeginPush means the policy dropped it
+void AsyncSubscriber::Enqueue(const tagSnapshot& packet) {
+    uint8_t* raw = nullptr;
+    tagSnapshot* item = queue.BeginPush(packet.capture_len, &raw);
+    if (!item) {
+        return;
+    }
+    uint32_t rawLen = item->capture_len;
+    memcpy(item, &packet, sizeof(SnapshotHeader));
+    item->capture_len = rawLen;
+    item->kind = packet.kind;
+    memcpy(raw, packet.raw_data, rawLen);
+    queue.CommitPush();
+    enqueued.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncSubscriber::DeliveryLoop() {
+    PinThread("AsyncSubscriber", core);
+    const tagSnapshot* items[MAX_BATCH];
+    while (size_t count = queue.BeginPopBatch(items, MAX_BATCH)) {
+        DeliverBatch(*inner, items, count);
+        queue.EndPopBatch(count);
+        delivered.fetch_add(count, std::memory_order_relaxed);
+    }
+}
+
+SubscriberStats AsyncSubscriber::GetStats() const {
+    SubscriberStats stats;
+    stats.enqueued = enqueued.load(std::memory_order_relaxed);
+    stats.delivered = delivered.load(std::memory_order_relaxed);
+    stats.queue = queue.GetStats();
+    return stats;
+}
+
+
 // SnifferBuilder Implementation
 SnifferBuilder::SnifferBuilder() : deviceIndex(0), eventHandle(nullptr) {}
 
@@ -500,47 +1327,172 @@ SnifferBuilder& SnifferBuilder::UseFile(const std::string& filename) {
     return *this;
 }
 
+SnifferBuilder& SnifferBuilder::UseCaptureSource(std::shared_ptr<WareHound::ICaptureSource> source) {
+    this->source = source;
+    return *this;
+}
+
+#ifdef __linux__
+SnifferBuilder& SnifferBuilder::UseAfPacket(const WareHound::AfPacketCaptureSource::Options& options) {
+    // No fallback: a sniffer built after a failed open would quietly
+    // capture from whatever pcap handle was lying around instead
+    source = std::make_shared<WareHound::AfPacketCaptureSource>(options);
+    return *this;
+}
+#endif
+
 SnifferBuilder& SnifferBuilder::AddSubscriber(std::shared_ptr<IPacketSubscriber> subscriber) {
     subscribers.push_back(subscriber);
     return *this;
 }
 
+SnifferBuilder& SnifferBuilder::AddSubscriber(std::shared_ptr<IPacketSubscriber> subscriber, const SubscriberOptions& options) {
+    if (options.async) {
+        subscriber = std::make_shared<AsyncSubscriber>(subscriber, options);
+    }
+    subscribers.push_back(subscriber);
+    return *this;
+}
+
 SnifferBuilder& SnifferBuilder::SetEventHandle(HANDLE handle) {
     this->eventHandle = handle;
     return *this;
 }
 
+SnifferBuilder& SnifferBuilder::SetBatchSize(int batchSize) {
+    config.batchSize = batchSize < 1 ? 1 : batchSize;
+    return *this;
+}
+
+SnifferBuilder& SnifferBuilder::SetWorkerCount(int workerCount) {
+    config.workerCount = (std::max)(0, (std::min)(workerCount, 64));
+    return *this;
+}
+
+SnifferBuilder& SnifferBuilder::WithFilter(const std::string& expression) {
+    config.filter = expression;
+    return *this;
+}
+
+SnifferBuilder& SnifferBuilder::SetSnaplen(int snaplen) {
+    config.snaplen = static_cast<uint32_t>((std::max)(64, (std::min)(snaplen, 65536)));
+    return *this;
+}
+
+SnifferBuilder& SnifferBuilder::SetHeadersOnly(int payloadPrefix) {
+    config.headersOnly = true;
+    config.payloadPrefix = static_cast<uint32_t>((std::max)(0, (std::min)(payloadPrefix, 65536)));
+    return *this;
+}
+
+SnifferBuilder& SnifferBuilder::SetThreading(const ThreadingConfig& threading) {
+    config.threading = threading;
+    return *this;
+}
+
+SnifferBuilder& SnifferBuilder::SetCaptureProfile(const CaptureProfile& profile) {
+    config.profile = profile;
+    return *this;
+}
+
+SnifferBuilder& SnifferBuilder::SetDecapsulation(WareHound::TunnelKeying keying, int maxDepth) {
+    config.decap.keying = keying;
+    config.decap.maxDepth = static_cast<uint32_t>((std::max)(0, (std::min)(maxDepth, 32)));
+    return *this;
+}
+
+SnifferBuilder& SnifferBuilder::SetFlowEviction(WareHound::FlowEvictionPolicy policy) {
+    config.flowEviction = policy;
+    return *this;
+}
+
+SnifferBuilder& SnifferBuilder::SetBackpressure(BackpressurePolicy policy, int sampleRate) {
+    config.backpressure = policy;
+    config.sampleRate = sampleRate < 1 ? 1 : sampleRate;
+    return *this;
+}
+
 std::unique_ptr<Sniffer> SnifferBuilder::Build() {
     pcap_t* handle = nullptr;
+    CaptureSettings settings;
     
-    if (deviceIndex > 0) {
+    if (source) {
+        config.offline = source->IsOffline();
+        return std::make_unique<Sniffer>(source, subscribers, eventHandle, config);
+    }
+    if (!filename.empty()) {
+        // Replay a savefile through the same pipeline
+        try {
+            handle = builderDevice::Builder(0)
+                .OpenFromFile(filename)
+                .Build()
+                .getHandler();
+            config.offline = handle != nullptr;
+        } catch (const std::exception& e) {
+            std::cerr << "SnifferBuilder " << e.what() << std::endl;
+        }
+    }
+    else if (deviceIndex > 0) {
         try {
-            handle = builderDevice::Builder(deviceIndex)
+            builderDevice device = builderDevice::Builder(deviceIndex)
+                .SetSnaplen(static_cast<int>(config.KernelSnaplen()))
+                .SetProfile(config.profile)
                 .FindDevices()
                 .SelectDevice()
                 .OpenSelectedDevice()
-                .Build()
-                .getHandler();
+                .Build();
+            handle = device.getHandler();
+            settings = device.getSettings();
         } catch (...) {
         }
     }
     
-    return std::make_unique<Sniffer>(handle, subscribers, eventHandle);
+    auto sniffer = std::make_unique<Sniffer>(handle, subscribers, eventHandle, config);
+    sniffer->captureSettings = settings;
+    return sniffer;
 }
 
 // Sniffer Implementation (Facade)
-Sniffer::Sniffer(pcap_t* handle, std::vector<std::shared_ptr<IPacketSubscriber>> subscribers, HANDLE eventHandle)
-    : handle(handle), eventHandle(eventHandle), running(false) {
-    buffer = std::make_shared<PacketBuffer>();
-    capturer = std::make_unique<PacketCapturer>(buffer, eventHandle);
-    dispatcher = std::make_unique<PacketDispatcher>(buffer);
+Sniffer::Sniffer(pcap_t* handle, std::vector<std::shared_ptr<IPacketSubscriber>> subscribers, HANDLE eventHandle,
+                 const CaptureConfig& config)
+    : handle(handle), eventHandle(eventHandle), config(config), running(false) {
+    // One output buffer per worker; they share a signal so the dispatcher
+    // can park on all of them, and split the default arena budget. Each
+    // lives on its producer's node (the worker, or the capture thread).
+    size_t outputCount = config.workerCount > 0 ? static_cast<size_t>(config.workerCount) : 1;
+    auto dataSignal = std::make_shared<WaitSignal>();
+    for (size_t i = 0; i < outputCount; i++) {
+        int producerCore = config.workerCount > 0 ? config.threading.WorkerCore(i) : config.threading.captureCore;
+        buffers.push_back(std::make_shared<PacketBuffer>(
+            4096, WareHound::PacketArena::DEFAULT_CAPACITY / outputCount, dataSignal,
+            config.threading.NodeOf(producerCore)));
+        buffers.back()->SetPolicy(config.backpressure, static_cast<uint32_t>(config.sampleRate));
+    }
+    capturer = std::make_unique<PacketCapturer>(buffers, eventHandle, config);
+    dispatcher = std::make_unique<PacketDispatcher>(buffers, dataSignal, config.threading.dispatchCore);
     
     for (auto& sub : subscribers) {
         dispatcher->Subscribe(sub);
+        if (auto async = std::dynamic_pointer_cast<AsyncSubscriber>(sub)) {
+            asyncSubscribers.push_back(async);
+        }
     }
+
+    SetBackpressureStatsProvider([this]() { return GetBackpressureStats(); });
+    SetFilterStatsProvider([this]() { return GetFilterStats(); });
+    SetCaptureSettingsProvider([this]() { return GetCaptureSettings(); });
+}
+
+Sniffer::Sniffer(std::shared_ptr<WareHound::ICaptureSource> source, std::vector<std::shared_ptr<IPacketSubscriber>> subscribers,
+                 HANDLE eventHandle, const CaptureConfig& config)
+    : Sniffer(static_cast<pcap_t*>(nullptr), subscribers, eventHandle, config) {
+    this->source = source;
 }
 
 Sniffer::~Sniffer() {
+    SetBackpressureStatsProvider(nullptr);
+    SetFilterStatsProvider(nullptr);
+    SetCaptureSettingsProvider(nullptr);
     Stop();
     if (handle) {
         pcap_close(handle);
@@ -550,19 +1502,64 @@ Sniffer::~Sniffer() {
 }
 
 void Sniffer::Start() {
+    for (auto& buffer : buffers) {
+        buffer->Reset();
+    }
     running = true;
     
     if (handle == nullptr && _adhandle1 != nullptr) {
         handle = _adhandle1;
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        captureSettings = _captureSettings1;
+    }
+    if (!source && handle) {
+        source = std::make_shared<WareHound::PcapCaptureSource>(handle, config.offline);
     }
     
-    capturer->Start(handle, running, eventHandle);
+    capturer->Start(source, running, eventHandle);
     dispatcher->Start(running);
     
 }
 
 void Sniffer::Stop() {
     running = false;
+    capturer->Wake();
+    for (auto& buffer : buffers) {
+        buffer->Shutdown();
+    }
     capturer->Stop();
     dispatcher->Stop();
 }
+
+std::vector<BackpressureStats> Sniffer::GetBackpressureStats() const {
+    std::vector<BackpressureStats> stats;
+    capturer->CollectStats(stats);
+    for (const auto& buffer : buffers) {
+        stats.push_back(buffer->GetStats());
+    }
+    for (const auto& async : asyncSubscribers) {
+        stats.push_back(async->GetStats().queue);
+    }
+    return stats;
+}
+
+std::vector<SubscriberStats> Sniffer::GetSubscriberStats() const {
+    std::vector<SubscriberStats> stats;
+    for (const auto& async : asyncSubscribers) {
+        stats.push_back(async->GetStats());
+    }
+    return stats;
+}
+
+bool Sniffer::SetFilter(const std::string& expression) {
+    return capturer->SetFilter(expression);
+}
+
+FilterStats Sniffer::GetFilterStats() const {
+    return capturer->GetFilterStats();
+}
+
+CaptureSettings Sniffer::GetCaptureSettings() const {
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    return captureSettings;
+}
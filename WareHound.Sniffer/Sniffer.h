@@ -9,12 +9,25 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
+#include <future>
 #include <functional>
 #include <iostream>
+#include <chrono>
+#include <span>
+#include <algorithm>
 
 #include "struct.h"
 #include "packages.h" 
+#include "SpscRing.h"
+#include "PacketArena.h"
+#include "PacketParser.h"
+#include "FlowTable.h"
+#include "ThreadPlacement.h"
+#include "builderDevice.h"
+#include "CaptureSource.h"
+#ifdef __linux__
+#include "AfPacketCaptureSource.h"
+#endif
 
 class Sniffer;
 
@@ -23,49 +36,334 @@ class IPacketSubscriber {
 public:
     virtual ~IPacketSubscriber() = default;
     virtual void OnPacketCaptured(const tagSnapshot& packet) = 0;
+    // Consecutive packets from one buffer, valid until the call returns.
+    // Override to amortize per-packet costs; the default forwards each one.
+    virtual void OnPacketBatch(std::span<const tagSnapshot* const> packets) {
+        for (const tagSnapshot* packet : packets) {
+            OnPacketCaptured(*packet);
+        }
+    }
+    // Capture thread is alive but idle; called on the dispatch thread
+    virtual void OnHeartbeat(const Heartbeat& heartbeat) {}
 };
 
-// Thread-safe Queue (Buffer)
+// Wait Signal - sequence counter a blocked side parks on with atomic wait.
+// Worker output buffers share one consumer signal so the dispatcher can
+// sleep on all of them at once.
+struct WaitSignal {
+    alignas(WareHound::CACHE_LINE_SIZE) std::atomic<uint32_t> sequence{0};
+    std::atomic<bool> waiting{false};
+
+    // Caller has published its change and issued a seq_cst fence
+    void NotifyIfWaiting();
+    void NotifyAll();
+};
+
+// What a PacketBuffer producer does when the consumer falls behind
+enum class BackpressurePolicy {
+    Block,       // wait for space; lossless, but stalls capture
+    DropNewest,  // discard the incoming packet
+    DropOldest,  // evict the oldest queued packet the consumer is not reading
+    Sample       // past the threshold keep 1 in sampleRate, drop newest when full
+};
+
+// Per-buffer pressure counters, written by the producer
+struct BackpressureStats {
+    uint64_t droppedFull = 0;     // DropNewest/Sample when full, DropOldest fallback
+    uint64_t droppedOldest = 0;
+    uint64_t droppedSampled = 0;
+    uint64_t producerStalls = 0;  // Block: times the producer had to park
+    size_t occupancy = 0;         // slots queued now
+    size_t capacity = 0;
+    // Fill of the tighter resource, slots or arena bytes
+    double occupancyPercent = 0;
+    double highWaterPercent = 0;
+};
+
+// Packet Buffer - SPSC slot ring between capturer and dispatcher.
+// The capturer fills a slot in place (BeginPush/CommitPush) and the
+// dispatcher borrows it (BeginPop/EndPop); snapshots are never copied.
+// Frame bytes go to a byte arena sized by caplen, referenced from the slot.
+// Both sides spin briefly and then park on an atomic wait when blocked.
 class PacketBuffer {
 public:
-    PacketBuffer(size_t maxSize = 100);
-    void Push(const tagSnapshot& item);
-    bool Pop(tagSnapshot& item);
+    PacketBuffer(size_t capacity = 4096, size_t arenaBytes = WareHound::PacketArena::DEFAULT_CAPACITY,
+                 std::shared_ptr<WaitSignal> dataSignal = nullptr, int numaNode = WareHound::ANY_NODE);
+
+    // Only valid while neither side is running
+    void SetPolicy(BackpressurePolicy policy, uint32_t sampleRate = 8, uint32_t sampleThresholdPercent = 75);
+
+    // Producer: reserves a slot plus rawLen arena bytes written through *raw.
+    // Returns nullptr once Shutdown() has been called, or if the policy
+    // dropped the packet.
+    tagSnapshot* BeginPush(uint32_t rawLen, uint8_t** raw);
+    void CommitPush();
+
+    // Consumer: returns nullptr once Shutdown() has been called
+    const tagSnapshot* BeginPop();
+    // Consumer: non-blocking; nullptr if empty or shut down
+    const tagSnapshot* TryBeginPop();
+    void EndPop();
+
+    // Consumer: borrow up to max slots in FIFO order, released together by
+    // EndPopBatch. Blocks until at least one is ready; 0 once shut down.
+    size_t BeginPopBatch(const tagSnapshot** out, size_t max);
+    // Non-blocking; 0 if empty or shut down
+    size_t TryBeginPopBatch(const tagSnapshot** out, size_t max);
+    void EndPopBatch(size_t count);
+
+    // Wake both sides and make Begin* return nullptr
+    void Shutdown();
+    void Reset();
+
+    BackpressureStats GetStats() const;
+    bool IsShutdown() const;
     bool IsFull() const;
     bool IsEmpty() const;
+    size_t Size() const;
+    size_t Capacity() const;
+
+private:
+    static constexpr int SPIN_COUNT = 64;
+
+    tagSnapshot* TryClaim(uint32_t rawLen, uint8_t** raw);
+    size_t Peek(const tagSnapshot** out, size_t max);
+    void NotePressure(const tagSnapshot* oldest);
+
+    WareHound::SpscRing<tagSnapshot> ring;
+    WareHound::PacketArena arena;
+    std::atomic<bool> shutdown;
+
+    // Parking state: a side sets its waiting flag, then waits on its signal
+    std::shared_ptr<WaitSignal> dataSignal;
+    WaitSignal spaceSignal;
+
+    BackpressurePolicy policy;
+    uint32_t sampleRate;
+    uint32_t sampleThreshold;  // permille
+    uint32_t sampleCounter;    // producer-only
+
+    // Producer-written, read by GetStats from any thread
+    alignas(WareHound::CACHE_LINE_SIZE) std::atomic<uint64_t> droppedFull;
+    std::atomic<uint64_t> droppedOldest;
+    std::atomic<uint64_t> droppedSampled;
+    std::atomic<uint64_t> producerStalls;
+    std::atomic<uint32_t> pressure;   // permille at the last push
+    std::atomic<uint32_t> highWater;  // permille
+};
+
+// Core pinning for the pipeline threads; ANY_CORE leaves a thread to the
+// scheduler. Each buffer is allocated on the NUMA node of the thread that
+// fills it.
+struct ThreadingConfig {
+    int captureCore = WareHound::ANY_CORE;
+    int dispatchCore = WareHound::ANY_CORE;
+    // Worker i runs on workerCores[i % size]
+    std::vector<int> workerCores;
+    bool numaLocal = true;
+
+    int WorkerCore(size_t index) const {
+        return workerCores.empty() ? WareHound::ANY_CORE : workerCores[index % workerCores.size()];
+    }
+    int NodeOf(int core) const {
+        return numaLocal ? WareHound::NumaNodeOfCore(core) : WareHound::ANY_NODE;
+    }
+};
+
+// Capture pipeline settings, filled in by SnifferBuilder
+struct CaptureConfig {
+    // Packets drained per pcap_dispatch call; 1 uses the pcap_next_ex loop
+    int batchSize = 64;
+    // Handle reads a savefile: EOF ends the capture loop
+    bool offline = false;
+    // Idle time between heartbeats
+    int heartbeatIntervalMs = 1000;
+    // Flow-sharded processing threads; 0 processes on the capture thread
+    int workerCount = 0;
+    // Applied to every buffer in the pipeline
+    BackpressurePolicy backpressure = BackpressurePolicy::Block;
+    int sampleRate = 8;
+    // Kernel BPF filter installed when capture starts; empty accepts all
+    std::string filter;
+    // Frame bytes kept per packet; the device is opened with this snaplen
+    uint32_t snaplen = 65536;
+    // Keep only the L2-L4 headers plus payloadPrefix bytes of each packet
+    bool headersOnly = false;
+    uint32_t payloadPrefix = 0;
+    ThreadingConfig threading;
+    // Kernel buffer size, timeout and immediate mode for live devices
+    CaptureProfile profile = CaptureProfile::Balanced();
+    // Tunnel handling for flow keys, worker sharding and header trimming
+    WareHound::DecapConfig decap;
+    // What a new flow displaces when a stats shard's flow table is full
+    WareHound::FlowEvictionPolicy flowEviction = WareHound::FlowEvictionPolicy::LEAST_RECENT;
+
+    // Snaplen to request from the kernel; per-protocol trimming happens after
+    uint32_t KernelSnaplen() const {
+        return headersOnly ? (std::min)(snaplen, WareHound::PacketParser::MAX_HEADER_LEN + payloadPrefix) : snaplen;
+    }
+};
+
+// Kernel filter effect since capture started
+struct FilterStats {
+    std::string expression;
+    uint64_t swaps = 0;               // Filters installed at runtime
+    uint64_t kernelReceived = 0;
+    uint64_t kernelDropped = 0;
+    uint64_t filtered = 0;            // Rejected before user space
+    bool filteredCounted = false;     // Backend reports pre-filter totals
+};
+
+// Packet Processor - per-packet analysis: native stats for one shard, DNS,
+// protocol naming and the snapshot written to the output buffer. Runs on the
+// capture thread, or on a CaptureWorker when processing is sharded. Each
+// frame is parsed once, with decap, and every stage reads that parse.
+class PacketProcessor {
+public:
+    PacketProcessor(std::shared_ptr<PacketBuffer> output, size_t statsShard,
+                    const WareHound::DecapConfig& decap);
+    PacketProcessor(const PacketProcessor&) = delete;
+    PacketProcessor& operator=(const PacketProcessor&) = delete;
+
+    // timestamp_ns is the full-precision capture time; pkthdr->ts is unused
+    void Process(const struct pcap_pkthdr* pkthdr, const u_char* packet, uint64_t timestamp_ns);
+    // Pass a non-packet slot (heartbeat) through unchanged
+    void Forward(const tagSnapshot& item);
+
+private:
+    std::shared_ptr<PacketBuffer> output;
+    size_t statsShard;
+    WareHound::DecapConfig decap;
+    Packages parserHelper;
+
+    // Protocol naming table, built once; the handlers write through these
+    int protoSrcPort = 0;
+    int protoDstPort = 0;
+    char protoStr[22];
+    std::unique_ptr<handleProto> protoNames;
+};
+
+// Capture Worker - owns one flow shard. The capture thread copies frames
+// into its input buffer by flow hash; the worker processes them in order.
+class CaptureWorker {
+public:
+    CaptureWorker(size_t index, std::shared_ptr<PacketBuffer> output, size_t inputArenaBytes,
+                  const WareHound::DecapConfig& decap,
+                  int core = WareHound::ANY_CORE, int numaNode = WareHound::ANY_NODE);
+    ~CaptureWorker();
+
+    void Start();
+    void Stop();
+    PacketBuffer& Input() { return input; }
+    const PacketBuffer& Input() const { return input; }
 
 private:
-    std::queue<tagSnapshot> queue;
-    mutable std::mutex mutex;
-    std::condition_variable notEmpty;
-    std::condition_variable notFull;
-    size_t maxSize;
+    void WorkLoop();
+
+    PacketBuffer input;
+    PacketProcessor processor;
+    int core;
+    std::thread workerThread;
+};
+
+// Capture Waiter - blocks the capture thread on the source's selectable
+// fd/event together with a wake fd/event, so an idle capture uses no CPU and
+// Wake() (from Sniffer::Stop) returns immediately.
+class CaptureWaiter {
+public:
+    enum class Result { Readable, Woken, Timeout };
+
+    CaptureWaiter();
+    ~CaptureWaiter();
+
+    // False if the source has no selectable fd/event on this platform
+    bool Attach(WareHound::ICaptureSource& source);
+    Result Wait(int timeoutMs);
+    void Wake();
+
+private:
+#ifdef _WIN32
+    HANDLE pcapEvent;
+    HANDLE wakeEvent;
+#else
+    int pcapFd;
+    int wakeFds[2];  // eventfd uses only [0]
+#endif
 };
 
 // Packet Capturer (Producer)
 class PacketCapturer {
 public:
-    PacketCapturer(std::shared_ptr<PacketBuffer> buffer, HANDLE eventHandle);
+    // One output buffer per worker, or a single one when workerCount is 0
+    PacketCapturer(std::vector<std::shared_ptr<PacketBuffer>> outputs, HANDLE eventHandle,
+                   const CaptureConfig& config = CaptureConfig());
     ~PacketCapturer();
 
-    void Start(pcap_t* handle, std::atomic<bool>& running, HANDLE eventHandle = nullptr);
+    void Start(std::shared_ptr<WareHound::ICaptureSource> source, std::atomic<bool>& running, HANDLE eventHandle = nullptr);
     void Stop();
+    // Interrupt an idle wait, e.g. when running has been cleared
+    void Wake();
+    // Pressure on the worker input buffers, if any
+    void CollectStats(std::vector<BackpressureStats>& out) const;
+    // While capturing, the swap happens on the capture thread between reads
+    // and this blocks until it has; otherwise it applies immediately
+    bool SetFilter(const std::string& expression);
+    FilterStats GetFilterStats() const;
 
 private:
-    void CaptureLoop(pcap_t* handle, std::atomic<bool>& running, HANDLE eventHandle);
-    
+    void CaptureLoop(std::shared_ptr<WareHound::ICaptureSource> source, std::atomic<bool>& running, HANDLE eventHandle);
+    void SingleCaptureLoop(WareHound::ICaptureSource& source, std::atomic<bool>& running);
+    void BatchCaptureLoop(WareHound::ICaptureSource& source, std::atomic<bool>& running);
+    void WaitForPackets();
+    void ApplyPendingFilterLocked(WareHound::ICaptureSource& source);
+    void SampleSourceStats(WareHound::ICaptureSource& source);
+    void PushHeartbeat();
+    void ShardPacket(const struct pcap_pkthdr* pkthdr, const u_char* packet, uint64_t timestamp_ns);
+    uint32_t CaptureLength(const struct pcap_pkthdr* pkthdr, const u_char* packet) const;
+
+    static void DispatchHandler(u_char* user, const struct pcap_pkthdr* pkthdr, const u_char* packet);
     void ProcessPacket(const struct pcap_pkthdr* pkthdr, const u_char* packet);
 
     HANDLE _eventHandles;
     std::shared_ptr<PacketBuffer> buffer;
+    CaptureConfig config;
+    std::unique_ptr<PacketProcessor> inlineProcessor;
+    std::vector<std::unique_ptr<CaptureWorker>> workers;
     std::thread captureThread;
-    Packages parserHelper; 
+    uint64_t packetCount;
+    CaptureWaiter waiter;
+    bool eventDriven;
+    bool nanoTimestamps;
+    uint32_t heartbeatSequence;
+    std::chrono::steady_clock::time_point lastActivity;
+
+    // FILTER SWAP - handed to the capture thread, which owns the source
+    // while capturing
+    static constexpr uint64_t STATS_SAMPLE_PACKETS = 4096;
+    std::shared_ptr<WareHound::ICaptureSource> source;
+    mutable std::mutex filterMutex;
+    std::mutex filterCallMutex;
+    bool capturing;
+    std::atomic<bool> filterPending;
+    std::string pendingFilter;
+    std::promise<bool> filterResult;
+    std::atomic<uint64_t> filterSwaps;
+    std::atomic<uint64_t> kernelReceived;
+    std::atomic<uint64_t> kernelDropped;
+    std::atomic<uint64_t> filteredPackets;
+    std::atomic<bool> filteredCounted;
+    WareHound::CaptureSourceStats statsBase;
+    uint64_t packetCountBase;
+    uint64_t lastStatsSample;
 };
 
-// Packet Dispatcher/Processor (Consumer)
+// Packet Dispatcher (Consumer)
+// With several worker buffers it drains them round-robin; packet order is
+// kept per flow, not across flows.
 class PacketDispatcher {
 public:
-    PacketDispatcher(std::shared_ptr<PacketBuffer> buffer);
+    PacketDispatcher(std::vector<std::shared_ptr<PacketBuffer>> buffers, std::shared_ptr<WaitSignal> dataSignal = nullptr,
+                     int core = WareHound::ANY_CORE);
     ~PacketDispatcher();
 
     void Subscribe(std::shared_ptr<IPacketSubscriber> subscriber);
@@ -74,23 +372,90 @@ public:
 
 private:
     void DispatchLoop(std::atomic<bool>& running);
+    size_t PopAny(PacketBuffer** source);
+    void Deliver(size_t count);
 
-    std::shared_ptr<PacketBuffer> buffer;
+    static constexpr int SPIN_COUNT = 64;
+    static constexpr size_t MAX_BATCH = 256;
+
+    const tagSnapshot* batch[MAX_BATCH];
+    std::vector<std::shared_ptr<PacketBuffer>> buffers;
+    std::shared_ptr<WaitSignal> dataSignal;
+    size_t nextBuffer;
+    int core;
     std::vector<std::shared_ptr<IPacketSubscriber>> subscribers;
     std::thread dispatchThread;
 };
 
 // Concrete Subscriber: Pipe Writer (for Windows IPC)
+// A pipe message holds one or more records of SnapshotHeader + capture_len
+// raw bytes; a batch becomes as few messages as MAX_MESSAGE_BYTES allows.
+// Heartbeats are separate, shorter messages.
 class PipeWriterSubscriber : public IPacketSubscriber {
 public:
     PipeWriterSubscriber();
     ~PipeWriterSubscriber();
     void OnPacketCaptured(const tagSnapshot& packet) override;
+    void OnPacketBatch(std::span<const tagSnapshot* const> packets) override;
+    void OnHeartbeat(const Heartbeat& heartbeat) override;
 
 private:
+    static constexpr size_t MAX_MESSAGE_BYTES = 256 * 1024;
+
+    void AppendRecord(const tagSnapshot& packet);
+    void Flush();
+
     #ifdef _WIN32
     HANDLE hPipe;
     #endif
+    std::vector<uint8_t> message;
+};
+
+// Delivery options for SnifferBuilder::AddSubscriber
+struct SubscriberOptions {
+    // Give the subscriber its own queue and thread (AsyncSubscriber)
+    bool async = false;
+    size_t queueCapacity = 4096;
+    size_t queueArenaBytes = WareHound::PacketArena::DEFAULT_CAPACITY;
+    BackpressurePolicy policy = BackpressurePolicy::DropOldest;
+    // Delivery thread core; the queue goes on that core's NUMA node
+    int core = WareHound::ANY_CORE;
+};
+
+// Per-subscriber queue metrics
+struct SubscriberStats {
+    uint64_t enqueued = 0;
+    uint64_t delivered = 0;
+    BackpressureStats queue;  // occupancy is the current lag in packets
+};
+
+// Concrete Subscriber: Async decorator
+// Copies packets into a private PacketBuffer on the dispatch thread and
+// delivers them to the wrapped subscriber on its own thread, so a slow
+// subscriber only fills (and drops from) its own queue.
+class AsyncSubscriber : public IPacketSubscriber {
+public:
+    AsyncSubscriber(std::shared_ptr<IPacketSubscriber> inner, const SubscriberOptions& options = SubscriberOptions());
+    ~AsyncSubscriber();
+
+    void OnPacketCaptured(const tagSnapshot& packet) override;
+    void OnPacketBatch(std::span<const tagSnapshot* const> packets) override;
+    void OnHeartbeat(const Heartbeat& heartbeat) override;
+
+    SubscriberStats GetStats() const;
+
+private:
+    void Enqueue(const tagSnapshot& packet);
+    void DeliveryLoop();
+
+    static constexpr size_t MAX_BATCH = 256;
+
+    std::shared_ptr<IPacketSubscriber> inner;
+    int core;
+    PacketBuffer queue;
+    std::atomic<uint64_t> enqueued;
+    std::atomic<uint64_t> delivered;
+    std::thread deliveryThread;
 };
 
 // 2. Builder Pattern
@@ -100,15 +465,44 @@ public:
     
     SnifferBuilder& UseDevice(int deviceIndex);
     SnifferBuilder& UseFile(const std::string& filename);
+    // Capture from an already opened backend instead of a pcap device
+    SnifferBuilder& UseCaptureSource(std::shared_ptr<WareHound::ICaptureSource> source);
+#ifdef __linux__
+    // Opens the socket now; throws std::runtime_error if that fails
+    SnifferBuilder& UseAfPacket(const WareHound::AfPacketCaptureSource::Options& options);
+#endif
     SnifferBuilder& AddSubscriber(std::shared_ptr<IPacketSubscriber> subscriber);
+    SnifferBuilder& AddSubscriber(std::shared_ptr<IPacketSubscriber> subscriber, const SubscriberOptions& options);
     SnifferBuilder& SetEventHandle(HANDLE handle);
+    SnifferBuilder& SetBatchSize(int batchSize);
+    SnifferBuilder& SetWorkerCount(int workerCount);
+    SnifferBuilder& SetBackpressure(BackpressurePolicy policy, int sampleRate = 8);
+    // Kernel BPF filter (pcap syntax), e.g. "net 10.0.0.0/8 and tcp"
+    SnifferBuilder& WithFilter(const std::string& expression);
+    SnifferBuilder& SetSnaplen(int snaplen);
+    // Metadata-only capture; payloadPrefix keeps enough payload for
+    // protocol detection (e.g. 64)
+    SnifferBuilder& SetHeadersOnly(int payloadPrefix = 0);
+    // Pin capture, dispatch and worker threads; async subscribers take
+    // their core from SubscriberOptions
+    SnifferBuilder& SetThreading(const ThreadingConfig& threading);
+    // CaptureProfile::Latency(), Balanced() (default) or Throughput()
+    SnifferBuilder& SetCaptureProfile(const CaptureProfile& profile);
+    // Key tunnelled traffic on the inner (default) or outer headers;
+    // maxDepth bounds the tags, labels and tunnels stripped per packet
+    SnifferBuilder& SetDecapsulation(WareHound::TunnelKeying keying, int maxDepth = 8);
+    // Which flow gives way when the stats flow table is full; NONE stops
+    // tracking new flows until old ones expire
+    SnifferBuilder& SetFlowEviction(WareHound::FlowEvictionPolicy policy);
     
     std::unique_ptr<Sniffer> Build();
 
 private:
     int deviceIndex;
     std::string filename;
+    std::shared_ptr<WareHound::ICaptureSource> source;
     HANDLE eventHandle;
+    CaptureConfig config;
     std::vector<std::shared_ptr<IPacketSubscriber>> subscribers;
 };
 
@@ -116,18 +510,42 @@ private:
 // 3. Facade Pattern - Main Sniffer Class coordinating subsystems
 class Sniffer {
 public:
-    Sniffer(pcap_t* handle, std::vector<std::shared_ptr<IPacketSubscriber>> subscribers, HANDLE eventHandle = nullptr);
+    Sniffer(pcap_t* handle, std::vector<std::shared_ptr<IPacketSubscriber>> subscribers, HANDLE eventHandle = nullptr,
+            const CaptureConfig& config = CaptureConfig());
+    Sniffer(std::shared_ptr<WareHound::ICaptureSource> source, std::vector<std::shared_ptr<IPacketSubscriber>> subscribers,
+            HANDLE eventHandle = nullptr, const CaptureConfig& config = CaptureConfig());
     ~Sniffer();
 
     void Start();
     void Stop();
 
+    // Every buffer in the pipeline: worker inputs, dispatcher inputs, then
+    // async subscriber queues
+    std::vector<BackpressureStats> GetBackpressureStats() const;
+    // One entry per async subscriber, in registration order
+    std::vector<SubscriberStats> GetSubscriberStats() const;
+
+    // Swaps the kernel filter, also while capture runs; false if it does not
+    // compile or cannot be installed (the previous filter stays)
+    bool SetFilter(const std::string& expression);
+    FilterStats GetFilterStats() const;
+    // What the device was opened with; empty profile if it was not opened
+    // through builderDevice. Kernel drops are in GetFilterStats().
+    CaptureSettings GetCaptureSettings() const;
+
 private:
+    friend class SnifferBuilder;
+
     pcap_t* handle;
+    std::shared_ptr<WareHound::ICaptureSource> source;
     HANDLE eventHandle;
-    std::shared_ptr<PacketBuffer> buffer;
+    CaptureConfig config;
+    std::vector<std::shared_ptr<PacketBuffer>> buffers;
     std::unique_ptr<PacketCapturer> capturer;
     std::unique_ptr<PacketDispatcher> dispatcher;
+    std::vector<std::shared_ptr<AsyncSubscriber>> asyncSubscribers;
+    CaptureSettings captureSettings;
+    mutable std::mutex settingsMutex;
     std::atomic<bool> running;
 };
 
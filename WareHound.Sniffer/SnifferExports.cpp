@@ -28,8 +28,9 @@ extern "C" {
             return false;
         }
 
-        // Create a dead pcap handle for writing (Ethernet link type)
-        pcap_t* dead_pcap = pcap_open_dead(DLT_EN10MB, 65536);
+        // Create a dead pcap handle for writing (Ethernet link type);
+        // nanosecond precision writes the nanosecond magic
+        pcap_t* dead_pcap = pcap_open_dead_with_tstamp_precision(DLT_EN10MB, 65536, PCAP_TSTAMP_PRECISION_NANO);
         if (!dead_pcap) {
             return false;
         }
@@ -48,8 +49,13 @@ extern "C" {
             }
 
             struct pcap_pkthdr hdr;
-            hdr.ts.tv_sec = static_cast<long>(pkt.timestamp_sec);
-            hdr.ts.tv_usec = static_cast<long>(pkt.timestamp_usec);
+            if (pkt.timestamp_ns != 0) {
+                hdr.ts.tv_sec = static_cast<long>(pkt.timestamp_ns / 1000000000ULL);
+                hdr.ts.tv_usec = static_cast<long>(pkt.timestamp_ns % 1000000000ULL);
+            } else {
+                hdr.ts.tv_sec = static_cast<long>(pkt.timestamp_sec);
+                hdr.ts.tv_usec = static_cast<long>(pkt.timestamp_usec) * 1000;
+            }
             hdr.caplen = pkt.capture_len;
             hdr.len = pkt.original_len;
 
@@ -69,7 +75,7 @@ extern "C" {
         *packetCount = 0;
 
         char errbuf[PCAP_ERRBUF_SIZE];
-        pcap_t* handle = pcap_open_offline(filePath, errbuf);
+        pcap_t* handle = pcap_open_offline_with_tstamp_precision(filePath, PCAP_TSTAMP_PRECISION_NANO, errbuf);
         if (!handle) {
             return nullptr;
         }
@@ -87,8 +93,10 @@ extern "C" {
 
             pkt.capture_len = header->caplen;
             pkt.original_len = header->len;
+            // ts.tv_usec holds nanoseconds with nano precision
             pkt.timestamp_sec = static_cast<uint64_t>(header->ts.tv_sec);
-            pkt.timestamp_usec = static_cast<uint32_t>(header->ts.tv_usec);
+            pkt.timestamp_usec = static_cast<uint32_t>(header->ts.tv_usec / 1000);
+            pkt.timestamp_ns = pkt.timestamp_sec * 1000000000ULL + static_cast<uint64_t>(header->ts.tv_usec);
 
             uint32_t copy_len = (header->caplen > 65536) ? 65536 : header->caplen;
             memcpy(pkt.raw_data, data, copy_len);
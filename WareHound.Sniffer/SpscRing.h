@@ -0,0 +1,190 @@
+#pragma once
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include "ThreadPlacement.h"
+
+namespace WareHound {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// SPSC RING - Pre-allocated single-producer/single-consumer slot ring
+//
+// Slots are constructed once and reused. The producer claims the slot at
+// head, fills it in place and publishes it; the consumer borrows the slot at
+// tail and releases it when done. Nothing is copied through the ring.
+// Producer and consumer indices live on separate cache lines, and each side
+// keeps a cached copy of the other side's index so the shared line is only
+// re-read when the ring looks full (producer) or empty (consumer).
+//
+// For drop-oldest backpressure the producer may also advance tail
+// (TryDropOldest). The tail word therefore packs the index with a CLAIMED
+// bit: a consumer using TryAcquire sets it while it holds slots, and the
+// producer only drops while it is clear.
+template <typename T>
+class SpscRing {
+public:
+    // numaNode places the slots on that node (ANY_NODE: default heap)
+    explicit SpscRing(size_t capacity, int numaNode = ANY_NODE)
+        : capacity_(RoundUpPow2(capacity < 2 ? 2 : capacity))
+        , mask_(capacity_ - 1)
+        , slots_(capacity_, numaNode)
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // PRODUCER SIDE
+
+    // Slot at head, or nullptr if the ring is full
+    T* TryClaim() {
+        size_t head = head_.value.load(std::memory_order_relaxed);
+        if (head - producer_.cached_tail >= capacity_) {
+            producer_.cached_tail = tail_.value.load(std::memory_order_acquire) >> 1;
+            if (head - producer_.cached_tail >= capacity_) {
+                return nullptr;
+            }
+        }
+        return &slots_[head & mask_];
+    }
+
+    // Oldest published slot not yet released, or nullptr if none.
+    // Producer-side view; the answer may be stale but never too new.
+    const T* OldestInFlight() const {
+        size_t tail = tail_.value.load(std::memory_order_acquire) >> 1;
+        if (tail == head_.value.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return &slots_[tail & mask_];
+    }
+
+    // Make the claimed slot visible to the consumer
+    void Publish() {
+        head_.value.store(head_.value.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Discard the oldest published slot; false if the ring is empty or the
+    // consumer has it acquired. Only for consumers that use TryAcquire.
+    bool TryDropOldest() {
+        size_t word = tail_.value.load(std::memory_order_acquire);
+        if ((word & CLAIMED) || (word >> 1) == head_.value.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        return tail_.value.compare_exchange_strong(word, word + 2, std::memory_order_acq_rel);
+    }
+
+    // CONSUMER SIDE
+
+    // Oldest published slot, or nullptr if the ring is empty
+    T* TryPeek() {
+        size_t tail = tail_.value.load(std::memory_order_relaxed) >> 1;
+        return Available(tail) ? &slots_[tail & mask_] : nullptr;
+    }
+
+    // Oldest published slot, locked against TryDropOldest until Release
+    T* TryAcquire() {
+        const T* slot = nullptr;
+        return TryAcquireBatch(&slot, 1) ? const_cast<T*>(slot) : nullptr;
+    }
+
+    // Up to max oldest published slots in order; 0 if the ring is empty
+    size_t TryPeekBatch(const T** out, size_t max) {
+        size_t tail = tail_.value.load(std::memory_order_relaxed) >> 1;
+        return Collect(tail, out, max);
+    }
+
+    // TryPeekBatch for drop-oldest rings: while any slot is held the
+    // producer cannot drop, so one CLAIMED bit covers the whole batch
+    size_t TryAcquireBatch(const T** out, size_t max) {
+        size_t word = tail_.value.load(std::memory_order_acquire);
+        for (;;) {
+            size_t tail = word >> 1;
+            if (Available(tail) == 0) {
+                return 0;
+            }
+            // Fails only if the producer dropped the slot meanwhile
+            if (tail_.value.compare_exchange_weak(word, word | CLAIMED, std::memory_order_acq_rel)) {
+                return Collect(tail, out, max);
+            }
+        }
+    }
+
+    // Hand the oldest count peeked/acquired slots back to the producer
+    void Release(size_t count = 1) {
+        size_t tail = tail_.value.load(std::memory_order_relaxed) >> 1;
+        tail_.value.store((tail + count) << 1, std::memory_order_release);
+    }
+
+    // Drop everything; only valid while neither side is running
+    void Reset() {
+        head_.value.store(0, std::memory_order_relaxed);
+        tail_.value.store(0, std::memory_order_relaxed);
+        producer_.cached_tail = 0;
+        consumer_.cached_head = 0;
+    }
+
+    size_t Size() const {
+        // tail first: head read afterwards can only be newer, never behind it
+        size_t tail = tail_.value.load(std::memory_order_acquire) >> 1;
+        return head_.value.load(std::memory_order_acquire) - tail;
+    }
+    size_t Capacity() const { return capacity_; }
+    bool IsEmpty() const { return Size() == 0; }
+    bool IsFull() const { return Size() >= capacity_; }
+
+private:
+    // Published slots from tail on; refreshes the cached head when it runs out
+    size_t Available(size_t tail) {
+        if (tail >= consumer_.cached_head) {
+            consumer_.cached_head = head_.value.load(std::memory_order_acquire);
+            if (tail >= consumer_.cached_head) {
+                return 0;
+            }
+        }
+        return consumer_.cached_head - tail;
+    }
+
+    size_t Collect(size_t tail, const T** out, size_t max) {
+        size_t n = Available(tail);
+        if (n > max) n = max;
+        for (size_t i = 0; i < n; i++) {
+            out[i] = &slots_[(tail + i) & mask_];
+        }
+        return n;
+    }
+
+    static size_t RoundUpPow2(size_t v) {
+        size_t p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    static constexpr size_t CLAIMED = 1;
+
+    struct alignas(CACHE_LINE_SIZE) PaddedIndex {
+        std::atomic<size_t> value{0};
+    };
+    struct alignas(CACHE_LINE_SIZE) ProducerLocal {
+        size_t cached_tail = 0;
+    };
+    struct alignas(CACHE_LINE_SIZE) ConsumerLocal {
+        size_t cached_head = 0;
+    };
+
+    const size_t capacity_;
+    const size_t mask_;
+    NodeArray<T> slots_;
+
+    PaddedIndex head_;          // written by producer
+    ProducerLocal producer_;
+    PaddedIndex tail_;          // index << 1 | CLAIMED; written by consumer (and TryDropOldest)
+    ConsumerLocal consumer_;
+};
+
+} // namespace WareHound
+
+#endif // SPSC_RING_H
@@ -2,30 +2,146 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include "StatisticsExports.h"
 #include "FlowTracker.h"
+#include "Sniffer.h"
 #include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <functional>
 #include <algorithm>
 #include <mutex>
 #include <shared_mutex>
 #include <cstring>
+#ifdef _WIN32
 #include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#endif
 
 using namespace WareHound;
 
-// GLOBAL FLOW TRACKER INSTANCE
-static std::unique_ptr<FlowTracker> g_flowTracker;
-static std::shared_mutex g_flowTrackerMutex;  // Shared mutex for concurrent reads
+// STATISTICS SHARDS - One per capture worker
+// Workers are fed by symmetric flow hash, so a flow lives in exactly one
+// shard (UDP shards on addresses so its fragments land there too; see
+// SymmetricFlowHash for TCP) and each shard is written by a single worker
+// thread. Shards are only
+// ever added, never destroyed, so readers can walk [0, g_shardCount) without
+// holding a registry lock.
+// The worker takes no lock on its tracker: counters are atomic and the flow
+// table locks by stripe. Clearing is handed to the worker through
+// clearPending, and until it runs readers treat the shard as empty.
+struct StatsShard {
+    std::unique_ptr<FlowTracker> flowTracker;
+    std::atomic<bool> clearPending{false};
+
+    // IP address counters (IPv4 held IPv4-mapped)
+    std::unordered_map<IpAddress, uint64_t, IpAddressHash> sourceIPCounts;
+    std::unordered_map<IpAddress, uint64_t, IpAddressHash> destIPCounts;
+    std::unordered_map<uint16_t, uint64_t> portCounts;
+    std::shared_mutex ipStatsMutex;  // Shared mutex for concurrent reads
+};
+
+static constexpr size_t MAX_STATS_SHARDS = 64;
+static std::unique_ptr<StatsShard> g_shards[MAX_STATS_SHARDS];
+static std::atomic<size_t> g_shardCount{0};
+static std::mutex g_shardsMutex;  // Serializes shard creation only
 static bool g_nativeStatsEnabled = false;
+static DecapConfig g_decapConfig;  // Guarded by g_shardsMutex
+static FlowEvictionPolicy g_flowEviction = FlowEvictionPolicy::LEAST_RECENT;  // Guarded by g_shardsMutex
+
+template <typename Fn>
+static void ForEachShard(Fn fn) {
+    size_t count = g_shardCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+        fn(*g_shards[i]);
+    }
+}
+
+// BACKPRESSURE STATS - Pulled from the running Sniffer's packet buffers
+static std::function<std::vector<BackpressureStats>()> g_backpressureProvider;
+static std::mutex g_backpressureMutex;
+
+// Cleared with nullptr before the Sniffer goes away
+void SetBackpressureStatsProvider(std::function<std::vector<BackpressureStats>()> provider) {
+    std::lock_guard<std::mutex> lock(g_backpressureMutex);
+    g_backpressureProvider = std::move(provider);
+}
+
+static void FillBackpressureStats(NativeCaptureStatistics* stats) {
+    std::vector<BackpressureStats> buffers;
+    {
+        std::lock_guard<std::mutex> lock(g_backpressureMutex);
+        if (g_backpressureProvider) {
+            buffers = g_backpressureProvider();
+        }
+    }
+
+    stats->droppedBufferFull = 0;
+    stats->droppedOldest = 0;
+    stats->droppedSampled = 0;
+    stats->producerStalls = 0;
+    stats->bufferedPackets = 0;
+    stats->bufferOccupancyPercent = 0;
+    stats->bufferHighWaterPercent = 0;
+    for (const auto& b : buffers) {
+        stats->droppedBufferFull += b.droppedFull;
+        stats->droppedOldest += b.droppedOldest;
+        stats->droppedSampled += b.droppedSampled;
+        stats->producerStalls += b.producerStalls;
+        stats->bufferedPackets += b.occupancy;
+        stats->bufferOccupancyPercent = (std::max)(stats->bufferOccupancyPercent, b.occupancyPercent);
+        stats->bufferHighWaterPercent = (std::max)(stats->bufferHighWaterPercent, b.highWaterPercent);
+    }
+}
+
+// FILTER STATS - Kernel counters from the running Sniffer's capture source
+static std::function<FilterStats()> g_filterProvider;
 
-// IP address counters
-static std::unordered_map<uint32_t, uint64_t> g_sourceIPCounts;
-static std::unordered_map<uint32_t, uint64_t> g_destIPCounts;
-static std::unordered_map<uint16_t, uint64_t> g_portCounts;
-static std::shared_mutex g_ipStatsMutex;  // Shared mutex for concurrent reads
+void SetFilterStatsProvider(std::function<FilterStats()> provider) {
+    std::lock_guard<std::mutex> lock(g_backpressureMutex);
+    g_filterProvider = std::move(provider);
+}
+
+static void FillFilterStats(NativeCaptureStatistics* stats) {
+    FilterStats filter;
+    {
+        std::lock_guard<std::mutex> lock(g_backpressureMutex);
+        if (g_filterProvider) {
+            filter = g_filterProvider();
+        }
+    }
+    stats->kernelReceived = filter.kernelReceived;
+    stats->kernelDropped = filter.kernelDropped;
+    stats->filteredPackets = filter.filtered;
+    stats->filterSwaps = filter.swaps;
+}
+
+// CAPTURE SETTINGS - Profile the running Sniffer's device was opened with
+static std::function<CaptureSettings()> g_settingsProvider;
+
+void SetCaptureSettingsProvider(std::function<CaptureSettings()> provider) {
+    std::lock_guard<std::mutex> lock(g_backpressureMutex);
+    g_settingsProvider = std::move(provider);
+}
+
+static void FillCaptureSettings(NativeCaptureStatistics* stats) {
+    CaptureSettings settings;
+    {
+        std::lock_guard<std::mutex> lock(g_backpressureMutex);
+        if (g_settingsProvider) {
+            settings = g_settingsProvider();
+        }
+    }
+    strncpy(stats->captureProfile, settings.profile.c_str(), sizeof(stats->captureProfile) - 1);
+    stats->captureProfile[sizeof(stats->captureProfile) - 1] = '\0';
+    stats->kernelBufferBytes = settings.bufferBytes;
+    stats->readTimeoutMs = settings.timeoutMs;
+    stats->immediateMode = settings.immediate ? 1 : 0;
+}
 
 // CACHED STATISTICS - Avoid re-sorting on every poll
 struct CachedTopStats {
-    std::vector<std::pair<uint32_t, uint64_t>> topSourceIPs;
-    std::vector<std::pair<uint32_t, uint64_t>> topDestIPs;
+    std::vector<std::pair<IpAddress, uint64_t>> topSourceIPs;
+    std::vector<std::pair<IpAddress, uint64_t>> topDestIPs;
     std::vector<std::pair<uint16_t, uint64_t>> topPorts;
     uint64_t lastUpdateCount = 0;  // Packet count when last updated
     bool dirty = true;  // Invalidated when data changes
@@ -40,12 +156,6 @@ static CachedTopStats g_cachedStats;
 static std::mutex g_cacheMutex;
 
 // HELPER FUNCTIONS
-static void IP4ToString(uint32_t ip, char* buffer, size_t bufferSize) {
-    struct in_addr addr;
-    addr.s_addr = ip;
-    inet_ntop(AF_INET, &addr, buffer, static_cast<socklen_t>(bufferSize));
-}
-
 static const char* GetServiceName(uint16_t port) {
     switch (port) {
         case 20: return "FTP-DATA";
@@ -76,9 +186,48 @@ static const char* GetServiceName(uint16_t port) {
     }
 }
 
+// MERGE HELPER - Sum per-shard counters into one vector
+template <typename K, typename H>
+static void MergeCounts(std::unordered_map<K, uint64_t, H> StatsShard::* member,
+                        std::vector<std::pair<K, uint64_t>>& out) {
+    size_t count = g_shardCount.load(std::memory_order_acquire);
+    if (count == 1) {
+        std::shared_lock<std::shared_mutex> lock(g_shards[0]->ipStatsMutex);
+        const auto& counts = (*g_shards[0]).*member;
+        out.assign(counts.begin(), counts.end());
+        return;
+    }
+    std::unordered_map<K, uint64_t, H> merged;
+    ForEachShard([&](StatsShard& shard) {
+        std::shared_lock<std::shared_mutex> lock(shard.ipStatsMutex);  // Shared lock for read
+        for (const auto& p : shard.*member) {
+            merged[p.first] += p.second;
+        }
+    });
+    out.assign(merged.begin(), merged.end());
+}
+
+static uint64_t TotalPacketsProcessed() {
+    uint64_t total = 0;
+    ForEachShard([&](StatsShard& shard) {
+        if (shard.clearPending.load(std::memory_order_acquire)) return;
+        total += shard.flowTracker->GetPacketsProcessed();
+    });
+    return total;
+}
+
+template <typename K>
+static void SortTop(std::vector<std::pair<K, uint64_t>>& v, size_t maxCount) {
+    size_t n = (std::min)(maxCount, v.size());
+    if (n > 0) {
+        std::partial_sort(v.begin(), v.begin() + n, v.end(),
+                          [](const auto& a, const auto& b) { return a.second > b.second; });
+    }
+}
+
 // CACHE UPDATE HELPER - Rebuilds cached top stats if needed
 static void UpdateCacheIfNeeded(size_t maxSourceIPs, size_t maxDestIPs, size_t maxPorts) {
-    uint64_t currentCount = g_flowTracker ? g_flowTracker->GetPacketsProcessed() : 0;
+    uint64_t currentCount = TotalPacketsProcessed();
     
     std::lock_guard<std::mutex> cacheLock(g_cacheMutex);
     
@@ -86,38 +235,15 @@ static void UpdateCacheIfNeeded(size_t maxSourceIPs, size_t maxDestIPs, size_t m
         return;  // Cache is still valid
     }
     
-    // Rebuild cache from current data (already holding shared lock on g_ipStatsMutex from caller)
-    // Note: This is called while holding a shared lock, so we only read
+    // Rebuild cache from the merged shard counters
+    MergeCounts(&StatsShard::sourceIPCounts, g_cachedStats.topSourceIPs);
+    SortTop(g_cachedStats.topSourceIPs, maxSourceIPs);
     
-    // Top source IPs
-    g_cachedStats.topSourceIPs.assign(g_sourceIPCounts.begin(), g_sourceIPCounts.end());
-    size_t nSrc = (std::min)(maxSourceIPs, g_cachedStats.topSourceIPs.size());
-    if (nSrc > 0) {
-        std::partial_sort(g_cachedStats.topSourceIPs.begin(), 
-                          g_cachedStats.topSourceIPs.begin() + nSrc, 
-                          g_cachedStats.topSourceIPs.end(),
-                          [](const auto& a, const auto& b) { return a.second > b.second; });
-    }
+    MergeCounts(&StatsShard::destIPCounts, g_cachedStats.topDestIPs);
+    SortTop(g_cachedStats.topDestIPs, maxDestIPs);
     
-    // Top dest IPs
-    g_cachedStats.topDestIPs.assign(g_destIPCounts.begin(), g_destIPCounts.end());
-    size_t nDst = (std::min)(maxDestIPs, g_cachedStats.topDestIPs.size());
-    if (nDst > 0) {
-        std::partial_sort(g_cachedStats.topDestIPs.begin(), 
-                          g_cachedStats.topDestIPs.begin() + nDst, 
-                          g_cachedStats.topDestIPs.end(),
-                          [](const auto& a, const auto& b) { return a.second > b.second; });
-    }
-    
-    // Top ports
-    g_cachedStats.topPorts.assign(g_portCounts.begin(), g_portCounts.end());
-    size_t nPorts = (std::min)(maxPorts, g_cachedStats.topPorts.size());
-    if (nPorts > 0) {
-        std::partial_sort(g_cachedStats.topPorts.begin(), 
-                          g_cachedStats.topPorts.begin() + nPorts, 
-                          g_cachedStats.topPorts.end(),
-                          [](const auto& a, const auto& b) { return a.second > b.second; });
-    }
+    MergeCounts(&StatsShard::portCounts, g_cachedStats.topPorts);
+    SortTop(g_cachedStats.topPorts, maxPorts);
     
     g_cachedStats.lastUpdateCount = currentCount;
     g_cachedStats.dirty = false;
@@ -125,32 +251,68 @@ static void UpdateCacheIfNeeded(size_t maxSourceIPs, size_t maxDestIPs, size_t m
 
 // INITIALIZATION
 
-void InitFlowTracker() {
-    std::unique_lock<std::shared_mutex> lock(g_flowTrackerMutex);  // Exclusive lock for write
-    if (!g_flowTracker) {
+// Grow to at least shardCount shards; called before the workers start
+void SetStatsShardCount(size_t shardCount) {
+    shardCount = (std::max)(static_cast<size_t>(1), (std::min)(shardCount, MAX_STATS_SHARDS));
+
+    std::lock_guard<std::mutex> lock(g_shardsMutex);
+    for (size_t i = g_shardCount.load(std::memory_order_relaxed); i < shardCount; i++) {
         FlowTracker::Config config;
         config.table_size = 65536;
         config.max_flows = 100000;
-        config.flow_timeout_us = 300 * 1000000ULL;  // 5 minutes
-        g_flowTracker = std::make_unique<FlowTracker>(config);
+        config.timeouts.tcp_established_ns = 300 * 1000000000ULL;  // 5 minutes
+        config.decap = g_decapConfig;
+        config.eviction = g_flowEviction;
+        g_shards[i] = std::make_unique<StatsShard>();
+        g_shards[i]->flowTracker = std::make_unique<FlowTracker>(config);
+        g_shardCount.store(i + 1, std::memory_order_release);
+    }
+}
+
+// Must match the decap used to shard packets, so a flow stays in one shard.
+// Like SetStatsFlowEviction, called before the workers start.
+void SetStatsDecapConfig(const DecapConfig& decap) {
+    std::lock_guard<std::mutex> lock(g_shardsMutex);
+    g_decapConfig = decap;
+    ForEachShard([&](StatsShard& shard) {
+        shard.flowTracker->SetDecapConfig(decap);
+    });
+}
+
+void SetStatsFlowEviction(FlowEvictionPolicy policy) {
+    std::lock_guard<std::mutex> lock(g_shardsMutex);
+    g_flowEviction = policy;
+    ForEachShard([&](StatsShard& shard) {
+        shard.flowTracker->SetEvictionPolicy(policy);
+    });
+}
+
+void InitFlowTracker() {
+    if (g_shardCount.load(std::memory_order_acquire) == 0) {
+        SetStatsShardCount(1);
     }
 }
 
-void ProcessPacketForStats(const uint8_t* data, uint32_t len, uint64_t timestamp_us) {
+// Called by exactly one worker per shard, with the view it already parsed
+void ProcessPacketForStats(size_t shardIndex, const PacketView& packet) {
     if (!g_nativeStatsEnabled) return;
     
     InitFlowTracker();
+    StatsShard& shard = *g_shards[shardIndex % g_shardCount.load(std::memory_order_acquire)];
     
-    std::unique_lock<std::shared_mutex> lock(g_flowTrackerMutex);  // Exclusive lock for write
-    FlowEntry* flow = g_flowTracker->ProcessPacket(data, len, timestamp_us);
+    if (shard.clearPending.load(std::memory_order_relaxed)) {
+        shard.flowTracker->Clear();
+        shard.clearPending.store(false, std::memory_order_release);
+    }
+    FlowEntry* flow = shard.flowTracker->ProcessPacket(packet);
     
     if (flow) {
         // Update IP/port statistics
-        std::unique_lock<std::shared_mutex> ipLock(g_ipStatsMutex);  // Exclusive lock for write
-        g_sourceIPCounts[flow->key.src_ip]++;
-        g_destIPCounts[flow->key.dst_ip]++;
-        if (flow->key.src_port > 0) g_portCounts[flow->key.src_port]++;
-        if (flow->key.dst_port > 0) g_portCounts[flow->key.dst_port]++;
+        std::unique_lock<std::shared_mutex> ipLock(shard.ipStatsMutex);  // Exclusive lock for write
+        shard.sourceIPCounts[flow->key.src_ip]++;
+        shard.destIPCounts[flow->key.dst_ip]++;
+        if (flow->key.src_port > 0) shard.portCounts[flow->key.src_port]++;
+        if (flow->key.dst_port > 0) shard.portCounts[flow->key.dst_port]++;
         
         // Mark cache as dirty (but don't invalidate immediately for performance)
         // Cache will be rebuilt on next query after threshold is reached
@@ -173,17 +335,47 @@ SNIFFER_API bool Sniffer_IsNativeStatsEnabled(void* sniffer) {
 }
 
 SNIFFER_API bool Sniffer_GetCaptureStatistics(void* sniffer, NativeCaptureStatistics* stats) {
-    if (!stats || !g_flowTracker) {
-        if (stats) memset(stats, 0, sizeof(NativeCaptureStatistics));
+    if (!stats || g_shardCount.load(std::memory_order_acquire) == 0) {
+        if (stats) {
+            memset(stats, 0, sizeof(NativeCaptureStatistics));
+            FillBackpressureStats(stats);
+            FillFilterStats(stats);
+            FillCaptureSettings(stats);
+        }
         return false;
     }
     
-    std::shared_lock<std::shared_mutex> lock(g_flowTrackerMutex);  // Shared lock for read
-    
-    stats->totalPackets = g_flowTracker->GetPacketsProcessed();
-    stats->totalBytes = g_flowTracker->GetBytesProcessed();
-    stats->activeFlows = g_flowTracker->GetFlowCount();
-    stats->captureDurationSeconds = g_flowTracker->GetCaptureDurationSeconds();
+    stats->totalPackets = 0;
+    stats->totalBytes = 0;
+    stats->activeFlows = 0;
+    stats->captureDurationSeconds = 0;
+    stats->datagramsReassembled = 0;
+    stats->fragmentsTimedOut = 0;
+    stats->fragmentsEvicted = 0;
+    stats->fragmentsDropped = 0;
+    stats->flowsExpired = 0;
+    stats->flowsEvicted = 0;
+    stats->flowsRejected = 0;
+    std::unordered_set<int> protocols;
+    
+    ForEachShard([&](StatsShard& shard) {
+        if (shard.clearPending.load(std::memory_order_acquire)) return;
+        const FragmentReassembler::Stats& fragments = shard.flowTracker->GetFragmentStats();
+        stats->datagramsReassembled += fragments.reassembled;
+        stats->fragmentsTimedOut += fragments.timed_out;
+        stats->fragmentsEvicted += fragments.evicted;
+        stats->fragmentsDropped += fragments.dropped;
+        const FlowTable& flows = shard.flowTracker->GetFlowTable();
+        stats->flowsExpired += flows.GetTotalExpired();
+        stats->flowsEvicted += flows.GetTotalEvicted();
+        stats->flowsRejected += flows.GetTotalRejected();
+        stats->totalPackets += shard.flowTracker->GetPacketsProcessed();
+        stats->totalBytes += shard.flowTracker->GetBytesProcessed();
+        stats->activeFlows += shard.flowTracker->GetFlowCount();
+        stats->captureDurationSeconds = (std::max)(stats->captureDurationSeconds,
+                                                   shard.flowTracker->GetCaptureDurationSeconds());
+        shard.flowTracker->CollectProtocols(protocols);
+    });
     
     if (stats->captureDurationSeconds > 0) {
         stats->packetsPerSecond = static_cast<double>(stats->totalPackets) / stats->captureDurationSeconds;
@@ -193,23 +385,44 @@ SNIFFER_API bool Sniffer_GetCaptureStatistics(void* sniffer, NativeCaptureStatis
         stats->bytesPerSecond = 0;
     }
     
-    // Use pre-computed unique protocol count instead of iterating all flows
-    stats->uniqueProtocols = static_cast<int>(g_flowTracker->GetUniqueProtocolCount());
+    // Protocols and addresses can repeat across shards, so count the union
+    stats->uniqueProtocols = static_cast<int>(protocols.size());
     
-    std::shared_lock<std::shared_mutex> ipLock(g_ipStatsMutex);  // Shared lock for read
-    stats->uniqueSourceIPs = static_cast<int>(g_sourceIPCounts.size());
-    stats->uniqueDestIPs = static_cast<int>(g_destIPCounts.size());
+    if (g_shardCount.load(std::memory_order_acquire) == 1) {
+        std::shared_lock<std::shared_mutex> ipLock(g_shards[0]->ipStatsMutex);  // Shared lock for read
+        stats->uniqueSourceIPs = static_cast<int>(g_shards[0]->sourceIPCounts.size());
+        stats->uniqueDestIPs = static_cast<int>(g_shards[0]->destIPCounts.size());
+    } else {
+        std::unordered_set<IpAddress, IpAddressHash> sources, destinations;
+        ForEachShard([&](StatsShard& shard) {
+            std::shared_lock<std::shared_mutex> ipLock(shard.ipStatsMutex);  // Shared lock for read
+            for (const auto& p : shard.sourceIPCounts) sources.insert(p.first);
+            for (const auto& p : shard.destIPCounts) destinations.insert(p.first);
+        });
+        stats->uniqueSourceIPs = static_cast<int>(sources.size());
+        stats->uniqueDestIPs = static_cast<int>(destinations.size());
+    }
     
+    FillBackpressureStats(stats);
+    FillFilterStats(stats);
+    FillCaptureSettings(stats);
     return true;
 }
 
 SNIFFER_API int Sniffer_GetProtocolStats(void* sniffer, NativeProtocolStats* stats, int maxCount) {
-    if (!stats || !g_flowTracker || maxCount <= 0) return 0;
-    
-    std::shared_lock<std::shared_mutex> lock(g_flowTrackerMutex);  // Shared lock for read
-    
-    // Use GetAggregatedStats() to avoid full flow copy
-    auto aggStats = g_flowTracker->GetFlowTable().GetAggregatedStats();
+    if (!stats || g_shardCount.load(std::memory_order_acquire) == 0 || maxCount <= 0) return 0;
+    
+    // Use GetAggregatedStats() per shard to avoid full flow copy. The table
+    // locks stripe by stripe, so the shard's worker keeps running meanwhile.
+    FlowTable::AggregatedFlowStats aggStats;
+    ForEachShard([&](StatsShard& shard) {
+        if (shard.clearPending.load(std::memory_order_acquire)) return;
+        auto shardStats = shard.flowTracker->GetFlowTable().GetAggregatedStats();
+        aggStats.total_packets += shardStats.total_packets;
+        aggStats.total_bytes += shardStats.total_bytes;
+        for (const auto& p : shardStats.protocol_counts) aggStats.protocol_counts[p.first] += p.second;
+        for (const auto& p : shardStats.protocol_bytes) aggStats.protocol_bytes[p.first] += p.second;
+    });
     uint64_t totalPackets = aggStats.total_packets;
     
     // Convert to vector for sorting
@@ -242,8 +455,6 @@ SNIFFER_API int Sniffer_GetProtocolStats(void* sniffer, NativeProtocolStats* sta
 SNIFFER_API int Sniffer_GetTopSourceIPs(void* sniffer, NativeTalkerStats* stats, int maxCount) {
     if (!stats || maxCount <= 0) return 0;
     
-    std::shared_lock<std::shared_mutex> lock(g_ipStatsMutex);  // Shared lock for read
-    
     // Update cache if needed (uses cached sorted results to avoid re-sorting)
     UpdateCacheIfNeeded(static_cast<size_t>(maxCount), 10, 10);
     
@@ -252,7 +463,7 @@ SNIFFER_API int Sniffer_GetTopSourceIPs(void* sniffer, NativeTalkerStats* stats,
     
     int count = static_cast<int>(n);
     for (int i = 0; i < count; i++) {
-        IP4ToString(g_cachedStats.topSourceIPs[i].first, stats[i].ipAddress, 64);
+        g_cachedStats.topSourceIPs[i].first.ToString(stats[i].ipAddress, 64);
         stats[i].packetCount = g_cachedStats.topSourceIPs[i].second;
         stats[i].byteCount = 0;  // Not tracked per-IP currently
     }
@@ -263,8 +474,6 @@ SNIFFER_API int Sniffer_GetTopSourceIPs(void* sniffer, NativeTalkerStats* stats,
 SNIFFER_API int Sniffer_GetTopDestIPs(void* sniffer, NativeTalkerStats* stats, int maxCount) {
     if (!stats || maxCount <= 0) return 0;
     
-    std::shared_lock<std::shared_mutex> lock(g_ipStatsMutex);  // Shared lock for read
-    
     // Update cache if needed
     UpdateCacheIfNeeded(10, static_cast<size_t>(maxCount), 10);
     
@@ -273,7 +482,7 @@ SNIFFER_API int Sniffer_GetTopDestIPs(void* sniffer, NativeTalkerStats* stats, i
     
     int count = static_cast<int>(n);
     for (int i = 0; i < count; i++) {
-        IP4ToString(g_cachedStats.topDestIPs[i].first, stats[i].ipAddress, 64);
+        g_cachedStats.topDestIPs[i].first.ToString(stats[i].ipAddress, 64);
         stats[i].packetCount = g_cachedStats.topDestIPs[i].second;
         stats[i].byteCount = 0;
     }
@@ -284,8 +493,6 @@ SNIFFER_API int Sniffer_GetTopDestIPs(void* sniffer, NativeTalkerStats* stats, i
 SNIFFER_API int Sniffer_GetTopPorts(void* sniffer, NativePortStats* stats, int maxCount) {
     if (!stats || maxCount <= 0) return 0;
     
-    std::shared_lock<std::shared_mutex> lock(g_ipStatsMutex);  // Shared lock for read
-    
     // Update cache if needed
     UpdateCacheIfNeeded(10, 10, static_cast<size_t>(maxCount));
     
@@ -304,31 +511,35 @@ SNIFFER_API int Sniffer_GetTopPorts(void* sniffer, NativePortStats* stats, int m
 }
 
 SNIFFER_API void Sniffer_ClearStatistics(void* sniffer) {
-    {
-        std::unique_lock<std::shared_mutex> lock(g_flowTrackerMutex);  // Exclusive lock for write
-        if (g_flowTracker) {
-            g_flowTracker->Clear();
+    ForEachShard([](StatsShard& shard) {
+        // The tracker is cleared by its worker; with stats off none is feeding it
+        if (g_nativeStatsEnabled) {
+            shard.clearPending.store(true, std::memory_order_release);
+        } else {
+            shard.flowTracker->Clear();
         }
-    }
-    
-    {
-        std::unique_lock<std::shared_mutex> lock(g_ipStatsMutex);  // Exclusive lock for write
-        g_sourceIPCounts.clear();
-        g_destIPCounts.clear();
-        g_portCounts.clear();
         
-        // Invalidate cache
-        std::lock_guard<std::mutex> cacheLock(g_cacheMutex);
-        g_cachedStats.Invalidate();
-        g_cachedStats.topSourceIPs.clear();
-        g_cachedStats.topDestIPs.clear();
-        g_cachedStats.topPorts.clear();
-    }
+        std::unique_lock<std::shared_mutex> lock(shard.ipStatsMutex);  // Exclusive lock for write
+        shard.sourceIPCounts.clear();
+        shard.destIPCounts.clear();
+        shard.portCounts.clear();
+    });
+    
+    // Invalidate cache
+    std::lock_guard<std::mutex> cacheLock(g_cacheMutex);
+    g_cachedStats.Invalidate();
+    g_cachedStats.topSourceIPs.clear();
+    g_cachedStats.topDestIPs.clear();
+    g_cachedStats.topPorts.clear();
 }
 
 SNIFFER_API uint64_t Sniffer_GetFlowCount(void* sniffer) {
-    std::shared_lock<std::shared_mutex> lock(g_flowTrackerMutex);  // Shared lock for read
-    return g_flowTracker ? g_flowTracker->GetFlowCount() : 0;
+    uint64_t total = 0;
+    ForEachShard([&](StatsShard& shard) {
+        if (shard.clearPending.load(std::memory_order_acquire)) return;
+        total += shard.flowTracker->GetFlowCount();
+    });
+    return total;
 }
 
 } // extern "C"
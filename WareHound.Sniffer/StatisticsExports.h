@@ -24,7 +24,7 @@ struct NativeProtocolStats {
 
 // IP talker statistics entry
 struct NativeTalkerStats {
-    char ipAddress[64];
+    char ipAddress[64];  // IPv4 dotted quad or IPv6 text form
     uint64_t packetCount;
     uint64_t byteCount;
 };
@@ -47,6 +47,38 @@ struct NativeCaptureStatistics {
     int uniqueProtocols;
     int uniqueSourceIPs;
     int uniqueDestIPs;
+
+    // Pipeline backpressure, summed over all packet buffers
+    uint64_t droppedBufferFull;
+    uint64_t droppedOldest;
+    uint64_t droppedSampled;
+    uint64_t producerStalls;
+    uint64_t bufferedPackets;
+    double bufferOccupancyPercent;  // Fullest buffer, now
+    double bufferHighWaterPercent;  // Fullest buffer, peak since start
+
+    // Kernel BPF filter effect since capture started
+    uint64_t kernelReceived;
+    uint64_t kernelDropped;
+    uint64_t filteredPackets;       // 0 where the backend only counts accepted frames
+    uint64_t filterSwaps;
+
+    // Capture profile the device was opened with
+    char captureProfile[16];        // Empty if not opened through builderDevice
+    int32_t kernelBufferBytes;      // 0 if the driver default was kept
+    int32_t readTimeoutMs;
+    int32_t immediateMode;
+
+    // IP fragment reassembly, summed over all shards
+    uint64_t datagramsReassembled;
+    uint64_t fragmentsTimedOut;
+    uint64_t fragmentsEvicted;      // Over the memory budget or the per-source limit
+    uint64_t fragmentsDropped;      // Malformed or overlapping
+
+    // Flow table removals, summed over all shards
+    uint64_t flowsExpired;
+    uint64_t flowsEvicted;          // Made room for a new flow when the table was full
+    uint64_t flowsRejected;         // New flows not tracked: table full, nothing evicted
 };
 
 #pragma pack(pop)
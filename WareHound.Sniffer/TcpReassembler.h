@@ -0,0 +1,349 @@
+#pragma once
+#ifndef TCP_REASSEMBLER_H
+#define TCP_REASSEMBLER_H
+
+#include "PacketParser.h"
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <functional>
+
+namespace WareHound {
+
+// TCP STREAM - Reassembly state for one direction of a flow
+// Lives in the FlowEntry; data that arrived ahead of a hole is held in the
+// owning TcpReassembler's segment pool and only referenced from here
+struct TcpStream {
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    uint32_t next_seq = 0;       // Next byte to deliver
+    uint32_t pending = NONE;     // First buffered segment, lowest seq first
+    uint32_t pending_bytes = 0;
+    bool synced = false;         // next_seq is known
+    void* owner = nullptr;       // Set by the caller; handed back on eviction
+
+    // Streams holding segments, oldest first; owned by the TcpReassembler
+    TcpStream* older = nullptr;
+    TcpStream* newer = nullptr;
+
+    bool HasPending() const { return pending != NONE; }
+};
+
+// TCP REASSEMBLER - Turns segments into in-order bytes, per direction
+// In-order data is handed straight to the consumer without copying; only
+// segments past a hole are copied into fixed-size pooled segments, and
+// delivered once the hole fills. A stream that was joined mid-connection
+// starts at its first data segment. Bounded two ways: bytes buffered per
+// stream and segments in the pool, shared by every stream. Over its own
+// limit a stream delivers what it has buffered, skipping its holes, so no
+// stream waits forever on a lost segment. When the pool runs dry the
+// stream that has been buffering longest is flushed through the evict
+// callback first; only if none can be does the new segment's stream give up. Retransmitted bytes are trimmed
+// against what was already delivered; the first copy wins.
+// Needs full-payload capture: bytes cut off by the snaplen read as a hole.
+// Not thread-safe; one per FlowTracker, like the flow table it serves.
+class TcpReassembler {
+public:
+    static constexpr uint32_t SEGMENT_BYTES = 2048;
+    static constexpr uint32_t SEGMENTS_PER_BLOCK = 256;
+
+    struct Config {
+        size_t max_bytes = 16 * 1024 * 1024;       // Pool size, all streams
+        size_t max_stream_bytes = 256 * 1024;      // Buffered per direction
+    };
+
+    struct Stats {
+        uint64_t delivered_bytes = 0;
+        uint64_t out_of_order = 0;    // Segments that arrived ahead of a hole
+        uint64_t overlap_bytes = 0;   // Already delivered or buffered; discarded
+        uint64_t gaps = 0;            // Holes skipped
+        uint64_t evictions = 0;       // Streams flushed for a limit, or released holding data
+    };
+
+    TcpReassembler() : TcpReassembler(Config()) {}
+    explicit TcpReassembler(const Config& config)
+        : config_(config)
+        , max_segments_((std::max)(static_cast<size_t>(1), config.max_bytes / SEGMENT_BYTES))
+        , created_(0)
+        , in_use_(0)
+        , free_(TcpStream::NONE) {}
+
+    TcpReassembler(const TcpReassembler&) = delete;
+    TcpReassembler& operator=(const TcpReassembler&) = delete;
+
+    // EVICT CALLBACK - The pool is exhausted: Flush stream, another one
+    // holding segments, with its own deliver. False if it cannot be flushed
+    // now; the next oldest is asked instead.
+    typedef std::function<bool(TcpStream& stream)> EvictCallback;
+    void SetEvictCallback(EvictCallback callback) { evict_ = std::move(callback); }
+
+    // ADD - One segment. deliver(const uint8_t*, uint32_t) is called with
+    // each run of in-order bytes, possibly several times.
+    template <typename Deliver>
+    void Add(TcpStream& stream, uint32_t seq, uint8_t flags, const uint8_t* data, uint32_t len, Deliver&& deliver) {
+        if (flags & TcpFlags::SYN) {
+            if (!stream.synced) {
+                stream.next_seq = seq + 1;
+                stream.synced = true;
+            }
+            seq++;   // The SYN takes a sequence number; any data follows it
+        }
+        if (len == 0 || data == nullptr) {
+            return;
+        }
+        if (!stream.synced) {
+            stream.next_seq = seq;
+            stream.synced = true;
+        }
+
+        int32_t ahead = SeqDiff(seq, stream.next_seq);
+        if (ahead > 0) {
+            Buffer(stream, seq, data, len, deliver);
+            return;
+        }
+        uint32_t seen = static_cast<uint32_t>(-static_cast<int64_t>(ahead));
+        if (seen >= len) {
+            stats_.overlap_bytes += len;
+            return;
+        }
+        stats_.overlap_bytes += seen;
+        Emit(stream, data + seen, len - seen, deliver);
+        Drain(stream, deliver);
+    }
+
+    // FLUSH - Deliver everything buffered, skipping holes (end of stream)
+    template <typename Deliver>
+    void Flush(TcpStream& stream, Deliver&& deliver) {
+        while (stream.HasPending()) {
+            uint32_t index = stream.pending;
+            Segment& segment = At(index);
+            if (SeqDiff(segment.seq, stream.next_seq) > 0) {
+                stats_.gaps++;
+                stream.next_seq = segment.seq;
+            }
+            Pop(stream);
+            Consume(stream, segment, deliver);
+            Free(index);
+        }
+    }
+
+    // RELEASE - Return a stream's segments without delivering them
+    void Release(TcpStream& stream) {
+        if (stream.HasPending()) {
+            stats_.evictions++;
+        }
+        Drop(stream);
+    }
+
+    // Segments go back to the pool; streams still pointing at them must be
+    // discarded with it
+    void Clear() {
+        blocks_.clear();
+        created_ = 0;
+        in_use_ = 0;
+        free_ = TcpStream::NONE;
+        oldest_ = nullptr;
+        newest_ = nullptr;
+        stats_ = Stats();
+    }
+
+    const Stats& GetStats() const { return stats_; }
+    size_t GetBufferedSegments() const { return in_use_; }
+
+private:
+    struct Segment {
+        uint32_t seq;
+        uint32_t len;
+        uint32_t next;
+        uint8_t data[SEGMENT_BYTES];
+    };
+
+    // Serial number arithmetic (RFC 1982): a ahead of b when positive
+    static int32_t SeqDiff(uint32_t a, uint32_t b) {
+        return static_cast<int32_t>(a - b);
+    }
+
+    Segment& At(uint32_t index) {
+        return blocks_[index / SEGMENTS_PER_BLOCK][index % SEGMENTS_PER_BLOCK];
+    }
+
+    uint32_t Allocate() {
+        uint32_t index = free_;
+        if (index != TcpStream::NONE) {
+            free_ = At(index).next;
+        } else if (created_ < max_segments_) {
+            if (created_ % SEGMENTS_PER_BLOCK == 0) {
+                blocks_.emplace_back(new Segment[SEGMENTS_PER_BLOCK]);
+            }
+            index = static_cast<uint32_t>(created_++);
+        } else {
+            return TcpStream::NONE;
+        }
+        in_use_++;
+        return index;
+    }
+
+    void Free(uint32_t index) {
+        At(index).next = free_;
+        free_ = index;
+        in_use_--;
+    }
+
+    void Pop(TcpStream& stream) {
+        Segment& segment = At(stream.pending);
+        stream.pending_bytes -= segment.len;
+        stream.pending = segment.next;
+        if (!stream.HasPending()) {
+            Unlink(stream);
+        }
+    }
+
+    void Drop(TcpStream& stream) {
+        while (stream.HasPending()) {
+            uint32_t index = stream.pending;
+            Pop(stream);
+            Free(index);
+        }
+    }
+
+    void Link(TcpStream& stream) {
+        stream.older = newest_;
+        stream.newer = nullptr;
+        (newest_ ? newest_->newer : oldest_) = &stream;
+        newest_ = &stream;
+    }
+
+    void Unlink(TcpStream& stream) {
+        (stream.older ? stream.older->newer : oldest_) = stream.newer;
+        (stream.newer ? stream.newer->older : newest_) = stream.older;
+        stream.older = stream.newer = nullptr;
+    }
+
+    // Flush the oldest other stream holding segments; false if none could be
+    bool Reclaim(const TcpStream& current) {
+        if (!evict_) {
+            return false;
+        }
+        for (TcpStream* victim = oldest_; victim != nullptr;) {
+            TcpStream* next = victim->newer;
+            if (victim != &current && evict_(*victim)) {
+                stats_.evictions++;
+                Drop(*victim);  // In case the callback left anything
+                return true;
+            }
+            victim = next;
+        }
+        return false;
+    }
+
+    template <typename Deliver>
+    void Emit(TcpStream& stream, const uint8_t* data, uint32_t len, Deliver& deliver) {
+        deliver(data, len);
+        stream.next_seq += len;
+        stats_.delivered_bytes += len;
+    }
+
+    // Deliver a buffered segment that starts at or before next_seq
+    template <typename Deliver>
+    void Consume(TcpStream& stream, const Segment& segment, Deliver& deliver) {
+        uint32_t seen = static_cast<uint32_t>(-static_cast<int64_t>(SeqDiff(segment.seq, stream.next_seq)));
+        if (seen >= segment.len) {
+            stats_.overlap_bytes += segment.len;
+            return;
+        }
+        stats_.overlap_bytes += seen;
+        Emit(stream, segment.data + seen, segment.len - seen, deliver);
+    }
+
+    // Deliver buffered segments the stream has caught up with
+    template <typename Deliver>
+    void Drain(TcpStream& stream, Deliver& deliver) {
+        while (stream.HasPending() && SeqDiff(At(stream.pending).seq, stream.next_seq) <= 0) {
+            uint32_t index = stream.pending;
+            Pop(stream);
+            Consume(stream, At(index), deliver);
+            Free(index);
+        }
+    }
+
+    // Copy a segment past a hole into the pool, in seq order. Over a limit,
+    // the stream gives up on its holes: buffered data goes out, then this.
+    template <typename Deliver>
+    void Buffer(TcpStream& stream, uint32_t seq, const uint8_t* data, uint32_t len, Deliver& deliver) {
+        stats_.out_of_order++;
+        if (stream.pending_bytes + len > config_.max_stream_bytes) {
+            SkipTo(stream, seq, data, len, deliver);
+            return;
+        }
+
+        uint32_t insert_after = TcpStream::NONE;
+        for (uint32_t offset = 0; offset < len; offset += SEGMENT_BYTES) {
+            uint32_t index = Allocate();
+            while (index == TcpStream::NONE && Reclaim(stream)) {
+                index = Allocate();
+            }
+            if (index == TcpStream::NONE) {
+                SkipTo(stream, seq + offset, data + offset, len - offset, deliver);
+                return;
+            }
+            Segment& segment = At(index);
+            segment.seq = seq + offset;
+            segment.len = (std::min)(len - offset, SEGMENT_BYTES);
+            memcpy(segment.data, data + offset, segment.len);
+            stream.pending_bytes += segment.len;
+
+            // Pieces of one segment follow each other, so only the first searches
+            if (insert_after == TcpStream::NONE) {
+                uint32_t cursor = stream.pending;
+                while (cursor != TcpStream::NONE && SeqDiff(At(cursor).seq, segment.seq) <= 0) {
+                    insert_after = cursor;
+                    cursor = At(cursor).next;
+                }
+            }
+            if (!stream.HasPending()) {
+                Link(stream);
+            }
+            if (insert_after == TcpStream::NONE) {
+                segment.next = stream.pending;
+                stream.pending = index;
+            } else {
+                segment.next = At(insert_after).next;
+                At(insert_after).next = index;
+            }
+            insert_after = index;
+        }
+    }
+
+    template <typename Deliver>
+    void SkipTo(TcpStream& stream, uint32_t seq, const uint8_t* data, uint32_t len, Deliver& deliver) {
+        stats_.evictions++;
+        Flush(stream, deliver);
+        int32_t ahead = SeqDiff(seq, stream.next_seq);
+        if (ahead > 0) {
+            stats_.gaps++;
+            stream.next_seq = seq;
+        }
+        uint32_t seen = ahead < 0 ? static_cast<uint32_t>(-static_cast<int64_t>(ahead)) : 0;
+        if (seen >= len) {
+            stats_.overlap_bytes += len;
+            return;
+        }
+        stats_.overlap_bytes += seen;
+        Emit(stream, data + seen, len - seen, deliver);
+    }
+
+    Config config_;
+    size_t max_segments_;
+    std::vector<std::unique_ptr<Segment[]>> blocks_;
+    size_t created_;
+    size_t in_use_;
+    uint32_t free_;
+    TcpStream* oldest_ = nullptr;
+    TcpStream* newest_ = nullptr;
+    EvictCallback evict_;
+    Stats stats_;
+};
+
+}
+
+#endif // TCP_REASSEMBLER_H
@@ -0,0 +1,208 @@
+#pragma once
+#ifndef THREAD_PLACEMENT_H
+#define THREAD_PLACEMENT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+#endif
+
+namespace WareHound {
+
+// THREAD PLACEMENT - Core pinning and NUMA-local memory for pipeline threads
+//
+// Core ids and masks follow the vendored pcpp SystemUtils helpers (bit n of
+// a CoreMask is core n), which the sniffer project does not compile.
+// Everything degrades to a no-op: an unknown node allocates normally and a
+// failed pin leaves the thread where the scheduler put it.
+typedef uint64_t CoreMask;
+
+constexpr int ANY_CORE = -1;
+constexpr int ANY_NODE = -1;
+
+inline int CoreCount() {
+    unsigned int n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : static_cast<int>(n);
+}
+
+inline CoreMask CoreMaskForAllCores() {
+    int n = CoreCount();
+    return n >= 64 ? ~CoreMask(0) : (CoreMask(1) << n) - 1;
+}
+
+inline CoreMask CoreMaskFromIds(const std::vector<int>& coreIds) {
+    CoreMask mask = 0;
+    for (int id : coreIds) {
+        if (id >= 0 && id < 64) {
+            mask |= CoreMask(1) << id;
+        }
+    }
+    return mask;
+}
+
+inline std::vector<int> CoreIdsFromMask(CoreMask mask) {
+    std::vector<int> ids;
+    for (int id = 0; id < 64 && mask != 0; id++, mask >>= 1) {
+        if (mask & 1) {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+// NUMA node of a core, or ANY_NODE if unknown
+inline int NumaNodeOfCore(int core) {
+    if (core < 0) {
+        return ANY_NODE;
+    }
+#ifdef _WIN32
+    UCHAR node = 0;
+    if (core > 255 || !GetNumaProcessorNode(static_cast<UCHAR>(core), &node) || node == 0xFF) {
+        return ANY_NODE;
+    }
+    return node;
+#else
+    // sysfs links each cpu to its node as cpuN/nodeM
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(core);
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return ANY_NODE;
+    }
+    int node = ANY_NODE;
+    while (struct dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+#endif
+}
+
+// Restrict the calling thread to one core; false if core is ANY_CORE or
+// the OS refused
+inline bool PinCurrentThread(int core) {
+    if (core < 0) {
+        return false;
+    }
+#ifdef _WIN32
+    if (core >= 64) {
+        return false;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core) != 0;
+#elif defined(__linux__)
+    if (core >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+// NODE ARRAY - Fixed-size array whose pages prefer one NUMA node
+// Pages are bound before the elements are constructed, so the first touch
+// already lands on the right node regardless of the constructing thread.
+template <typename T>
+class NodeArray {
+public:
+    NodeArray(size_t count, int node = ANY_NODE)
+        : data_(nullptr), count_(count), bytes_(count * sizeof(T)), mapped_(false)
+    {
+        if (node >= 0) {
+            mapped_ = AllocateOnNode(node);
+        }
+        if (!mapped_) {
+            data_ = static_cast<T*>(::operator new(bytes_));
+        }
+        for (size_t i = 0; i < count_; i++) {
+            new (&data_[i]) T();
+        }
+    }
+
+    ~NodeArray() {
+        if constexpr (!std::is_trivially_destructible<T>::value) {
+            for (size_t i = 0; i < count_; i++) {
+                data_[i].~T();
+            }
+        }
+        if (mapped_) {
+#ifdef _WIN32
+            VirtualFree(data_, 0, MEM_RELEASE);
+#else
+            munmap(data_, bytes_);
+#endif
+        } else {
+            ::operator delete(data_);
+        }
+    }
+
+    NodeArray(const NodeArray&) = delete;
+    NodeArray& operator=(const NodeArray&) = delete;
+
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    T* get() { return data_; }
+    const T* get() const { return data_; }
+
+private:
+    bool AllocateOnNode(int node) {
+#ifdef _WIN32
+        void* p = VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes_, MEM_RESERVE | MEM_COMMIT,
+                                     PAGE_READWRITE, static_cast<DWORD>(node));
+        if (!p) {
+            return false;
+        }
+        data_ = static_cast<T*>(p);
+        return true;
+#elif defined(__linux__)
+        if (node >= 64) {
+            return false;
+        }
+        void* p = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        // Preferred rather than bound: a full node falls back instead of failing
+        unsigned long nodemask = 1UL << node;
+        syscall(SYS_mbind, p, bytes_, MPOL_PREFERRED, &nodemask, sizeof(nodemask) * 8, 0);
+        data_ = static_cast<T*>(p);
+        return true;
+#else
+        (void)node;
+        return false;
+#endif
+    }
+
+    T* data_;
+    size_t count_;
+    size_t bytes_;
+    bool mapped_;
+};
+
+} // namespace WareHound
+
+#endif // THREAD_PLACEMENT_H
@@ -0,0 +1,204 @@
+#pragma once
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace WareHound {
+namespace Bench {
+
+// TIMING
+inline uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline void Report(const char* name, uint64_t ops, uint64_t elapsed_ns) {
+    double seconds = elapsed_ns / 1e9;
+    std::printf("%-40s %12llu ops %10.3f ms %9.2f ns/op %10.3f Mops/s\n", name,
+                static_cast<unsigned long long>(ops), elapsed_ns / 1e6,
+                ops ? static_cast<double>(elapsed_ns) / ops : 0.0,
+                seconds > 0 ? ops / seconds / 1e6 : 0.0);
+    std::fflush(stdout);
+}
+
+// Keeps the compiler from dropping work whose result is otherwise unused
+template <typename T>
+inline void DoNotOptimize(T& value) {
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+    static volatile const void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r"(&value) : "memory");
+#endif
+}
+
+// Fastest of rounds passes of body(0..iterations-1), in ns
+template <typename Fn>
+inline uint64_t BestOf(int rounds, uint64_t iterations, Fn&& body) {
+    uint64_t best = UINT64_MAX;
+    for (int round = 0; round < rounds; round++) {
+        uint64_t start = NowNs();
+        for (uint64_t i = 0; i < iterations; i++) {
+            body(i);
+        }
+        uint64_t elapsed = NowNs() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+// Positional argument i, or fallback
+inline uint64_t Arg(int argc, char** argv, int i, uint64_t fallback) {
+    return argc > i ? std::strtoull(argv[i], nullptr, 10) : fallback;
+}
+
+// Deterministic, so runs compare packet for packet
+struct Rng {
+    uint64_t state;
+    explicit Rng(uint64_t seed = 0x9E3779B97F4A7C15ULL) : state(seed) {}
+    uint64_t Next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+// FRAME BUILDER - Ethernet frames with valid IPv4/IPv6 and TCP/UDP headers
+struct FrameSpec {
+    uint8_t ip_version = 4;
+    uint8_t protocol = 6;          // IPPROTO_TCP or IPPROTO_UDP
+    uint8_t src[16] = {10, 0, 0, 1};
+    uint8_t dst[16] = {10, 0, 0, 2};
+    uint16_t src_port = 40000;
+    uint16_t dst_port = 80;
+    uint8_t tcp_flags = 0x18;      // PSH|ACK
+    uint32_t seq = 1;
+    uint16_t vlan = 0;             // Non-zero adds one 802.1Q tag
+    uint32_t payload_len = 0;
+};
+
+inline void Put16(std::vector<uint8_t>& f, uint16_t v) {
+    f.push_back(static_cast<uint8_t>(v >> 8));
+    f.push_back(static_cast<uint8_t>(v));
+}
+
+inline void Put32(std::vector<uint8_t>& f, uint32_t v) {
+    Put16(f, static_cast<uint16_t>(v >> 16));
+    Put16(f, static_cast<uint16_t>(v));
+}
+
+inline std::vector<uint8_t> BuildFrame(const FrameSpec& spec) {
+    std::vector<uint8_t> f;
+    static const uint8_t macs[12] = {2, 0, 0, 0, 0, 2, 2, 0, 0, 0, 0, 1};
+    f.insert(f.end(), macs, macs + 12);
+    if (spec.vlan) {
+        Put16(f, 0x8100);
+        Put16(f, spec.vlan);
+    }
+    Put16(f, spec.ip_version == 6 ? 0x86DD : 0x0800);
+
+    uint32_t l4_len = (spec.protocol == 6 ? 20 : 8) + spec.payload_len;
+    if (spec.ip_version == 6) {
+        Put32(f, 0x60000000);
+        Put16(f, static_cast<uint16_t>(l4_len));
+        f.push_back(spec.protocol);
+        f.push_back(64);
+        f.insert(f.end(), spec.src, spec.src + 16);
+        f.insert(f.end(), spec.dst, spec.dst + 16);
+    } else {
+        f.push_back(0x45);
+        f.push_back(0);
+        Put16(f, static_cast<uint16_t>(20 + l4_len));
+        Put16(f, 1);
+        Put16(f, 0x4000);  // DF
+        f.push_back(64);
+        f.push_back(spec.protocol);
+        Put16(f, 0);
+        f.insert(f.end(), spec.src, spec.src + 4);
+        f.insert(f.end(), spec.dst, spec.dst + 4);
+    }
+
+    Put16(f, spec.src_port);
+    Put16(f, spec.dst_port);
+    if (spec.protocol == 6) {
+        Put32(f, spec.seq);
+        Put32(f, 0);
+        f.push_back(0x50);
+        f.push_back(spec.tcp_flags);
+        Put16(f, 65535);
+        Put16(f, 0);
+        Put16(f, 0);
+    } else {
+        Put16(f, static_cast<uint16_t>(l4_len));
+        Put16(f, 0);
+    }
+    for (uint32_t i = 0; i < spec.payload_len; i++) {
+        f.push_back(static_cast<uint8_t>('a' + i % 26));
+    }
+    return f;
+}
+
+// Flow i of a synthetic population: distinct IPv4 source and port
+inline FrameSpec FlowSpec(uint32_t i, uint8_t protocol = 6, uint32_t payload_len = 64) {
+    FrameSpec spec;
+    spec.protocol = protocol;
+    spec.src[0] = 10;
+    spec.src[1] = static_cast<uint8_t>(i >> 16);
+    spec.src[2] = static_cast<uint8_t>(i >> 8);
+    spec.src[3] = static_cast<uint8_t>(i);
+    spec.src_port = static_cast<uint16_t>(1024 + i % 60000);
+    spec.payload_len = payload_len;
+    return spec;
+}
+
+// count frames of distinct flows; IPv6 flows use 2001:db8::/32 addresses
+inline std::vector<std::vector<uint8_t>> FlowFrames(uint32_t count, uint8_t ip_version, uint8_t protocol,
+                                                    uint16_t vlan = 0, uint32_t payload_len = 64) {
+    std::vector<std::vector<uint8_t>> frames;
+    for (uint32_t i = 0; i < count; i++) {
+        FrameSpec spec = FlowSpec(i, protocol, payload_len);
+        spec.vlan = vlan;
+        if (ip_version == 6) {
+            static const uint8_t prefix[4] = {0x20, 0x01, 0x0D, 0xB8};
+            spec.ip_version = 6;
+            std::memcpy(spec.src, prefix, 4);
+            std::memcpy(spec.dst, prefix, 4);
+            spec.src[15] = static_cast<uint8_t>(i);
+            spec.src[14] = static_cast<uint8_t>(i >> 8);
+            spec.dst[15] = 1;
+        }
+        frames.push_back(BuildFrame(spec));
+    }
+    return frames;
+}
+
+// inner carried in VXLAN over IPv4/UDP between two tunnel endpoints
+inline std::vector<uint8_t> BuildVxlanFrame(const std::vector<uint8_t>& inner, uint32_t vni) {
+    FrameSpec outer;
+    outer.protocol = 17;
+    outer.src[3] = 101;
+    outer.dst[3] = 102;
+    outer.src_port = 49152;
+    outer.dst_port = 4789;
+    outer.payload_len = static_cast<uint32_t>(8 + inner.size());
+    std::vector<uint8_t> f = BuildFrame(outer);
+    uint8_t* vxlan = f.data() + f.size() - outer.payload_len;
+    const uint8_t header[8] = {0x08, 0, 0, 0, static_cast<uint8_t>(vni >> 16),
+                               static_cast<uint8_t>(vni >> 8), static_cast<uint8_t>(vni), 0};
+    std::memcpy(vxlan, header, 8);
+    std::memcpy(vxlan + 8, inner.data(), inner.size());
+    return f;
+}
+
+} // namespace Bench
+} // namespace WareHound
+
+#endif // BENCH_UTIL_H
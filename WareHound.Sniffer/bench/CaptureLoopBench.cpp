@@ -0,0 +1,91 @@
+// CAPTURE LOOP BENCH - BatchCaptureLoop vs the per-packet loop on a replayed savefile
+//
+// Writes a savefile of 4096 TCP flows and replays it through a whole
+// Sniffer (SnifferBuilder::UseFile) with a counting subscriber. Batch size
+// 1 runs SingleCaptureLoop, one pcap_next_ex per packet, as capture worked
+// before batching; larger sizes run BatchCaptureLoop, one pcap_dispatch per
+// batch (64 is the default). Each figure is the time from Start() until the
+// subscriber has seen every packet, best of ROUNDS runs. The "read only"
+// lines time the same two read patterns on a bare PcapCaptureSource, which
+// is all that differs between the loops.
+// usage: CaptureLoopBench [packets=1000000] [payload=64]
+
+#include "ReplayUtil.h"
+#include <algorithm>
+#include <filesystem>
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+static constexpr int ROUNDS = 3;
+
+static void Count(u_char* user, const struct pcap_pkthdr*, const u_char*) {
+    (*reinterpret_cast<uint64_t*>(user))++;
+}
+
+// Reads the whole savefile with Next (batch 1) or Dispatch; ns, or 0 on error
+static uint64_t ReadOnly(const std::string& path, int batch, uint64_t packets) {
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_t* handle = pcap_open_offline_with_tstamp_precision(path.c_str(), PCAP_TSTAMP_PRECISION_NANO, errbuf);
+    if (!handle) {
+        return 0;
+    }
+    PcapCaptureSource source(handle, true);
+    uint64_t count = 0;
+    uint64_t start = NowNs();
+    if (batch == 1) {
+        struct pcap_pkthdr* header;
+        const u_char* data;
+        while (source.Next(&header, &data) > 0) {
+            count++;
+        }
+    } else {
+        while (source.Dispatch(batch, Count, reinterpret_cast<u_char*>(&count)) > 0) {
+        }
+    }
+    uint64_t elapsed = NowNs() - start;
+    pcap_close(handle);
+    return count == packets ? elapsed : 0;
+}
+
+int main(int argc, char** argv) {
+    uint64_t packets = Arg(argc, argv, 1, 1000000);
+    uint32_t payload = static_cast<uint32_t>(Arg(argc, argv, 2, 64));
+
+    std::string path = (std::filesystem::temp_directory_path() / "warehound_capture_loop.pcap").string();
+    if (!WriteSavefile(path, FlowFrames(4096, 4, 6, 0, payload), packets)) {
+        std::printf("cannot write %s\n", path.c_str());
+        return 1;
+    }
+
+    static const int batchSizes[4] = {1, 16, 64, 256};
+    uint64_t pipeline[4] = {UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX};
+    uint64_t read[4] = {UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX};
+    // Alternate so drift in machine load hits every size alike
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < 4; i++) {
+            uint64_t elapsed = ReplayOnce(SnifferBuilder().SetBatchSize(batchSizes[i]), path, packets);
+            pipeline[i] = elapsed ? (std::min)(pipeline[i], elapsed) : pipeline[i];
+            elapsed = ReadOnly(path, batchSizes[i], packets);
+            read[i] = elapsed ? (std::min)(read[i], elapsed) : read[i];
+        }
+    }
+    std::filesystem::remove(path);
+
+    for (int i = 0; i < 8; i++) {
+        int batch = batchSizes[i % 4];
+        uint64_t best = i < 4 ? pipeline[i] : read[i - 4];
+        char name[64];
+        if (batch == 1) {
+            std::snprintf(name, sizeof(name), "%s, next_ex", i < 4 ? "pipeline" : "read only");
+        } else {
+            std::snprintf(name, sizeof(name), "%s, dispatch %d", i < 4 ? "pipeline" : "read only", batch);
+        }
+        if (best == UINT64_MAX) {
+            std::printf("%s: no complete replay\n", name);
+        } else {
+            Report(name, packets, best);
+        }
+    }
+    return 0;
+}
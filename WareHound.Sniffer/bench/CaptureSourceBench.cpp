@@ -0,0 +1,139 @@
+// CAPTURE SOURCE BENCH - AfPacketCaptureSource vs PcapCaptureSource on a veth pair
+//
+// A sender thread writes frames of 1024 flows into one end of a veth pair
+// through a raw AF_PACKET socket (sendmmsg, 64 at a time); the capture
+// source under test reads the other end with non-blocking Dispatch and
+// poll, as PacketCapturer does, and only counts what it sees. Reported:
+// frames captured per second, capture-thread CPU per frame, and the
+// source's own received/dropped counters. Needs CAP_NET_RAW and a pair:
+//   ip link add vtest0 type veth peer name vtest1
+//   ip link set vtest0 up && ip link set vtest1 up
+// usage: CaptureSourceBench [frames=1000000] [payload=64] [source=both|afpacket|pcap]
+//                           [send_if=vtest0] [capture_if=vtest1]
+
+#include "BenchUtil.h"
+#include "LinkUtil.h"
+#include "AfPacketCaptureSource.h"
+#include "CaptureSource.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <poll.h>
+#include <sys/resource.h>
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+struct Counts {
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+};
+
+static void Count(u_char* user, const struct pcap_pkthdr* header, const u_char*) {
+    Counts* counts = reinterpret_cast<Counts*>(user);
+    counts->frames++;
+    counts->bytes += header->caplen;
+}
+
+static uint64_t ThreadCpuNs() {
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return static_cast<uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000ULL +
+           static_cast<uint64_t>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ULL;
+}
+
+static void Run(const char* name, ICaptureSource& source, const std::string& send_if,
+                const std::vector<std::vector<uint8_t>>& frames, uint64_t count) {
+    int sender = OpenSender(send_if);
+    if (sender < 0) {
+        std::printf("%s: cannot send on %s: %s\n", name, send_if.c_str(), strerror(errno));
+        return;
+    }
+    source.SetNonBlocking(true);
+    CaptureSourceStats before;
+    source.GetStats(before);
+
+    Counts counts;
+    std::atomic<bool> sending{true};
+    uint64_t start = NowNs();
+    std::thread thread([&] {
+        SendFrames(sender, frames, count);
+        sending.store(false, std::memory_order_release);
+    });
+
+    // Stop once everything arrived, or the link has been idle a while after sending
+    uint64_t cpu_start = ThreadCpuNs();
+    uint64_t last_frame = NowNs();
+    struct pollfd pfd = {source.GetSelectableFd(), POLLIN, 0};
+    while (counts.frames < count) {
+        int got = source.Dispatch(256, Count, reinterpret_cast<u_char*>(&counts));
+        if (got > 0) {
+            last_frame = NowNs();
+            continue;
+        }
+        if (got < 0 || (!sending.load(std::memory_order_acquire) && NowNs() - last_frame > 500000000ULL)) {
+            break;
+        }
+        poll(&pfd, 1, 10);
+    }
+    uint64_t cpu = ThreadCpuNs() - cpu_start;
+    uint64_t elapsed = last_frame - start;
+    thread.join();
+    close(sender);
+
+    CaptureSourceStats after;
+    source.GetStats(after);
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s captured", name);
+    Report(label, counts.frames, elapsed);
+    std::printf("  %llu of %llu frames, %.1f ns CPU per frame; source received %llu, dropped %llu\n",
+                static_cast<unsigned long long>(counts.frames), static_cast<unsigned long long>(count),
+                counts.frames ? static_cast<double>(cpu) / counts.frames : 0.0,
+                static_cast<unsigned long long>(after.received - before.received),
+                static_cast<unsigned long long>(after.dropped - before.dropped));
+}
+
+int main(int argc, char** argv) {
+    uint64_t count = Arg(argc, argv, 1, 1000000);
+    uint32_t payload = static_cast<uint32_t>(Arg(argc, argv, 2, 64));
+    std::string which = argc > 3 ? argv[3] : "both";
+    std::string send_if = argc > 4 ? argv[4] : "vtest0";
+    std::string capture_if = argc > 5 ? argv[5] : "vtest1";
+
+    std::vector<std::vector<uint8_t>> frames = FlowFrames(1024, 4, 17, 0, payload);
+
+    if (which == "both" || which == "afpacket") {
+        AfPacketCaptureSource::Options options;
+        options.interfaceName = capture_if;
+        try {
+            AfPacketCaptureSource source(options);
+            Run("AF_PACKET", source, send_if, frames, count);
+        } catch (const std::exception& e) {
+            std::printf("AF_PACKET: %s\n", e.what());
+        }
+    }
+    if (which == "both" || which == "pcap") {
+        // As builderDevice opens the throughput profile, but with the
+        // AF_PACKET source's 10 ms block timeout so both batch alike
+        char errbuf[PCAP_ERRBUF_SIZE];
+        pcap_t* handle = pcap_create(capture_if.c_str(), errbuf);
+        if (handle) {
+            pcap_set_snaplen(handle, 65536);
+            pcap_set_promisc(handle, 1);
+            pcap_set_timeout(handle, 10);
+            pcap_set_buffer_size(handle, 128 * 1024 * 1024);
+            pcap_set_tstamp_precision(handle, PCAP_TSTAMP_PRECISION_NANO);
+        }
+        if (!handle || pcap_activate(handle) < 0) {
+            std::printf("pcap: cannot open %s: %s\n", capture_if.c_str(), handle ? pcap_geterr(handle) : errbuf);
+        } else {
+            PcapCaptureSource source(handle, false);
+            Run("pcap", source, send_if, frames, count);
+        }
+        if (handle) {
+            pcap_close(handle);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,184 @@
+// FILTER SWAP TEST - Sniffer::SetFilter while capture runs, on a veth pair
+//
+// A full Sniffer captures one end of a veth pair while UDP frames to ports
+// 1000 and 2000 are sent into the other. The filter is swapped to "udp dst
+// port 1000" mid-capture, then a broken expression is offered (rejected,
+// the old filter stays), then it is cleared, and finally set again after
+// Stop. Each swap is handed to the capture thread and its result awaited;
+// the time that takes is printed. Runs against AfPacketCaptureSource and a
+// libpcap handle. Needs CAP_NET_RAW and the pair (see CaptureSourceBench);
+// without them it exits with 77 and ctest reports it skipped.
+// usage: FilterSwapTest [source=both|afpacket|pcap] [send_if=vtest0] [capture_if=vtest1]
+
+#include "BenchUtil.h"
+#include "LinkUtil.h"
+#include "Sniffer.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { failures++; if (failures < 20) std::printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+static constexpr uint16_t KEPT_PORT = 1000;
+static constexpr uint16_t OTHER_PORT = 2000;
+static constexpr uint64_t BURST = 2000;  // Frames per port per phase
+
+// Counts delivered UDP/IPv4 frames by destination port
+class PortCounter : public IPacketSubscriber {
+public:
+    std::atomic<uint64_t> kept{0};
+    std::atomic<uint64_t> other{0};
+
+    void OnPacketCaptured(const tagSnapshot& packet) override {
+        const uint8_t* f = packet.raw_data;
+        if (packet.kind != SNAPSHOT_PACKET || packet.capture_len < 38 || f[12] != 0x08 || f[13] != 0x00 ||
+            f[23] != 17) {
+            return;
+        }
+        uint16_t port = static_cast<uint16_t>(f[36] << 8 | f[37]);
+        if (port == KEPT_PORT) {
+            kept.fetch_add(1, std::memory_order_relaxed);
+        } else if (port == OTHER_PORT) {
+            other.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+static bool WaitFor(const std::function<bool()>& done, int timeout_ms = 5000) {
+    uint64_t deadline = NowNs() + static_cast<uint64_t>(timeout_ms) * 1000000ULL;
+    while (!done()) {
+        if (NowNs() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+// Frames that pass the filter arrive before the settle wait ends; any that
+// should have been dropped would have arrived by then too
+static void Settle() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+}
+
+static bool TimedSetFilter(Sniffer& sniffer, const char* name, const std::string& expression) {
+    uint64_t start = NowNs();
+    bool installed = sniffer.SetFilter(expression);
+    std::printf("  %s: SetFilter(\"%s\") -> %s in %.1f us\n", name, expression.c_str(),
+                installed ? "installed" : "rejected", (NowNs() - start) / 1e3);
+    return installed;
+}
+
+static void RunSwap(const char* name, std::shared_ptr<ICaptureSource> source, int sender) {
+    std::printf("%s\n", name);
+    auto counter = std::make_shared<PortCounter>();
+    std::unique_ptr<Sniffer> sniffer = SnifferBuilder().UseCaptureSource(source).AddSubscriber(counter).Build();
+    sniffer->Start();
+
+    FrameSpec spec;
+    spec.protocol = 17;
+    spec.payload_len = 64;
+    spec.dst_port = KEPT_PORT;
+    std::vector<std::vector<uint8_t>> frames;
+    frames.push_back(BuildFrame(spec));
+    spec.dst_port = OTHER_PORT;
+    frames.push_back(BuildFrame(spec));
+
+    // No filter: both ports arrive
+    CHECK(SendFrames(sender, frames, 2 * BURST));
+    CHECK(WaitFor([&] { return counter->kept >= BURST && counter->other >= BURST; }));
+
+    // Swapped while capturing: only port 1000 from here on
+    CHECK(TimedSetFilter(*sniffer, name, "udp dst port 1000"));
+    FilterStats stats = sniffer->GetFilterStats();
+    CHECK(stats.swaps == 1 && stats.expression == "udp dst port 1000");
+    uint64_t other = counter->other;
+    CHECK(SendFrames(sender, frames, 2 * BURST));
+    CHECK(WaitFor([&] { return counter->kept >= 2 * BURST; }));
+    Settle();
+    CHECK(counter->other == other);
+
+    // Rejected: the previous filter keeps running
+    CHECK(!TimedSetFilter(*sniffer, name, "udp dst port"));
+    stats = sniffer->GetFilterStats();
+    CHECK(stats.swaps == 1 && stats.expression == "udp dst port 1000");
+    CHECK(SendFrames(sender, frames, 2 * BURST));
+    CHECK(WaitFor([&] { return counter->kept >= 3 * BURST; }));
+    Settle();
+    CHECK(counter->other == other);
+
+    // Cleared: both ports again
+    CHECK(TimedSetFilter(*sniffer, name, ""));
+    CHECK(SendFrames(sender, frames, 2 * BURST));
+    CHECK(WaitFor([&] { return counter->kept >= 4 * BURST && counter->other >= other + BURST; }));
+    stats = sniffer->GetFilterStats();
+    CHECK(stats.swaps == 2 && stats.expression.empty());
+    std::printf("  %s: delivered %llu to port 1000, %llu to port 2000; kernel received %llu, dropped %llu\n",
+                name, static_cast<unsigned long long>(counter->kept.load()),
+                static_cast<unsigned long long>(counter->other.load()),
+                static_cast<unsigned long long>(stats.kernelReceived),
+                static_cast<unsigned long long>(stats.kernelDropped));
+
+    // Stopped: applied directly and kept for the next Start
+    sniffer->Stop();
+    CHECK(TimedSetFilter(*sniffer, name, "udp"));
+    stats = sniffer->GetFilterStats();
+    CHECK(stats.swaps == 2 && stats.expression == "udp");
+}
+
+int main(int argc, char** argv) {
+    std::string which = argc > 1 ? argv[1] : "both";
+    std::string send_if = argc > 2 ? argv[2] : "vtest0";
+    std::string capture_if = argc > 3 ? argv[3] : "vtest1";
+
+    if (!LinkRunning(send_if) || !LinkRunning(capture_if)) {
+        std::printf("SKIP: %s and %s are not both up\n", send_if.c_str(), capture_if.c_str());
+        return 77;
+    }
+    int sender = OpenSender(send_if);
+    if (sender < 0) {
+        std::printf("SKIP: cannot send on %s: %s\n", send_if.c_str(), strerror(errno));
+        return 77;
+    }
+
+    if (which == "both" || which == "afpacket") {
+        AfPacketCaptureSource::Options options;
+        options.interfaceName = capture_if;
+        try {
+            RunSwap("AF_PACKET", std::make_shared<AfPacketCaptureSource>(options), sender);
+        } catch (const std::exception& e) {
+            std::printf("FAIL AF_PACKET: %s\n", e.what());
+            failures++;
+        }
+    }
+    if (which == "both" || which == "pcap") {
+        char errbuf[PCAP_ERRBUF_SIZE];
+        pcap_t* handle = pcap_create(capture_if.c_str(), errbuf);
+        if (handle) {
+            pcap_set_snaplen(handle, 65536);
+            pcap_set_promisc(handle, 1);
+            pcap_set_timeout(handle, 10);
+        }
+        if (!handle || pcap_activate(handle) < 0) {
+            std::printf("FAIL pcap: cannot open %s: %s\n", capture_if.c_str(), handle ? pcap_geterr(handle) : errbuf);
+            failures++;
+        } else {
+            RunSwap("pcap", std::make_shared<PcapCaptureSource>(handle, false), sender);
+        }
+        if (handle) {
+            pcap_close(handle);
+        }
+    }
+    close(sender);
+
+    std::printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+// FLOW TABLE BENCH - FlowTable against the std::unordered_map table it replaced
+//
+// For each population: insert every flow, look every flow up again through
+// LookupOrCreate (the per-packet path) in shuffled order, then look up keys
+// that are not there.
+// usage: FlowTableBench [flows...]   (default 100000 1000000)
+
+#include "BenchUtil.h"
+#include "FlowTable.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+// The previous FlowTable: one map behind one lock
+class UnorderedFlowTable {
+public:
+    UnorderedFlowTable(size_t table_size, size_t max_flows) : max_flows_(max_flows) {
+        flows_.reserve(table_size);
+    }
+
+    FlowEntry* LookupOrCreate(const FlowKey& key, uint64_t timestamp_ns) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = flows_.find(key);
+        if (it != flows_.end()) {
+            return &it->second;
+        }
+        if (flows_.size() >= max_flows_) {
+            return nullptr;
+        }
+        FlowEntry entry(key);
+        entry.stats.first_seen_ns = timestamp_ns;
+        entry.stats.last_seen_ns = timestamp_ns;
+        return &flows_.emplace(key, std::move(entry)).first->second;
+    }
+
+    FlowEntry* Lookup(const FlowKey& key) {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = flows_.find(key);
+        return it != flows_.end() ? &it->second : nullptr;
+    }
+
+private:
+    size_t max_flows_;
+    std::unordered_map<FlowKey, FlowEntry, FlowKeyHash> flows_;
+    std::shared_mutex mutex_;
+};
+
+static FlowKey MakeKey(uint32_t i, uint32_t salt) {
+    FlowKey key{};
+    key.src_ip = IpAddress::FromV4(0x0A000000u + i);
+    key.dst_ip = IpAddress::FromV4(0xC0A80000u + salt);
+    key.src_port = static_cast<uint16_t>(1024 + i % 60000);
+    key.dst_port = 443;
+    key.protocol = 6;
+    return key;
+}
+
+template <typename Table>
+static void Run(const char* label, Table& table, const std::vector<FlowKey>& keys,
+                const std::vector<uint32_t>& order, const std::vector<FlowKey>& misses) {
+    char name[64];
+    uint64_t sink = 0;
+
+    uint64_t start = NowNs();
+    for (size_t i = 0; i < keys.size(); i++) {
+        sink += table.LookupOrCreate(keys[i], 1000 + i) != nullptr;
+    }
+    std::snprintf(name, sizeof(name), "%s insert", label);
+    Report(name, keys.size(), NowNs() - start);
+
+    start = NowNs();
+    for (uint32_t i : order) {
+        FlowEntry* flow = table.LookupOrCreate(keys[i], 2000 + i);
+        flow->stats.packets_to_server++;
+        sink += flow->stats.packets_to_server;
+    }
+    std::snprintf(name, sizeof(name), "%s lookup hit", label);
+    Report(name, order.size(), NowNs() - start);
+
+    start = NowNs();
+    for (const FlowKey& key : misses) {
+        sink += table.Lookup(key) != nullptr;
+    }
+    std::snprintf(name, sizeof(name), "%s lookup miss", label);
+    Report(name, misses.size(), NowNs() - start);
+
+    if (sink == 0) std::printf("\n");
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> populations;
+    for (int i = 1; i < argc; i++) {
+        populations.push_back(static_cast<size_t>(Arg(argc, argv, i, 0)));
+    }
+    if (populations.empty()) {
+        populations = {100000, 1000000};
+    }
+
+    for (size_t n : populations) {
+        std::vector<FlowKey> keys, misses;
+        std::vector<uint32_t> order(n);
+        for (uint32_t i = 0; i < n; i++) {
+            keys.push_back(MakeKey(i, 1));
+            misses.push_back(MakeKey(i, 2));
+            order[i] = i;
+        }
+        Rng rng;
+        for (size_t i = n; i > 1; i--) {
+            std::swap(order[i - 1], order[rng.Next() % i]);
+        }
+
+        std::printf("%zu flows\n", n);
+        {
+            auto table = std::make_unique<FlowTable>(n, n);
+            table->SetEvictionPolicy(FlowEvictionPolicy::NONE);
+            Run("FlowTable", *table, keys, order, misses);
+        }
+        {
+            auto table = std::make_unique<UnorderedFlowTable>(n, n);
+            Run("unordered_map", *table, keys, order, misses);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+// FLOW TABLE TEST - FlowTable against a std::unordered_map reference
+//
+// Random inserts, hits, expiry sweeps and evictions; after every step the
+// table must hold exactly the reference's flows, at stable addresses.
+
+#include "BenchUtil.h"
+#include "FlowTable.h"
+#include <unordered_map>
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+static constexpr uint64_t SECOND = 1000000000ULL;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { failures++; if (failures < 20) std::printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+static FlowKey MakeKey(uint32_t i) {
+    FlowKey key{};
+    key.src_ip = IpAddress::FromV4(0x0A000000u + i % 5000);
+    key.dst_ip = IpAddress::FromV4(0xC0A80000u + i / 5000);
+    key.src_port = static_cast<uint16_t>(1000 + i % 7);
+    key.dst_port = 443;
+    key.protocol = 6;
+    return key;
+}
+
+struct Reference {
+    FlowEntry* entry;
+    uint64_t last_seen_ns;
+};
+
+static void RunRound(size_t table_size, size_t max_flows, FlowEvictionPolicy policy, uint64_t timeout_s,
+                     int steps, uint64_t seed) {
+    FlowTable table(table_size, max_flows);
+    table.SetEvictionPolicy(policy);
+    FlowTimeouts timeouts;
+    timeouts.tcp_handshake_ns = timeouts.tcp_established_ns = timeouts.tcp_closing_ns =
+        timeouts.tcp_closed_ns = timeouts.udp_ns = timeouts.other_ns = timeout_s * SECOND;
+    table.SetTimeouts(timeouts);
+
+    std::unordered_map<FlowKey, Reference, FlowKeyHash> reference;
+    size_t evicted = 0;
+    uint64_t now = SECOND;
+    table.SetRemoveCallback([&](FlowEntry& entry, FlowRemoveReason reason) {
+        auto it = reference.find(entry.key);
+        CHECK(it != reference.end() && it->second.entry == &entry);
+        if (reason == FlowRemoveReason::EXPIRED) {
+            CHECK(now - it->second.last_seen_ns > timeout_s * SECOND);
+        }
+        if (reason == FlowRemoveReason::EVICTED) evicted++;
+        reference.erase(entry.key);
+    });
+
+    Rng rng(seed);
+    for (int step = 0; step < steps; step++) {
+        now += SECOND;
+        FlowKey key = MakeKey(static_cast<uint32_t>(rng.Next() % (max_flows * 2)));
+        bool known = reference.count(key) != 0;
+        size_t before = reference.size();
+        size_t evicted_before = evicted;
+
+        bool created = false;
+        FlowEntry* flow = table.LookupOrCreate(key, now, &created);
+        if (known) {
+            CHECK(flow && !created && flow == reference[key].entry && flow->key == key);
+        } else if (before < max_flows) {
+            CHECK(flow && created && flow->key == key && flow->stats.first_seen_ns == now);
+        } else if (policy == FlowEvictionPolicy::NONE) {
+            CHECK(flow == nullptr);
+        } else {
+            CHECK(flow && created && evicted == evicted_before + 1);
+        }
+        if (flow) {
+            flow->stats.last_seen_ns = now;
+            reference[key] = Reference{flow, now};
+        }
+
+        if (rng.Next() % 1000 == 0) {
+            table.CleanupExpired(now);
+            size_t due = 0;
+            for (const auto& p : reference) {
+                if (now - p.second.last_seen_ns > timeout_s * SECOND) due++;
+            }
+            CHECK(due == 0);
+        }
+        CHECK(table.GetFlowCount() == reference.size());
+
+        if (step % 20000 == 0) {
+            for (const auto& p : reference) {
+                FlowEntry* found = table.Lookup(p.first);
+                CHECK(found == p.second.entry && found->stats.last_seen_ns == p.second.last_seen_ns);
+            }
+            CHECK(table.GetAllFlows().size() == reference.size());
+            CHECK(table.Lookup(MakeKey(static_cast<uint32_t>(max_flows * 4))) == nullptr);
+        }
+    }
+
+    CHECK(table.GetTotalEvicted() == evicted);
+    CHECK(table.GetTotalExpired() + evicted + table.GetFlowCount() == table.GetTotalInsertions());
+    table.Clear();
+    CHECK(reference.empty());
+    CHECK(table.GetFlowCount() == 0 && table.GetAllFlows().empty());
+    std::printf("max_flows %zu policy %d: %llu inserted, %llu expired, %zu evicted\n", max_flows,
+                static_cast<int>(policy), static_cast<unsigned long long>(table.GetTotalInsertions()),
+                static_cast<unsigned long long>(table.GetTotalExpired()), evicted);
+}
+
+int main() {
+    // Tiny, mid-size and growing past the initial slot arrays
+    RunRound(1024, 50, FlowEvictionPolicy::NONE, 50, 100000, 1);
+    RunRound(1024, 3000, FlowEvictionPolicy::NONE, 1500, 200000, 2);
+    RunRound(16, 100000, FlowEvictionPolicy::NONE, 100000, 300000, 3);
+    RunRound(1024, 3000, FlowEvictionPolicy::LEAST_RECENT, 100000, 200000, 4);
+    RunRound(1024, 3000, FlowEvictionPolicy::SMALLEST_FIRST, 2500, 200000, 5);
+
+    std::printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
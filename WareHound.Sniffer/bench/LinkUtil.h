@@ -0,0 +1,86 @@
+#pragma once
+#ifndef LINK_UTIL_H
+#define LINK_UTIL_H
+
+// Linux only: writes frames onto an interface through a raw AF_PACKET socket
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <linux/if_packet.h>
+#include <unistd.h>
+
+namespace WareHound {
+namespace Bench {
+
+// SENDER - Protocol 0: the socket only sends, so the kernel queues nothing back to it
+inline int OpenSender(const std::string& ifname) {
+    int fd = socket(AF_PACKET, SOCK_RAW, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_ll addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_ifindex = static_cast<int>(if_nametoindex(ifname.c_str()));
+    if (addr.sll_ifindex == 0 || bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Interface exists, is up and has carrier (both ends of a veth pair are up)
+inline bool LinkRunning(const std::string& ifname) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct ifreq request;
+    memset(&request, 0, sizeof(request));
+    strncpy(request.ifr_name, ifname.c_str(), IFNAMSIZ - 1);
+    bool running = ioctl(fd, SIOCGIFFLAGS, &request) == 0 && (request.ifr_flags & IFF_UP) &&
+                   (request.ifr_flags & IFF_RUNNING);
+    close(fd);
+    return running;
+}
+
+// Sends count frames, cycling through frames, with sendmmsg 64 at a time;
+// false if the link fails (a full qdisc is waited out)
+inline bool SendFrames(int fd, const std::vector<std::vector<uint8_t>>& frames, uint64_t count) {
+    constexpr unsigned BATCH = 64;
+    struct iovec iov[BATCH];
+    struct mmsghdr messages[BATCH];
+    for (uint64_t sent = 0; sent < count;) {
+        unsigned n = static_cast<unsigned>((std::min)(static_cast<uint64_t>(BATCH), count - sent));
+        for (unsigned k = 0; k < n; k++) {
+            const std::vector<uint8_t>& frame = frames[(sent + k) % frames.size()];
+            iov[k].iov_base = const_cast<uint8_t*>(frame.data());
+            iov[k].iov_len = frame.size();
+            memset(&messages[k], 0, sizeof(messages[k]));
+            messages[k].msg_hdr.msg_iov = &iov[k];
+            messages[k].msg_hdr.msg_iovlen = 1;
+        }
+        int done = sendmmsg(fd, messages, n, 0);
+        if (done > 0) {
+            sent += static_cast<uint64_t>(done);
+        } else if (errno == ENOBUFS || errno == EAGAIN) {
+            std::this_thread::yield();
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace Bench
+} // namespace WareHound
+
+#endif // LINK_UTIL_H
@@ -0,0 +1,68 @@
+// PACKET VIEW BENCH - Eager ParsedPacket vs lazy PacketView
+//
+// "parse" is Parse alone. "flow" also reads what FlowTracker reads for a
+// TCP segment: the flow key and its hash, flags, sequence, ack, window and
+// payload length. Frames cycle through 1024 distinct flows; each figure is
+// the best of ROUNDS runs.
+// usage: PacketViewBench [iterations=2000000]
+
+#include "BenchUtil.h"
+#include "PacketParser.h"
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+static constexpr int ROUNDS = 5;
+
+template <typename Packet>
+static void Parse(const std::vector<uint8_t>& frame, uint64_t i, Packet& packet) {
+    PacketParser::Parse(frame.data(), static_cast<uint32_t>(frame.size()), i, packet);
+}
+
+static uint64_t FlowFields(const ParsedPacket& p) {
+    uint64_t sum = FlowKeyHash()(p.ToFlowKey());
+    return sum + p.tcp_flags + p.tcp_seq + p.tcp_ack + p.tcp_window + p.payload_len;
+}
+
+static uint64_t FlowFields(const PacketView& v) {
+    uint64_t sum = FlowKeyHash()(v.ToFlowKey());
+    return sum + v.TcpFlags() + v.TcpSeq() + v.TcpAck() + v.TcpWindow() + v.PayloadLen();
+}
+
+template <typename Packet>
+static void Run(const char* label, const char* kind, const std::vector<std::vector<uint8_t>>& frames,
+                uint64_t iterations) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s %s parse", label, kind);
+    Report(name, iterations, BestOf(ROUNDS, iterations, [&](uint64_t i) {
+        Packet packet;
+        Parse(frames[i & 1023], i, packet);
+        DoNotOptimize(packet);
+    }));
+    std::snprintf(name, sizeof(name), "%s %s flow", label, kind);
+    Report(name, iterations, BestOf(ROUNDS, iterations, [&](uint64_t i) {
+        Packet packet;
+        Parse(frames[i & 1023], i, packet);
+        uint64_t sum = FlowFields(packet);
+        DoNotOptimize(sum);
+    }));
+}
+
+static void Compare(const char* label, const std::vector<std::vector<uint8_t>>& frames, uint64_t iterations) {
+    Run<ParsedPacket>(label, "eager", frames, iterations);
+    Run<PacketView>(label, "view ", frames, iterations);
+}
+
+int main(int argc, char** argv) {
+    uint64_t iterations = Arg(argc, argv, 1, 2000000);
+
+    Compare("IPv4 TCP", FlowFrames(1024, 4, 6), iterations);
+    Compare("IPv6 TCP", FlowFrames(1024, 6, 6), iterations);
+
+    std::vector<std::vector<uint8_t>> tunnelled;
+    for (const std::vector<uint8_t>& inner : FlowFrames(1024, 4, 6)) {
+        tunnelled.push_back(BuildVxlanFrame(inner, 42));
+    }
+    Compare("VXLAN TCP", tunnelled, iterations);
+    return 0;
+}
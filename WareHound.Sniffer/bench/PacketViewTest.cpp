@@ -0,0 +1,215 @@
+// PACKET VIEW TEST - PacketView fields against the eager ParsedPacket
+//
+// Builds IPv4/IPv6 TCP/UDP/ICMP frames with VLAN tags, IPv4 options, IPv6
+// extension headers, fragments and VXLAN, then corrupts, truncates or pads
+// most of them. Both parses must agree on every field the view exposes.
+// usage: PacketViewTest [frames=200000]
+
+#include "BenchUtil.h"
+#include "PacketParser.h"
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { failures++; if (failures < 20) std::printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+struct Coverage {
+    uint64_t frames = 0;
+    uint64_t valid_ip = 0;
+    uint64_t valid_transport = 0;
+    uint64_t ipv6 = 0;
+    uint64_t fragments = 0;
+    uint64_t tunnelled = 0;
+    uint64_t payload = 0;
+};
+
+// Where the IP header starts in a BuildFrame frame
+static size_t IpOffset(const FrameSpec& spec) {
+    return spec.vlan ? 18 : 14;
+}
+
+static void AddIPv4Options(std::vector<uint8_t>& f, const FrameSpec& spec, uint32_t words) {
+    size_t ip = IpOffset(spec);
+    f.insert(f.begin() + ip + 20, words * 4, 0x01);  // NOPs
+    f[ip] = static_cast<uint8_t>(0x40 | (5 + words));
+    uint16_t total = static_cast<uint16_t>(((f[ip + 2] << 8) | f[ip + 3]) + words * 4);
+    f[ip + 2] = static_cast<uint8_t>(total >> 8);
+    f[ip + 3] = static_cast<uint8_t>(total);
+}
+
+// One 8-byte hop-by-hop (0) or fragment (44) header after the fixed header
+static void AddIPv6Extension(std::vector<uint8_t>& f, const FrameSpec& spec, uint8_t type, uint16_t fragment) {
+    size_t ip = IpOffset(spec);
+    uint8_t ext[8] = {f[ip + 6], 0, static_cast<uint8_t>(fragment >> 8), static_cast<uint8_t>(fragment), 0, 0, 0, 7};
+    if (type == 0) {
+        ext[2] = ext[3] = 0;
+    }
+    f.insert(f.begin() + ip + 40, ext, ext + 8);
+    f[ip + 6] = type;
+    uint16_t payload_len = static_cast<uint16_t>(((f[ip + 4] << 8) | f[ip + 5]) + 8);
+    f[ip + 4] = static_cast<uint8_t>(payload_len >> 8);
+    f[ip + 5] = static_cast<uint8_t>(payload_len);
+}
+
+static std::vector<uint8_t> RandomFrame(Rng& rng) {
+    static const uint8_t protocols[4] = {6, 6, 17, 1};
+    FrameSpec spec = FlowSpec(static_cast<uint32_t>(rng.Next() % 100000), protocols[rng.Next() % 4],
+                              static_cast<uint32_t>(rng.Next() % 120));
+    spec.dst_port = static_cast<uint16_t>(rng.Next() % 4 == 0 ? 4789 : 80 + rng.Next() % 2000);
+    spec.seq = static_cast<uint32_t>(rng.Next());
+    spec.tcp_flags = static_cast<uint8_t>(rng.Next());
+    spec.vlan = rng.Next() % 4 == 0 ? static_cast<uint16_t>(1 + rng.Next() % 4094) : 0;
+    if (rng.Next() % 3 == 0) {
+        spec.ip_version = 6;
+        for (int i = 0; i < 16; i++) {
+            spec.src[i] = static_cast<uint8_t>(rng.Next());
+            spec.dst[i] = static_cast<uint8_t>(rng.Next());
+        }
+    }
+
+    std::vector<uint8_t> f = BuildFrame(spec);
+    size_t ip = IpOffset(spec);
+    switch (rng.Next() % 6) {
+        case 0:
+            if (spec.ip_version == 4) {
+                AddIPv4Options(f, spec, static_cast<uint32_t>(1 + rng.Next() % 10));
+            } else {
+                AddIPv6Extension(f, spec, 0, 0);
+            }
+            break;
+        case 1:
+            // First, middle or last fragment
+            if (spec.ip_version == 4) {
+                uint16_t fragment = static_cast<uint16_t>(rng.Next() % 2 ? 0x2000 : 0) |
+                                    static_cast<uint16_t>(rng.Next() % 3 ? rng.Next() % 0x1FFF : 0);
+                f[ip + 6] = static_cast<uint8_t>(fragment >> 8);
+                f[ip + 7] = static_cast<uint8_t>(fragment);
+            } else {
+                uint16_t fragment = static_cast<uint16_t>((rng.Next() % 3 ? rng.Next() % 0x1FFF : 0) << 3) |
+                                    static_cast<uint16_t>(rng.Next() % 2);
+                AddIPv6Extension(f, spec, 44, fragment);
+            }
+            break;
+        case 2:
+            f = BuildVxlanFrame(f, static_cast<uint32_t>(rng.Next() & 0xFFFFFF));
+            break;
+        default:
+            break;
+    }
+
+    // Corrupt header bytes, truncate, or add link padding
+    switch (rng.Next() % 4) {
+        case 0:
+            for (uint64_t n = 1 + rng.Next() % 4; n > 0; n--) {
+                size_t at = rng.Next() % (f.size() < 100 ? f.size() : 100);
+                f[at] = static_cast<uint8_t>(rng.Next());
+            }
+            break;
+        case 1:
+            f.resize(rng.Next() % (f.size() + 1));
+            break;
+        case 2:
+            f.resize(f.size() + 1 + rng.Next() % 40, 0);
+            break;
+        default:
+            break;
+    }
+    return f;
+}
+
+static void Compare(const std::vector<uint8_t>& frame, uint64_t n, Coverage& coverage) {
+    // An empty frame still gets a non-null pointer, as a capture would
+    static const uint8_t empty = 0;
+    const uint8_t* data = frame.empty() ? &empty : frame.data();
+    uint32_t len = static_cast<uint32_t>(frame.size());
+
+    ParsedPacket eager;
+    PacketView view;
+    bool eager_ok = PacketParser::Parse(data, len, n, eager);
+    bool view_ok = PacketParser::Parse(data, len, n, view);
+    CHECK(eager_ok == view_ok);
+    if (!eager_ok || !view_ok) {
+        return;
+    }
+    coverage.frames++;
+
+    CHECK(view.timestamp_ns == eager.timestamp_ns);
+    CHECK(view.capture_len == eager.capture_len && view.original_len == eager.original_len);
+    CHECK(std::memcmp(view.EthDst(), eager.eth_dst, 6) == 0);
+    CHECK(std::memcmp(view.EthSrc(), eager.eth_src, 6) == 0);
+    CHECK(view.EthType() == eager.eth_type);
+    CHECK(view.encap.l3_type == eager.encap.l3_type && view.encap.l3_offset == eager.encap.l3_offset);
+    CHECK(view.encap.vlan_tags == eager.encap.vlan_tags && view.encap.mpls_labels == eager.encap.mpls_labels);
+    CHECK(view.encap.tunnel == eager.encap.tunnel && view.encap.tunnel_id == eager.encap.tunnel_id);
+    CHECK(view.encap.depth_exceeded == eager.encap.depth_exceeded);
+    coverage.tunnelled += eager.encap.tunnel != TunnelType::NONE;
+
+    CHECK(view.valid_ip == eager.valid_ip);
+    CHECK(view.valid_transport == eager.valid_transport);
+    if (!eager.valid_ip || !view.valid_ip) {
+        return;
+    }
+    coverage.valid_ip++;
+    coverage.ipv6 += eager.ip_version == 6;
+    coverage.fragments += eager.ip_fragment;
+
+    CHECK(view.ip_version == eager.ip_version);
+    CHECK(view.ip_protocol == eager.ip_protocol);
+    CHECK(view.ip_fragment == eager.ip_fragment);
+    CHECK(view.IpTtl() == eager.ip_ttl);
+    CHECK(view.IpId() == eager.ip_id);
+    if (eager.ip_version == 6) {
+        CHECK(view.IpSrc() == IpAddress::FromV6(eager.ip6_src));
+        CHECK(view.IpDst() == IpAddress::FromV6(eager.ip6_dst));
+    } else {
+        CHECK(view.IpSrc() == IpAddress::FromV4(eager.ip_src));
+        CHECK(view.IpDst() == IpAddress::FromV4(eager.ip_dst));
+    }
+    CHECK(view.ToFlowKey() == eager.ToFlowKey());
+
+    if (!eager.valid_transport || !view.valid_transport) {
+        return;
+    }
+    coverage.valid_transport++;
+    if (eager.ip_protocol == IPPROTO_TCP) {
+        CHECK(view.SrcPort() == eager.tcp_src_port && view.DstPort() == eager.tcp_dst_port);
+        CHECK(view.TcpSeq() == eager.tcp_seq && view.TcpAck() == eager.tcp_ack);
+        CHECK(view.TcpHeaderLen() == eager.tcp_header_len);
+        CHECK(view.TcpFlags() == eager.tcp_flags);
+        CHECK(view.TcpWindow() == eager.tcp_window);
+    } else {
+        CHECK(view.SrcPort() == eager.udp_src_port && view.DstPort() == eager.udp_dst_port);
+        CHECK(view.UdpLen() == eager.udp_len);
+    }
+    CHECK(view.Payload() == eager.payload);
+    CHECK(view.PayloadLen() == eager.payload_len);
+    coverage.payload += eager.payload != nullptr;
+}
+
+int main(int argc, char** argv) {
+    uint64_t frames = Arg(argc, argv, 1, 200000);
+
+    Coverage coverage;
+    Rng rng(18);
+    for (uint64_t n = 0; n < frames; n++) {
+        std::vector<uint8_t> frame = RandomFrame(rng);
+        frame.shrink_to_fit();  // So a sanitizer build catches reads past the capture
+        Compare(frame, n, coverage);
+    }
+
+    std::printf("%llu frames: %llu IP (%llu IPv6, %llu fragments), %llu TCP/UDP, %llu with payload, "
+                "%llu tunnelled\n",
+                static_cast<unsigned long long>(coverage.frames), static_cast<unsigned long long>(coverage.valid_ip),
+                static_cast<unsigned long long>(coverage.ipv6), static_cast<unsigned long long>(coverage.fragments),
+                static_cast<unsigned long long>(coverage.valid_transport),
+                static_cast<unsigned long long>(coverage.payload),
+                static_cast<unsigned long long>(coverage.tunnelled));
+    // A generator that stopped reaching a layer would pass vacuously
+    CHECK(coverage.ipv6 > 0 && coverage.fragments > 0 && coverage.tunnelled > 0 && coverage.payload > 0);
+
+    std::printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
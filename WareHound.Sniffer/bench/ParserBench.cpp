@@ -0,0 +1,51 @@
+// PARSER BENCH - PacketParser::Parse into ParsedPacket, per frame kind
+//
+// "parse" is Parse alone; "parse+key" adds ToFlowKey and FlowKeyHash, as
+// the flow path does. The parsed packet is kept whole in both, so the
+// difference is the key's cost. Frames cycle through 1024 distinct flows so the
+// branch predictor sees varied addresses and ports. Each figure is the
+// best of ROUNDS runs.
+// usage: ParserBench [iterations=2000000]
+
+#include "BenchUtil.h"
+#include "PacketParser.h"
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+static constexpr int ROUNDS = 5;
+
+template <typename Fn>
+static void Best(const char* label, const char* what, uint64_t iterations, Fn&& body) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s %s", label, what);
+    Report(name, iterations, BestOf(ROUNDS, iterations, body));
+}
+
+static void Run(const char* label, const std::vector<std::vector<uint8_t>>& frames, uint64_t iterations) {
+    Best(label, "parse", iterations, [&](uint64_t i) {
+        const std::vector<uint8_t>& frame = frames[i & 1023];
+        ParsedPacket result;
+        PacketParser::Parse(frame.data(), static_cast<uint32_t>(frame.size()), i, result);
+        DoNotOptimize(result);
+    });
+    Best(label, "parse+key", iterations, [&](uint64_t i) {
+        const std::vector<uint8_t>& frame = frames[i & 1023];
+        ParsedPacket result;
+        PacketParser::Parse(frame.data(), static_cast<uint32_t>(frame.size()), i, result);
+        DoNotOptimize(result);
+        size_t hash = FlowKeyHash()(result.ToFlowKey());
+        DoNotOptimize(hash);
+    });
+}
+
+int main(int argc, char** argv) {
+    uint64_t iterations = Arg(argc, argv, 1, 2000000);
+
+    Run("IPv4 TCP", FlowFrames(1024, 4, 6), iterations);
+    Run("IPv4 UDP", FlowFrames(1024, 4, 17), iterations);
+    Run("IPv4 TCP, VLAN", FlowFrames(1024, 4, 6, 100), iterations);
+    Run("IPv6 TCP", FlowFrames(1024, 6, 6), iterations);
+    Run("IPv6 UDP", FlowFrames(1024, 6, 17), iterations);
+    return 0;
+}
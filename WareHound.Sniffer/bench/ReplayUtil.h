@@ -0,0 +1,88 @@
+#pragma once
+#ifndef REPLAY_UTIL_H
+#define REPLAY_UTIL_H
+
+// Savefile replays through the whole Sniffer pipeline (SnifferBuilder::UseFile)
+
+#include "BenchUtil.h"
+#include "Sniffer.h"
+#include <atomic>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace WareHound {
+namespace Bench {
+
+// SAVEFILE - Microsecond pcap, Ethernet link type; count frames cycling through frames
+inline bool WriteSavefile(const std::string& path, const std::vector<std::vector<uint8_t>>& frames, uint64_t count) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const uint32_t header[6] = {0xA1B2C3D4u, 2 | (4u << 16), 0, 0, 65535, 1};
+    bool ok = std::fwrite(header, sizeof(header), 1, file) == 1;
+    for (uint64_t i = 0; ok && i < count; i++) {
+        const std::vector<uint8_t>& frame = frames[i % frames.size()];
+        const uint32_t record[4] = {static_cast<uint32_t>(1700000000 + i / 1000000), static_cast<uint32_t>(i % 1000000),
+                                    static_cast<uint32_t>(frame.size()), static_cast<uint32_t>(frame.size())};
+        ok = std::fwrite(record, sizeof(record), 1, file) == 1 &&
+             std::fwrite(frame.data(), frame.size(), 1, file) == 1;
+    }
+    return std::fclose(file) == 0 && ok;
+}
+
+// Counts packets reaching the dispatcher's subscribers
+class CountingSubscriber : public IPacketSubscriber {
+public:
+    std::atomic<uint64_t> packets{0};
+
+    void OnPacketCaptured(const tagSnapshot& packet) override {
+        if (packet.kind == SNAPSHOT_PACKET) {
+            packets.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void OnPacketBatch(std::span<const tagSnapshot* const> batch) override {
+        uint64_t count = 0;
+        for (const tagSnapshot* packet : batch) {
+            count += packet->kind == SNAPSHOT_PACKET;
+        }
+        packets.fetch_add(count, std::memory_order_relaxed);
+    }
+};
+
+// Replays path through a Sniffer configured by builder; ns from Start()
+// until count packets were delivered, or 0 if delivery stalled first
+inline uint64_t ReplayOnce(SnifferBuilder builder, const std::string& path, uint64_t count) {
+    auto counter = std::make_shared<CountingSubscriber>();
+    std::unique_ptr<Sniffer> sniffer = builder.UseFile(path).AddSubscriber(counter).Build();
+    uint64_t start = NowNs();
+    sniffer->Start();
+    uint64_t seen = 0;
+    uint64_t previous = 0;
+    uint64_t last_progress = start;
+    while ((seen = counter->packets.load(std::memory_order_relaxed)) < count) {
+        uint64_t now = NowNs();
+        if (now - last_progress > 5000000000ULL) {
+            std::printf("replay stalled after %llu of %llu packets\n", static_cast<unsigned long long>(seen),
+                        static_cast<unsigned long long>(count));
+            return 0;
+        }
+        if (seen != previous) {
+            previous = seen;
+            last_progress = now;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    uint64_t elapsed = NowNs() - start;
+    sniffer->Stop();
+    return elapsed;
+}
+
+} // namespace Bench
+} // namespace WareHound
+
+#endif // REPLAY_UTIL_H
@@ -0,0 +1,126 @@
+// SHARD CONTENTION BENCH - One worker feeding a stats shard while readers poll it
+//
+// locked:   the worker holds the shard mutex exclusively per packet and
+//           readers take it shared, as ProcessPacketForStats used to
+// lockfree: the worker takes no lock; readers load the atomic counters
+//
+// Readers run the same calls as Sniffer_GetCaptureStatistics, pausing
+// poll_us between reads (0 spins; only meaningful with a core per thread).
+// usage: ShardContentionBench [readers=3] [packets=2000000] [flows=4096] [poll_us=50]
+
+#include "BenchUtil.h"
+#include "FlowTracker.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_set>
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+struct Snapshot {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t flows = 0;
+    uint64_t fragments = 0;
+    uint64_t removed = 0;
+    double duration = 0;
+    size_t protocols = 0;
+};
+
+static Snapshot ReadShard(const FlowTracker& tracker) {
+    Snapshot s;
+    const FragmentReassembler::Stats& fragments = tracker.GetFragmentStats();
+    s.fragments = fragments.reassembled + fragments.timed_out + fragments.evicted + fragments.dropped;
+    const FlowTable& flows = tracker.GetFlowTable();
+    s.removed = flows.GetTotalExpired() + flows.GetTotalEvicted() + flows.GetTotalRejected();
+    s.packets = tracker.GetPacketsProcessed();
+    s.bytes = tracker.GetBytesProcessed();
+    s.flows = tracker.GetFlowCount();
+    s.duration = tracker.GetCaptureDurationSeconds();
+    std::unordered_set<int> protocols;
+    tracker.CollectProtocols(protocols);
+    s.protocols = protocols.size();
+    return s;
+}
+
+static void Run(bool locked, size_t readers, uint64_t poll_us, uint64_t packets,
+                const std::vector<PacketView>& views) {
+    FlowTracker::Config config;
+    config.table_size = 65536;
+    config.max_flows = 100000;
+    FlowTracker tracker(config);
+    std::shared_mutex mutex;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0};
+
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < readers; r++) {
+        threads.emplace_back([&] {
+            uint64_t n = 0;
+            uint64_t sink = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                Snapshot s;
+                if (locked) {
+                    std::shared_lock<std::shared_mutex> lock(mutex);
+                    s = ReadShard(tracker);
+                } else {
+                    s = ReadShard(tracker);
+                }
+                sink += s.packets + s.flows;
+                n++;
+                if (poll_us) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(poll_us));
+                }
+            }
+            reads.fetch_add(n + (sink == 1), std::memory_order_relaxed);
+        });
+    }
+
+    uint64_t start = NowNs();
+    for (uint64_t i = 0; i < packets; i++) {
+        PacketView view = views[i % views.size()];
+        view.timestamp_ns = 1700000000ULL * 1000000000ULL + i * 1000;
+        if (locked) {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            tracker.ProcessPacket(view);
+        } else {
+            tracker.ProcessPacket(view);
+        }
+    }
+    uint64_t elapsed = NowNs() - start;
+    done.store(true);
+    for (auto& t : threads) t.join();
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s worker, %zu readers", locked ? "locked" : "lockfree", readers);
+    Report(name, packets, elapsed);
+    std::printf("%-40s %12llu reads %10.3f Kreads/s\n", "", static_cast<unsigned long long>(reads.load()),
+                reads.load() / (elapsed / 1e9) / 1e3);
+}
+
+int main(int argc, char** argv) {
+    size_t readers = static_cast<size_t>(Arg(argc, argv, 1, 3));
+    uint64_t packets = Arg(argc, argv, 2, 2000000);
+    uint32_t flows = static_cast<uint32_t>(Arg(argc, argv, 3, 4096));
+    uint64_t poll_us = Arg(argc, argv, 4, 50);
+
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<PacketView> views(flows);
+    for (uint32_t i = 0; i < flows; i++) {
+        frames.push_back(BuildFrame(FlowSpec(i)));
+    }
+    for (uint32_t i = 0; i < flows; i++) {
+        PacketParser::Parse(frames[i].data(), static_cast<uint32_t>(frames[i].size()), 0, views[i]);
+        views[i].original_len = views[i].capture_len;
+    }
+
+    std::printf("%u CPUs, %llu us poll\n", std::thread::hardware_concurrency(),
+                static_cast<unsigned long long>(poll_us));
+    for (size_t r : {static_cast<size_t>(0), readers}) {
+        Run(true, r, poll_us, packets, views);
+        Run(false, r, poll_us, packets, views);
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+// SPSC RING BENCH - Capture-to-dispatch hand-off, before and after the slot ring
+//
+// "queue" is PacketBuffer as it was: a bounded std::queue of whole 64 KB
+// snapshots behind one mutex and two condition variables, copied in by the
+// capturer and out by the dispatcher. "ring" is the current scheme: the
+// capturer claims a tagSnapshot slot and arena bytes, fills them in place
+// and publishes; the dispatcher borrows slots in batches and releases them.
+// One producer and one consumer thread; both sides do the same per-packet
+// work (fill the header, copy the frame; read the frame).
+// usage: SpscRingBench [packets=200000]
+
+#include "BenchUtil.h"
+#include "PacketArena.h"
+#include "SpscRing.h"
+#include "struct.h"
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+// OLD PACKET BUFFER - Defaults as they were (100 snapshots)
+#pragma pack(push, 2)
+struct OldSnapshot {
+    int id;
+    int source_port;
+    int dest_port;
+    char proto[22];
+    char source_ip[22];
+    char dest_ip[22];
+    char source_mac[22];
+    char dest_mac[22];
+    char host_name[22];
+    uint32_t capture_len;
+    uint32_t original_len;
+    uint64_t timestamp_sec;
+    uint32_t timestamp_usec;
+    uint8_t raw_data[65536];
+};
+#pragma pack(pop)
+
+class LockedPacketBuffer {
+public:
+    explicit LockedPacketBuffer(size_t maxSize = 100) : maxSize(maxSize) {}
+
+    void Push(const OldSnapshot& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return queue.size() < maxSize; });
+        queue.push(item);
+        lock.unlock();
+        notEmpty.notify_one();
+    }
+
+    void Pop(OldSnapshot& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return !queue.empty(); });
+        item = queue.front();
+        queue.pop();
+        lock.unlock();
+        notFull.notify_one();
+    }
+
+private:
+    std::queue<OldSnapshot> queue;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    size_t maxSize;
+};
+
+template <typename Snapshot>
+static void FillHeader(Snapshot& snap, uint64_t i, uint32_t len) {
+    snap.id = static_cast<int>(i);
+    snap.source_port = 40000;
+    snap.dest_port = 443;
+    snap.capture_len = len;
+    snap.original_len = len;
+    snap.timestamp_sec = i / 1000000;
+    snap.timestamp_usec = static_cast<uint32_t>(i % 1000000);
+}
+
+static uint64_t RunQueue(const std::vector<uint8_t>& frame, uint64_t packets) {
+    LockedPacketBuffer buffer;
+    uint64_t checksum = 0;
+    uint64_t start = NowNs();
+    std::thread consumer([&] {
+        std::unique_ptr<OldSnapshot> item(new OldSnapshot);
+        for (uint64_t i = 0; i < packets; i++) {
+            buffer.Pop(*item);
+            checksum += item->raw_data[0] + item->raw_data[item->capture_len - 1];
+        }
+    });
+    std::unique_ptr<OldSnapshot> snap(new OldSnapshot);
+    for (uint64_t i = 0; i < packets; i++) {
+        FillHeader(*snap, i, static_cast<uint32_t>(frame.size()));
+        std::memcpy(snap->raw_data, frame.data(), frame.size());
+        buffer.Push(*snap);
+    }
+    consumer.join();
+    uint64_t elapsed = NowNs() - start;
+    DoNotOptimize(checksum);
+    return elapsed;
+}
+
+static uint64_t RunRing(const std::vector<uint8_t>& frame, uint64_t packets) {
+    // PacketBuffer defaults
+    SpscRing<tagSnapshot> ring(4096);
+    PacketArena arena;
+    uint64_t checksum = 0;
+    uint64_t start = NowNs();
+    std::thread consumer([&] {
+        const tagSnapshot* batch[64];
+        for (uint64_t done = 0; done < packets;) {
+            size_t count = ring.TryPeekBatch(batch, 64);
+            if (count == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t k = 0; k < count; k++) {
+                checksum += batch[k]->raw_data[0] + batch[k]->raw_data[batch[k]->capture_len - 1];
+            }
+            ring.Release(count);
+            done += count;
+        }
+    });
+    uint32_t len = static_cast<uint32_t>(frame.size());
+    for (uint64_t i = 0; i < packets; i++) {
+        for (;;) {
+            tagSnapshot* slot = ring.TryClaim();
+            const tagSnapshot* oldest = ring.OldestInFlight();
+            uint32_t offset = 0;
+            if (slot && arena.Allocate(len, oldest ? &oldest->raw_offset : nullptr, &offset)) {
+                FillHeader(*slot, i, len);
+                slot->raw_offset = offset;
+                slot->raw_data = arena.At(offset);
+                std::memcpy(arena.At(offset), frame.data(), len);
+                ring.Publish();
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    uint64_t elapsed = NowNs() - start;
+    DoNotOptimize(checksum);
+    return elapsed;
+}
+
+int main(int argc, char** argv) {
+    uint64_t packets = Arg(argc, argv, 1, 200000);
+
+    static const uint32_t payloads[3] = {10, 458, 1446};  // 64, 512 and 1500 byte TCP frames
+    for (uint32_t payload : payloads) {
+        std::vector<uint8_t> frame = BuildFrame(FlowSpec(1, 6, payload));
+        char name[64];
+        std::snprintf(name, sizeof(name), "queue %zu B", frame.size());
+        Report(name, packets, RunQueue(frame, packets));
+        std::snprintf(name, sizeof(name), "ring  %zu B", frame.size());
+        Report(name, packets, RunRing(frame, packets));
+    }
+    return 0;
+}
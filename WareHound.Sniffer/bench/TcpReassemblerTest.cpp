@@ -0,0 +1,154 @@
+// TCP REASSEMBLER TEST - Segment pool exhaustion
+//
+// A flow waiting on a hole holds pool segments. When another flow then
+// runs the pool dry, the older flow must be flushed (with a gap) so the
+// newer one keeps its out-of-order data and delivers it in order once its
+// own hole fills. Without an evict callback, or if it refuses, the newer
+// flow gives up on its hole instead.
+
+#include "BenchUtil.h"
+#include "FlowTracker.h"
+#include <map>
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { failures++; if (failures < 20) std::printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+// Stream byte at sequence number seq, so delivered data can be checked
+static uint8_t ByteAt(uint32_t seq) {
+    return static_cast<uint8_t>(seq * 7 + (seq >> 8));
+}
+
+static std::vector<uint8_t> Segment(uint16_t src_port, uint8_t flags, uint32_t seq, uint32_t len) {
+    FrameSpec spec;
+    spec.src_port = src_port;
+    spec.tcp_flags = flags;
+    spec.seq = seq;
+    spec.payload_len = len;
+    std::vector<uint8_t> frame = BuildFrame(spec);
+    uint8_t* payload = frame.data() + frame.size() - len;
+    for (uint32_t i = 0; i < len; i++) {
+        payload[i] = ByteAt(seq + i);
+    }
+    return frame;
+}
+
+// Delivered bytes per client port
+struct Received {
+    std::map<uint16_t, std::vector<uint8_t>> data;
+};
+
+static void Send(FlowTracker& tracker, const std::vector<uint8_t>& frame, uint64_t& now) {
+    now += 1000000;
+    tracker.ProcessPacket(frame.data(), static_cast<uint32_t>(frame.size()), now);
+}
+
+static bool InOrder(const std::vector<uint8_t>& data, uint32_t first_seq) {
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] != ByteAt(first_seq + static_cast<uint32_t>(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void PoolExhaustion() {
+    FlowTracker::Config config;
+    config.collect_payload = true;
+    config.streams.max_bytes = 4 * TcpReassembler::SEGMENT_BYTES;
+    FlowTracker tracker(config);
+    Received received;
+    tracker.SetStreamCallback([&](const FlowEntry& flow, bool to_server, const uint8_t* data, uint32_t len) {
+        CHECK(to_server);
+        uint16_t port = flow.key.src_port == 80 ? flow.key.dst_port : flow.key.src_port;
+        received.data[port].insert(received.data[port].end(), data, data + len);
+    });
+
+    uint64_t now = 1000000000ULL;
+    // Flow A: SYN, then three segments past a 1000-byte hole (three pool segments)
+    Send(tracker, Segment(1000, 0x02, 100, 0), now);
+    for (uint32_t seq = 1101; seq < 4101; seq += 1000) {
+        Send(tracker, Segment(1000, 0x18, seq, 1000), now);
+    }
+    CHECK(tracker.GetStreamStats().out_of_order == 3);
+    CHECK(received.data[1000].empty());
+
+    // Flow B: two segments past its own hole; the second needs A's segments
+    Send(tracker, Segment(2000, 0x02, 500, 0), now);
+    Send(tracker, Segment(2000, 0x18, 1501, 1000), now);
+    Send(tracker, Segment(2000, 0x18, 2501, 1000), now);
+    CHECK(tracker.GetStreamStats().evictions == 1);
+    CHECK(tracker.GetStreamStats().gaps == 1);
+    CHECK(received.data[1000].size() == 3000 && InOrder(received.data[1000], 1101));
+    CHECK(received.data[2000].empty());
+
+    // B's hole fills: all of B arrives in order, nothing skipped
+    Send(tracker, Segment(2000, 0x18, 501, 1000), now);
+    CHECK(received.data[2000].size() == 3000 && InOrder(received.data[2000], 501));
+    CHECK(tracker.GetStreamStats().gaps == 1);
+    CHECK(tracker.GetStreamStats().evictions == 1);
+    CHECK(tracker.GetStreamStats().overlap_bytes == 0);
+
+    // Both streams drained: the whole pool is free again
+    Send(tracker, Segment(1000, 0x18, 5101, 1000), now);
+    Send(tracker, Segment(2000, 0x18, 4501, 1000), now);
+    Send(tracker, Segment(2000, 0x18, 5501, 1000), now);
+    CHECK(tracker.GetStreamStats().evictions == 1);
+    tracker.Clear();
+}
+
+static void NoVictim() {
+    TcpReassembler::Config config;
+    config.max_bytes = 2 * TcpReassembler::SEGMENT_BYTES;
+    TcpReassembler streams(config);
+    TcpStream a, b;
+    uint8_t data[1000];
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = static_cast<uint8_t>(i);
+    }
+    size_t delivered_a = 0, delivered_b = 0;
+    auto deliver_a = [&](const uint8_t*, uint32_t len) { delivered_a += len; };
+    auto deliver_b = [&](const uint8_t*, uint32_t len) { delivered_b += len; };
+
+    // Refused: b gives up on its hole and a keeps its segment
+    int asked = 0;
+    streams.SetEvictCallback([&](TcpStream& stream) {
+        CHECK(&stream == &a);
+        asked++;
+        return false;
+    });
+    streams.Add(a, 0, 0x02, nullptr, 0, deliver_a);
+    streams.Add(a, 2001, 0x18, data, 1000, deliver_a);
+    streams.Add(b, 0, 0x02, nullptr, 0, deliver_b);
+    streams.Add(b, 2001, 0x18, data, 1000, deliver_b);
+    streams.Add(b, 3001, 0x18, data, 1000, deliver_b);
+    CHECK(asked == 1);
+    CHECK(delivered_a == 0 && a.HasPending());
+    CHECK(delivered_b == 2000 && !b.HasPending());
+    CHECK(streams.GetStats().evictions == 1 && streams.GetStats().gaps == 1);
+
+    // Accepted: the callback flushes a, and b's segment is buffered
+    streams.SetEvictCallback([&](TcpStream& stream) {
+        streams.Flush(stream, deliver_a);
+        return true;
+    });
+    streams.Add(b, 5001, 0x18, data, 1000, deliver_b);
+    streams.Add(b, 6001, 0x18, data, 1000, deliver_b);
+    CHECK(delivered_a == 1000 && !a.HasPending());
+    CHECK(b.HasPending() && delivered_b == 2000);
+    CHECK(streams.GetStats().evictions == 2 && streams.GetStats().gaps == 2);
+    streams.Release(b);
+    CHECK(streams.GetBufferedSegments() == 0);
+}
+
+int main() {
+    PoolExhaustion();
+    NoVictim();
+
+    std::printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
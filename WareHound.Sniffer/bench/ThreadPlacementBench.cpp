@@ -0,0 +1,101 @@
+// THREAD PLACEMENT BENCH - Capture-to-dispatch hand-off, unpinned vs pinned
+//
+// The same SpscRing<tagSnapshot> + PacketArena hand-off as SpscRingBench,
+// run twice: once with the scheduler placing both threads and the buffers
+// on the default heap, once with each thread pinned (PinCurrentThread) and
+// the buffers on the consumer's node (NodeArray), as SetThreading does.
+// Each figure is the best of ROUNDS runs.
+// usage: ThreadPlacementBench [packets=2000000] [producer_core=0] [consumer_core=1]
+
+#include "BenchUtil.h"
+#include "PacketArena.h"
+#include "SpscRing.h"
+#include "ThreadPlacement.h"
+#include "struct.h"
+#include <algorithm>
+#include <thread>
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+static constexpr int ROUNDS = 5;
+
+static uint64_t Run(const std::vector<uint8_t>& frame, uint64_t packets, int producer_core, int consumer_core,
+                    bool* pinned) {
+    int node = NumaNodeOfCore(consumer_core);
+    SpscRing<tagSnapshot> ring(4096, node);
+    PacketArena arena(PacketArena::DEFAULT_CAPACITY, node);
+    uint64_t checksum = 0;
+    bool consumer_pinned = false;
+    uint64_t start = NowNs();
+    std::thread consumer([&] {
+        consumer_pinned = PinCurrentThread(consumer_core);
+        const tagSnapshot* batch[64];
+        for (uint64_t done = 0; done < packets;) {
+            size_t count = ring.TryPeekBatch(batch, 64);
+            if (count == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t k = 0; k < count; k++) {
+                checksum += batch[k]->raw_data[0] + batch[k]->raw_data[batch[k]->capture_len - 1];
+            }
+            ring.Release(count);
+            done += count;
+        }
+    });
+    std::thread producer([&] {
+        bool producer_pinned = PinCurrentThread(producer_core);
+        uint32_t len = static_cast<uint32_t>(frame.size());
+        for (uint64_t i = 0; i < packets; i++) {
+            for (;;) {
+                tagSnapshot* slot = ring.TryClaim();
+                const tagSnapshot* oldest = ring.OldestInFlight();
+                uint32_t offset = 0;
+                if (slot && arena.Allocate(len, oldest ? &oldest->raw_offset : nullptr, &offset)) {
+                    slot->id = static_cast<int>(i);
+                    slot->capture_len = len;
+                    slot->raw_offset = offset;
+                    slot->raw_data = arena.At(offset);
+                    std::memcpy(arena.At(offset), frame.data(), len);
+                    ring.Publish();
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        }
+        *pinned = producer_pinned;
+    });
+    producer.join();
+    consumer.join();
+    uint64_t elapsed = NowNs() - start;
+    *pinned = *pinned && consumer_pinned;
+    DoNotOptimize(checksum);
+    return elapsed;
+}
+
+int main(int argc, char** argv) {
+    uint64_t packets = Arg(argc, argv, 1, 2000000);
+    int producer_core = static_cast<int>(Arg(argc, argv, 2, 0));
+    int consumer_core = static_cast<int>(Arg(argc, argv, 3, 1));
+    // A single core runs both threads on it, so only the pinning cost shows
+    producer_core = (std::min)(producer_core, CoreCount() - 1);
+    consumer_core = (std::min)(consumer_core, CoreCount() - 1);
+    std::printf("%d cores; producer on core %d (node %d), consumer on core %d (node %d)\n", CoreCount(),
+                producer_core, NumaNodeOfCore(producer_core), consumer_core, NumaNodeOfCore(consumer_core));
+
+    std::vector<uint8_t> frame = BuildFrame(FlowSpec(1, 6, 458));  // 512 bytes
+    uint64_t unpinned = UINT64_MAX;
+    uint64_t pinned = UINT64_MAX;
+    bool pin_ok = true;
+    // Alternate so drift in machine load hits both alike
+    for (int round = 0; round < ROUNDS; round++) {
+        bool ok = false;
+        unpinned = (std::min)(unpinned, Run(frame, packets, ANY_CORE, ANY_CORE, &ok));  // ok: always false
+        pinned = (std::min)(pinned, Run(frame, packets, producer_core, consumer_core, &ok));
+        pin_ok = pin_ok && ok;
+    }
+    Report("unpinned", packets, unpinned);
+    Report(pin_ok ? "pinned" : "pinned (pinning failed)", packets, pinned);
+    return 0;
+}
@@ -0,0 +1,60 @@
+// WORKER SCALING BENCH - Offline replay throughput against worker count
+//
+// Replays a savefile of 4096 TCP flows through a whole Sniffer
+// (SnifferBuilder::UseFile) with 0 (inline processing on the capture
+// thread), 1, 2 and 4 flow-sharded workers, and reports packets per second
+// and the speedup over one worker. Each figure is the time from Start()
+// until a counting subscriber has seen every packet, best of ROUNDS runs.
+// Scaling needs at least workers + 2 cores (capture and dispatch threads).
+// usage: WorkerScalingBench [packets=1000000] [payload=64]
+
+#include "ReplayUtil.h"
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+
+using namespace WareHound;
+using namespace WareHound::Bench;
+
+static constexpr int ROUNDS = 3;
+
+int main(int argc, char** argv) {
+    uint64_t packets = Arg(argc, argv, 1, 1000000);
+    uint32_t payload = static_cast<uint32_t>(Arg(argc, argv, 2, 64));
+
+    std::string path = (std::filesystem::temp_directory_path() / "warehound_worker_scaling.pcap").string();
+    if (!WriteSavefile(path, FlowFrames(4096, 4, 6, 0, payload), packets)) {
+        std::printf("cannot write %s\n", path.c_str());
+        return 1;
+    }
+
+    static const int workerCounts[4] = {0, 1, 2, 4};
+    uint64_t best[4] = {UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX};
+    // Alternate so drift in machine load hits every count alike
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < 4; i++) {
+            uint64_t elapsed = ReplayOnce(SnifferBuilder().SetWorkerCount(workerCounts[i]), path, packets);
+            best[i] = elapsed ? (std::min)(best[i], elapsed) : best[i];
+        }
+    }
+    std::filesystem::remove(path);
+
+    std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+    for (int i = 0; i < 4; i++) {
+        char name[64];
+        if (workerCounts[i] == 0) {
+            std::snprintf(name, sizeof(name), "inline");
+        } else {
+            std::snprintf(name, sizeof(name), "%d worker%s", workerCounts[i], workerCounts[i] > 1 ? "s" : "");
+        }
+        if (best[i] == UINT64_MAX) {
+            std::printf("%s: no complete replay\n", name);
+            continue;
+        }
+        Report(name, packets, best[i]);
+        if (workerCounts[i] > 1 && best[1] != UINT64_MAX) {
+            std::printf("  %.2fx one worker\n", static_cast<double>(best[1]) / best[i]);
+        }
+    }
+    return 0;
+}
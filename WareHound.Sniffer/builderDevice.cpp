@@ -1,8 +1,43 @@
 #include "builderDevice.h"
 #include <iostream>
 
+// Interactive use: every packet handed up at once, small buffer
+CaptureProfile CaptureProfile::Latency() {
+    CaptureProfile p;
+    p.name = "latency";
+    p.bufferBytes = 4 * 1024 * 1024;
+    p.immediate = true;
+    p.timeoutMs = 1;
+    return p;
+}
+
+// Default: absorbs bursts, delivery within 100 ms on quiet links
+CaptureProfile CaptureProfile::Balanced() {
+    CaptureProfile p;
+    p.name = "balanced";
+    p.bufferBytes = 16 * 1024 * 1024;
+    p.timeoutMs = 100;
+    return p;
+}
+
+// Sustained line rate: large buffer, reads in big batches
+CaptureProfile CaptureProfile::Throughput() {
+    CaptureProfile p;
+    p.name = "throughput";
+    p.bufferBytes = 128 * 1024 * 1024;
+    p.timeoutMs = 500;
+    return p;
+}
+
+CaptureProfile CaptureProfile::FromName(const std::string& name) {
+    if (name == "latency") return Latency();
+    if (name == "balanced") return Balanced();
+    if (name == "throughput") return Throughput();
+    throw std::invalid_argument("Unknown capture profile: " + name);
+}
+
 builderDevice::Builder::Builder(int devIndex)
-    : inum(devIndex), deviceCount(0), alldevs(nullptr),
+    : inum(devIndex), deviceCount(0), snaplen(65536), profile(CaptureProfile::Balanced()), alldevs(nullptr),
     selectedDev(nullptr), handle(nullptr) {
 }
 
@@ -62,16 +97,94 @@ builderDevice::Builder& builderDevice::Builder::OpenSelectedDevice() {
         throw std::logic_error("No valid device selected. Call SelectDevice() first.");
     }
 
+    handle = CreateAndActivate(selectedDev->name);
+    if (handle) {
+        return *this;
+    }
+
+    // Remote sources and old drivers only go through pcap_open, which
+    // cannot size the kernel buffer
+    int flags = PCAP_OPENFLAG_PROMISCUOUS;
+    if (profile.immediate) {
+        flags |= PCAP_OPENFLAG_MAX_RESPONSIVENESS;
+    }
     handle = pcap_open(selectedDev->name,
-        65536,                      // snaplen
-        PCAP_OPENFLAG_PROMISCUOUS,  // flags
-        1000,                       // read timeout
+        snaplen,                    // snaplen
+        flags,                      // flags
+        profile.timeoutMs,          // read timeout
         NULL,                       // auth
         errbuf);
     
     if (!handle) {
         throw std::runtime_error("Failed to open device: " + std::string(errbuf));
     }   
+    settings = CaptureSettings();
+    settings.profile = profile.name;
+    settings.snaplen = pcap_snapshot(handle);
+    settings.immediate = profile.immediate;
+    settings.timeoutMs = profile.timeoutMs;
+    return *this;
+}
+
+// Local interface via pcap_create with the profile's buffer, timeout and
+// immediate mode, asking for nanosecond timestamps. Falls back to
+// microseconds where the driver cannot, and to the driver's buffer size if
+// it cannot allocate the profile's; nullptr if it cannot open at all.
+pcap_t* builderDevice::Builder::CreateAndActivate(const char* sourceName) {
+    std::string name = sourceName;
+    const std::string prefix = PCAP_SRC_IF_STRING;
+    if (name.compare(0, prefix.size(), prefix) == 0) {
+        name.erase(0, prefix.size());
+    } else if (name.find("://") != std::string::npos) {
+        return nullptr;
+    }
+
+    for (int precision : { PCAP_TSTAMP_PRECISION_NANO, PCAP_TSTAMP_PRECISION_MICRO }) {
+        for (int bufferBytes : { profile.bufferBytes, 0 }) {
+            pcap_t* created = pcap_create(name.c_str(), errbuf);
+            if (!created) {
+                return nullptr;
+            }
+            pcap_set_snaplen(created, snaplen);
+            pcap_set_promisc(created, 1);
+            pcap_set_timeout(created, profile.timeoutMs);
+            bool bufferSet = bufferBytes > 0 && pcap_set_buffer_size(created, bufferBytes) == 0;
+            bool immediateSet = profile.immediate && pcap_set_immediate_mode(created, 1) == 0;
+            if (pcap_set_tstamp_precision(created, precision) != 0) {
+                pcap_close(created);
+                break;
+            }
+
+            int status = pcap_activate(created);
+            if (status >= 0) {
+                settings = CaptureSettings();
+                settings.profile = profile.name;
+                settings.snaplen = pcap_snapshot(created);
+                settings.bufferBytes = bufferSet ? bufferBytes : 0;
+                settings.immediate = immediateSet;
+                settings.timeoutMs = profile.timeoutMs;
+                settings.nanosecond = pcap_get_tstamp_precision(created) == PCAP_TSTAMP_PRECISION_NANO;
+                if (status > 0) {
+                    settings.warning = pcap_statustostr(status);
+                }
+                return created;
+            }
+            pcap_close(created);
+            if (!bufferSet) {
+                return nullptr;
+            }
+        }
+    }
+    return nullptr;
+}
+
+builderDevice::Builder& builderDevice::Builder::SetSnaplen(int snaplen) {
+    this->snaplen = snaplen;
+    return *this;
+}
+
+builderDevice::Builder& builderDevice::Builder::SetProfile(const CaptureProfile& profile) {
+    this->profile = profile;
     return *this;
 }
 
@@ -99,13 +212,43 @@ builderDevice::Builder& builderDevice::Builder::ListDevices() {
 }
 
 builderDevice::Builder& builderDevice::Builder::OpenFromFile(const std::string& filePath) {
-    handle = pcap_open_offline(filePath.c_str(), errbuf);
+    // Nanosecond savefiles keep their precision; microsecond ones are scaled
+    handle = pcap_open_offline_with_tstamp_precision(filePath.c_str(), PCAP_TSTAMP_PRECISION_NANO, errbuf);
     if (!handle) {
         throw std::runtime_error("Failed to open file: " + std::string(errbuf));
     }
     return *this;
 }
 
+builderDevice::Builder& builderDevice::Builder::SetFilter(const std::string& expression) {
+    
+    if (!handle) {
+        throw std::logic_error("No open handle. Call OpenSelectedDevice() or OpenFromFile() first.");
+    }
+
+    // Netmask of the selected device, needed for "ip broadcast" style filters
+    bpf_u_int32 netmask = PCAP_NETMASK_UNKNOWN;
+    if (selectedDev) {
+        for (pcap_addr_t* addr = selectedDev->addresses; addr; addr = addr->next) {
+            if (addr->addr && addr->netmask && addr->addr->sa_family == AF_INET) {
+                netmask = reinterpret_cast<struct sockaddr_in*>(addr->netmask)->sin_addr.s_addr;
+                break;
+            }
+        }
+    }
+
+    struct bpf_program program;
+    if (pcap_compile(handle, &program, expression.c_str(), 1, netmask) == -1) {
+        throw std::runtime_error("Failed to compile filter: " + std::string(pcap_geterr(handle)));
+    }
+    if (pcap_setfilter(handle, &program) == -1) {
+        pcap_freecode(&program);
+        throw std::runtime_error("Failed to set filter: " + std::string(pcap_geterr(handle)));
+    }
+    pcap_freecode(&program);
+    return *this;
+}
+
 builderDevice builderDevice::Builder::Build() {
     return builderDevice(*this);
 }
@@ -118,6 +261,10 @@ const std::vector<std::string>& builderDevice::getDevices() const {
     return list;
 }
 
+const CaptureSettings& builderDevice::getSettings() const {
+    return settings;
+}
+
 builderDevice::builderDevice(const Builder& builder)
-    : inum(builder.inum), adhandle(builder.handle), list(builder.deviceList) {
+    : inum(builder.inum), adhandle(builder.handle), list(builder.deviceList), settings(builder.settings) {
 }
@@ -14,6 +14,31 @@
 #endif
 extern char errbuf[PCAP_ERRBUF_SIZE];
 
+// CAPTURE PROFILE - Kernel buffering versus delivery latency for a live device
+struct CaptureProfile {
+    std::string name;
+    int bufferBytes = 0;      // Kernel capture buffer; 0 keeps the driver default
+    bool immediate = false;   // Hand each packet up as soon as it arrives
+    int timeoutMs = 1000;     // Longest a partly filled buffer waits for a read
+
+    static CaptureProfile Latency();
+    static CaptureProfile Balanced();
+    static CaptureProfile Throughput();
+    // "latency", "balanced" or "throughput"
+    static CaptureProfile FromName(const std::string& name);
+};
+
+// Settings the opened handle actually runs with
+struct CaptureSettings {
+    std::string profile;
+    int snaplen = 0;
+    int bufferBytes = 0;      // 0 when the driver default was kept
+    bool immediate = false;
+    int timeoutMs = 0;
+    bool nanosecond = false;
+    std::string warning;      // pcap_activate warning, if any
+};
+
 class builderDevice {
 public:
     class Builder {
@@ -25,13 +50,24 @@ public:
         Builder& SelectDevice();
         Builder& OpenSelectedDevice();
         Builder& ListDevices();
+        // Bytes kept per packet by the driver; set before OpenSelectedDevice
+        Builder& SetSnaplen(int snaplen);
+        // Kernel buffer and delivery tuning; set before OpenSelectedDevice
+        Builder& SetProfile(const CaptureProfile& profile);
         Builder& OpenFromFile(const std::string& filePath);
+        // Installs a kernel BPF filter on the opened device or file
+        Builder& SetFilter(const std::string& expression);
 
         builderDevice Build();
 
     private:
+        pcap_t* CreateAndActivate(const char* sourceName);
+
         int inum;
         int deviceCount;
+        int snaplen;
+        CaptureProfile profile;
+        CaptureSettings settings;
         pcap_if_t* alldevs;
         pcap_if_t* selectedDev;
         pcap_t* handle;
@@ -42,6 +78,7 @@ public:
 
     pcap_t* getHandler() const;
     const std::vector<std::string>& getDevices() const;
+    const CaptureSettings& getSettings() const;
 
 private:
     builderDevice(const Builder& builder);
@@ -49,6 +86,7 @@ private:
     int inum;
     pcap_t* adhandle;
     std::vector<std::string> list;
+    CaptureSettings settings;
 };
 
 #endif
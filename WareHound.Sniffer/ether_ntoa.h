@@ -7,8 +7,19 @@
 #define ETHERTYPE_IP		0x0800	
 #endif
 
+// Same text as the snprintf form below, without parsing a format per call
 inline int ether_ntoa(const unsigned char etheraddr[ETHER_ADDR_LEN], char* dest, size_t len)
 {
+	static const char hex[] = "0123456789abcdef";
+	if (len >= 3 * ETHER_ADDR_LEN) {
+		for (int i = 0; i < ETHER_ADDR_LEN; i++) {
+			dest[3 * i] = hex[etheraddr[i] >> 4];
+			dest[3 * i + 1] = hex[etheraddr[i] & 0x0F];
+			dest[3 * i + 2] = ':';
+		}
+		dest[3 * ETHER_ADDR_LEN - 1] = '\0';
+		return 3 * ETHER_ADDR_LEN - 1;
+	}
 	return snprintf(dest, len, "%02x:%02x:%02x:%02x:%02x:%02x",
 		(unsigned)etheraddr[0],
 		(unsigned)etheraddr[1],
@@ -46,6 +46,7 @@ std::atomic<int> d1;
 std::mutex m;
 std::condition_variable cv;
 pcap_t* _adhandle1 = nullptr;
+CaptureSettings _captureSettings1;
 HANDLE hPipe = INVALID_HANDLE_VALUE;
 
 static std::jthread mainThread;
@@ -153,11 +154,12 @@ IPC_EXPORT void __stdcall fnPutdevCPPDLL(int dev) {
     if (quit_flag) quit_flag = false;
     std::this_thread::sleep_for(std::chrono::milliseconds(20));
     try {
-        _adhandle1 = builder.FindDevices()
+        builderDevice device = builder.FindDevices()
             .SelectDevice()
             .OpenSelectedDevice()
-            .Build()
-            .getHandler();
+            .Build();
+        _adhandle1 = device.getHandler();
+        _captureSettings1 = device.getSettings();
     } catch (const std::exception& e) {
         _adhandle1 = nullptr;
     }
@@ -229,6 +231,7 @@ std::atomic<int> d1;
 std::mutex m;
 std::condition_variable cv;
 pcap_t* _adhandle1 = nullptr;
+CaptureSettings _captureSettings1;
 
 IPC_EXPORT void fnDevCPPDLL(char** data, int* sizes, int* count) {
     std::vector<std::string> listdev = builderDevice::Builder(0).ListDevices().Build().getDevices();
@@ -237,7 +240,7 @@ IPC_EXPORT void fnDevCPPDLL(char** data, int* sizes, int* count) {
         for (int i = 0; i < *count; ++i) {
             sizes[i] = static_cast<int>(listdev[i].size());
             data[i] = new char[sizes[i] + 1];
-            strcpy_s(data[i], sizes[i] + 1, listdev[i].c_str());
+            std::memcpy(data[i], listdev[i].c_str(), sizes[i] + 1);
         }
     }
 }
@@ -257,7 +260,9 @@ IPC_EXPORT void fnPutdevCPPDLL(int dev) {
     builderDevice::Builder builder(dev);
     if (quit_flag) quit_flag = false;
     std::this_thread::sleep_for(std::chrono::milliseconds(20));
-    _adhandle1 = builder.FindDevices().SelectDevice().OpenSelectedDevice().Build().getHandler();
+    builderDevice device = builder.FindDevices().SelectDevice().OpenSelectedDevice().Build();
+    _adhandle1 = device.getHandler();
+    _captureSettings1 = device.getSettings();
     {
         std::unique_lock<std::mutex> lock(m);
         quit_flag = true;
@@ -8,6 +8,7 @@
 #endif
 
 #include <pcap.h>
+#include "builderDevice.h"
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
@@ -18,6 +19,7 @@ extern std::atomic<int> d1;
 extern std::mutex m;
 extern std::condition_variable cv;
 extern pcap_t* _adhandle1;
+extern CaptureSettings _captureSettings1;
 #ifdef _WIN32
 extern HANDLE hPipe;
 #endif
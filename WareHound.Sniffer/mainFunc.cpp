@@ -59,6 +59,7 @@ int mainFunc(HANDLE eventHandle, int deviceIndex) {
     auto sniffer = SnifferBuilder()
         .UseDevice(0) // Use 0 to skip internal opening and use global _adhandle1
         .SetEventHandle(eventHandle)
+        .SetBackpressure(BackpressurePolicy::DropOldest) // a slow pipe reader must not stall capture
         .AddSubscriber(std::make_shared<PipeWriterSubscriber>())
         .Build();
 
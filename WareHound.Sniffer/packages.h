@@ -101,7 +101,6 @@ public:
 	Packages(handleProto p);
 	~Packages();
 	void* producer(std::atomic<bool>& on);
-	void* consumer();
 	void setHandler(HANDLE eventHandle);
 	void addToStruct(char proto[22], char packet_srcip[22], char packet_dstip[22], char source_mac[32], char dest_mac[32], int packet_id, int dst_port, int src_port,char host_names[22],tagSnapshot& item);
 	void defaultToStruct(tagSnapshot& item);
@@ -148,36 +147,6 @@ inline void Packages::setHandler(HANDLE eventHandle) {
 	_eventHandles = eventHandle;
 }
 
-inline void* Packages::consumer() {
-	tagSnapshot consumed_item{};
-	tagSnapshot snapshot;
-
-	while (true) {
-		while (free_index == full_index) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
-		}
-		mtx.lock();
-
-		while (free_index != full_index)
-		{
-			consumed_item = shared_buff[full_index];
-			full_index = (full_index + 1) mod buff_max;
-			snapshot = consumed_item;
-#ifdef _WIN32
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
-			WriteFile(hPipe, &snapshot, sizeof(tagSnapshot), NULL, NULL);
-#endif
-		}
-		mtx.unlock();
-
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
-	}
-#ifdef _WIN32
-	CloseHandle(hPipe);
-#endif
-	return nullptr;
-}
-
 inline void* Packages::producer(std::atomic<bool>& on) {
 
 	int link_hdr_length = 0;
@@ -90,7 +90,31 @@ struct icmp {
 #include <netinet/ip_icmp.h>
 #endif
 
+#include <cstddef>
+#include <cstdint>
+
 #pragma pack(push, 2)
+// IPC header: what goes over the pipe, followed by capture_len raw bytes
+typedef struct tagSnapshotHeader {
+    int id;
+    int source_port;
+    int dest_port;
+    char proto[22];
+    char source_ip[22];
+    char dest_ip[22];
+    char source_mac[22];
+    char dest_mac[22];
+    char host_name[22];
+    uint32_t capture_len;      
+    uint32_t original_len;   
+    uint64_t timestamp_sec;    
+    uint32_t timestamp_usec;   
+    uint64_t timestamp_ns;     // full timestamp, nanoseconds since the epoch
+    
+} SnapshotHeader;
+
+// Pipeline record stored in PacketBuffer slots. Starts with the same fields
+// as SnapshotHeader; the frame bytes live in the PacketBuffer arena.
 typedef struct tagSnapshot {
     int id;
     int source_port;
@@ -105,11 +129,29 @@ typedef struct tagSnapshot {
     uint32_t original_len;     
     uint64_t timestamp_sec;    
     uint32_t timestamp_usec;  
-    uint8_t raw_data[65536];   
-} Snapshot;
+    uint64_t timestamp_ns;     
+    uint32_t raw_offset;       // arena offset of capture_len frame bytes
+    const uint8_t* raw_data;   // arena + raw_offset, valid while the slot is borrowed
+    uint32_t kind;             // SnapshotKind
+} tagSnapshot;
 
+enum SnapshotKind : uint32_t {
+    SNAPSHOT_PACKET = 0,
+    SNAPSHOT_HEARTBEAT = 1     // raw_data holds a Heartbeat, not a frame
+};
 
-typedef struct tagSnapshotHeader {
+// Capture liveness message; sent on its own while the link is idle.
+// Always shorter than SnapshotHeader so readers can tell them apart.
+#define HEARTBEAT_MAGIC 0x42484857u  // "WHHB"
+typedef struct tagHeartbeat {
+    uint32_t magic;
+    uint32_t sequence;
+    uint64_t timestamp_sec;
+    uint64_t packets_captured;
+} Heartbeat;
+
+// Flat record with inline frame bytes, used by the PCAP save/load exports
+typedef struct tagSnapshotRecord {
     int id;
     int source_port;
     int dest_port;
@@ -120,16 +162,24 @@ typedef struct tagSnapshotHeader {
     char dest_mac[22];
     char host_name[22];
     uint32_t capture_len;      
-    uint32_t original_len;   
+    uint32_t original_len;     
     uint64_t timestamp_sec;    
-    uint32_t timestamp_usec;   
-    
-} SnapshotHeader;
+    uint32_t timestamp_usec;  
+    uint64_t timestamp_ns;     // 0 when only microseconds are known
+    uint8_t raw_data[65536];   
+} Snapshot;
 
 
 inline size_t GetSnapshotIPCSize(const Snapshot* snap) {
     return sizeof(SnapshotHeader) + snap->capture_len;
 }
+
+inline size_t GetSnapshotIPCSize(const tagSnapshot* snap) {
+    return sizeof(SnapshotHeader) + snap->capture_len;
+}
 #pragma pack(pop)
 
+static_assert(offsetof(tagSnapshot, raw_offset) == sizeof(SnapshotHeader),
+              "tagSnapshot must start with the SnapshotHeader layout");
+
 #endif // STRUCT_H
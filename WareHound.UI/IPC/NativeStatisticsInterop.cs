@@ -42,6 +42,39 @@ public struct NativeCaptureStatistics
     public int UniqueProtocols;
     public int UniqueSourceIPs;
     public int UniqueDestIPs;
+
+    // Pipeline backpressure
+    public ulong DroppedBufferFull;
+    public ulong DroppedOldest;
+    public ulong DroppedSampled;
+    public ulong ProducerStalls;
+    public ulong BufferedPackets;
+    public double BufferOccupancyPercent;
+    public double BufferHighWaterPercent;
+
+    // Kernel filter
+    public ulong KernelReceived;
+    public ulong KernelDropped;
+    public ulong FilteredPackets;
+    public ulong FilterSwaps;
+
+    // Capture profile
+    [MarshalAs(UnmanagedType.ByValTStr, SizeConst = 16)]
+    public string CaptureProfile;
+    public int KernelBufferBytes;
+    public int ReadTimeoutMs;
+    public int ImmediateMode;
+
+    // IP fragment reassembly
+    public ulong DatagramsReassembled;
+    public ulong FragmentsTimedOut;
+    public ulong FragmentsEvicted;
+    public ulong FragmentsDropped;
+
+    // Flow table removals
+    public ulong FlowsExpired;
+    public ulong FlowsEvicted;
+    public ulong FlowsRejected;
 }
 
 public interface INativeStatisticsInterop
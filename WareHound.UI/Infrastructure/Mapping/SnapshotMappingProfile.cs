@@ -33,6 +33,7 @@ namespace WareHound.UI.Infrastructure.Mapping
                 .ForMember(dest => dest.OriginalLen, opt => opt.Ignore())
                 .ForMember(dest => dest.TimestampSec, opt => opt.Ignore())
                 .ForMember(dest => dest.TimestampUsec, opt => opt.Ignore())
+                .ForMember(dest => dest.TimestampNs, opt => opt.Ignore())
                 .ForMember(dest => dest.RawData, opt => opt.Ignore());
         }
     }
@@ -56,7 +56,13 @@ public class PacketInfo : INotifyPropertyChanged
     public static PacketInfo FromSnapshot(SnapshotStruct snapshot, int number)
     {
         DateTime captureTime;
-        if (snapshot.TimestampSec > 0)
+        if (snapshot.TimestampNs > 0)
+        {
+            captureTime = DateTimeOffset.FromUnixTimeSeconds((long)(snapshot.TimestampNs / 1_000_000_000))
+                .AddTicks((long)(snapshot.TimestampNs % 1_000_000_000 / 100)) // Nanoseconds to ticks
+                .LocalDateTime;
+        }
+        else if (snapshot.TimestampSec > 0)
         {
             captureTime = DateTimeOffset.FromUnixTimeSeconds((long)snapshot.TimestampSec)
                 .AddTicks(snapshot.TimestampUsec * 10) // Microseconds to ticks
@@ -110,6 +116,8 @@ public class PacketInfo : INotifyPropertyChanged
             OriginalLen = OriginalLen,
             TimestampSec = (ulong)new DateTimeOffset(CaptureTime).ToUnixTimeSeconds(),
             TimestampUsec = (uint)(CaptureTime.Ticks % TimeSpan.TicksPerSecond / 10),
+            TimestampNs = (ulong)new DateTimeOffset(CaptureTime).ToUnixTimeSeconds() * 1_000_000_000
+                          + (ulong)(CaptureTime.Ticks % TimeSpan.TicksPerSecond * 100),
             RawData = new byte[65536]
         };
         
@@ -24,6 +24,7 @@ namespace WareHound.UI.Models
         public uint OriginalLen;
         public ulong TimestampSec;
         public uint TimestampUsec;
+        public ulong TimestampNs;
         [MarshalAs(UnmanagedType.ByValArray, SizeConst = 65536)]
         public byte[] RawData;
     }
@@ -50,6 +51,7 @@ namespace WareHound.UI.Models
         public uint OriginalLen;     
         public ulong TimestampSec;   
         public uint TimestampUsec;  
+        public ulong TimestampNs;   // Nanoseconds since the epoch
    
         public SnapshotStruct ToSnapshot(byte[]? rawData)
         {
@@ -68,9 +70,22 @@ namespace WareHound.UI.Models
                 OriginalLen = OriginalLen,
                 TimestampSec = TimestampSec,
                 TimestampUsec = TimestampUsec,
+                TimestampNs = TimestampNs,
                 RawData = rawData ?? Array.Empty<byte>()
             };
         }
         public int GetTotalIPCSize() => Marshal.SizeOf<SnapshotHeader>() + (int)CaptureLen;
     }
+
+    // Capture liveness message, shorter than SnapshotHeader
+    [StructLayout(LayoutKind.Sequential, Pack = 2)]
+    public struct HeartbeatMessage
+    {
+        public const uint ExpectedMagic = 0x42484857; // "WHHB"
+
+        public uint Magic;
+        public uint Sequence;
+        public ulong TimestampSec;
+        public ulong PacketsCaptured;
+    }
 }
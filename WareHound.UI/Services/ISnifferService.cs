@@ -11,6 +11,7 @@ namespace WareHound.UI.Services
         bool IsCapturing { get; }
         int SelectedDeviceIndex { get; }
         bool IsLoadingDevices { get; }
+        DateTime? LastHeartbeat { get; }
         void LoadDevices();
         Task LoadDevicesAsync(CancellationToken cancellationToken = default);
         Task LoadDevicesAsync(TimeSpan timeout);
@@ -29,7 +29,8 @@ namespace WareHound.UI.Services
         private const string EventName = "Global\\sniffer";
         private const int PipeConnectionTimeoutMs = 5000;
         private const int PipeServerStartDelayMs = 500;
-        private const int DummyPacketId = 1000;
+        private const int MaxCaptureLen = 65536;
+        private const int MaxMessageBytes = 256 * 1024;
         private const int ChannelCapacity = 10000;
 
         private SafeWaitHandle? _eventHandle;
@@ -38,6 +39,7 @@ namespace WareHound.UI.Services
         private CancellationTokenSource? _cts;
         private volatile bool _isCapturing;
         private int _packetNumber;
+        private DateTime? _lastHeartbeat;
         private bool _disposed;
         private int _selectedDeviceIndex = 1;
         
@@ -48,6 +50,7 @@ namespace WareHound.UI.Services
         public bool IsCapturing => _isCapturing;
         public int SelectedDeviceIndex => _selectedDeviceIndex;
         public bool IsLoadingDevices => _isLoadingDevices;
+        public DateTime? LastHeartbeat => _lastHeartbeat;
 
         public event Action<string>? ErrorOccurred;
         public event Action? DevicesLoaded;
@@ -289,6 +292,7 @@ namespace WareHound.UI.Services
 
             _pipeClient = new NamedPipeClientStream(".", PipeName, PipeDirection.InOut);
             _pipeClient.Connect(PipeConnectionTimeoutMs);
+            _pipeClient.ReadMode = PipeTransmissionMode.Message;
 
             // Signal event to start capture
             SetEvent(_eventHandle);
@@ -327,10 +331,13 @@ namespace WareHound.UI.Services
 
         private void PipeReaderLoop()
         {
-            int structSize = Marshal.SizeOf<SnapshotStruct>();
-            byte[] buffer = new byte[structSize];
+            // Each message is one or more records of SnapshotHeader followed by
+            // CaptureLen raw bytes, or a shorter HeartbeatMessage while idle
+            int headerSize = Marshal.SizeOf<SnapshotHeader>();
+            int heartbeatSize = Marshal.SizeOf<HeartbeatMessage>();
+            byte[] buffer = new byte[Math.Max(MaxMessageBytes, headerSize + MaxCaptureLen)];
             
-            _logger.LogDebug($"PipeReaderLoop started, struct size = {structSize}");
+            _logger.LogDebug($"PipeReaderLoop started, header size = {headerSize}");
 
             while (_isCapturing && !(_cts?.IsCancellationRequested ?? true))
             {
@@ -342,15 +349,19 @@ namespace WareHound.UI.Services
                         break;
                     }
 
-                    int bytesRead = _pipeClient.Read(buffer, 0, structSize);
+                    int bytesRead = ReadMessage(_pipeClient, ref buffer);
 
-                    if (bytesRead == structSize)
+                    if (bytesRead >= headerSize)
                     {
-                        ProcessPacketBuffer(buffer);
+                        ProcessPacketMessage(buffer, bytesRead, headerSize);
+                    }
+                    else if (bytesRead == heartbeatSize)
+                    {
+                        ProcessHeartbeat(buffer);
                     }
                     else if (bytesRead > 0)
                     {
-                        _logger.LogDebug($"Incomplete read: {bytesRead} of {structSize} bytes");
+                        _logger.LogDebug($"Incomplete read: {bytesRead} of {headerSize} header bytes");
                     }
                 }
                 catch (Exception ex)
@@ -362,25 +373,49 @@ namespace WareHound.UI.Services
 
             _logger.LogDebug("PipeReaderLoop ended");
         }
+
+        private static int ReadMessage(NamedPipeClientStream pipe, ref byte[] buffer)
+        {
+            int total = 0;
+            while (true)
+            {
+                int read = pipe.Read(buffer, total, buffer.Length - total);
+                if (read == 0)
+                    break;
+                total += read;
+                if (pipe.IsMessageComplete)
+                    break;
+                if (total == buffer.Length)
+                    Array.Resize(ref buffer, buffer.Length * 2);
+            }
+            return total;
+        }
         
-        private void ProcessPacketBuffer(byte[] buffer)
+        private void ProcessPacketMessage(byte[] buffer, int length, int headerSize)
         {
             GCHandle handle = GCHandle.Alloc(buffer, GCHandleType.Pinned);
             try
             {
-                var snapshot = Marshal.PtrToStructure<SnapshotStruct>(handle.AddrOfPinnedObject());
-
-                if (snapshot.Id == DummyPacketId)
-                    return;
-
-                _packetNumber++;
-                var packet = PacketInfo.FromSnapshot(snapshot, _packetNumber);
-                
-                var written = _packetChannel?.Writer.TryWrite(packet) ?? false;
-                
-                if (_packetNumber <= 5 || _packetNumber % 100 == 0)
+                int offset = 0;
+                while (length - offset >= headerSize)
                 {
-                    _logger.LogDebug($"Packet #{_packetNumber} written to channel: {written}");
+                    var header = Marshal.PtrToStructure<SnapshotHeader>(handle.AddrOfPinnedObject() + offset);
+
+                    int rawLen = (int)Math.Min(header.CaptureLen, (uint)(length - offset - headerSize));
+                    var rawData = new byte[rawLen];
+                    Buffer.BlockCopy(buffer, offset + headerSize, rawData, 0, rawLen);
+                    header.CaptureLen = (uint)rawLen;
+                    offset += headerSize + rawLen;
+
+                    _packetNumber++;
+                    var packet = PacketInfo.FromSnapshot(header.ToSnapshot(rawData), _packetNumber);
+                    
+                    var written = _packetChannel?.Writer.TryWrite(packet) ?? false;
+                    
+                    if (_packetNumber <= 5 || _packetNumber % 100 == 0)
+                    {
+                        _logger.LogDebug($"Packet #{_packetNumber} written to channel: {written}");
+                    }
                 }
             }
             finally
@@ -389,6 +424,19 @@ namespace WareHound.UI.Services
             }
         }
 
+        private void ProcessHeartbeat(byte[] buffer)
+        {
+            var heartbeat = MemoryMarshal.Read<HeartbeatMessage>(buffer);
+            if (heartbeat.Magic != HeartbeatMessage.ExpectedMagic)
+                return;
+
+            _lastHeartbeat = DateTime.Now;
+            if (heartbeat.Sequence <= 1 || heartbeat.Sequence % 60 == 0)
+            {
+                _logger.LogDebug($"Heartbeat #{heartbeat.Sequence}, {heartbeat.PacketsCaptured} packets captured");
+            }
+        }
+
         public async IAsyncEnumerable<IList<PacketInfo>> GetPacketBatchesAsync(
             [EnumeratorCancellation] CancellationToken ct = default)
         {